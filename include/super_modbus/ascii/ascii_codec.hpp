@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include "../rtu/rtu_request.hpp"
+#include "../rtu/rtu_response.hpp"
+
+namespace supermb {
+
+// Modbus ASCII framing (':' + hex(slave id, PDU, LRC) + CR LF) for the same requests and responses the RTU side
+// uses. Hex conversion runs 16 bytes per step with SSE2 where available and accumulates the LRC sum in the same pass.
+
+// Writes 2 * bytes.size() uppercase hex characters to out and returns the 8 bit sum of bytes
+uint8_t EncodeAsciiHex(std::span<uint8_t const> bytes, char *out) noexcept;
+
+// Decodes hex.size() / 2 bytes into out and returns their 8 bit sum, or nothing if hex has an odd length or a
+// non-hex character. Upper and lower case digits are accepted.
+std::optional<uint8_t> DecodeAsciiHex(std::string_view hex, uint8_t *out) noexcept;
+
+[[nodiscard]] std::string EncodeAsciiRequest(RtuRequest const &request);
+[[nodiscard]] std::string EncodeAsciiResponse(RtuResponse const &response);
+
+// Frames with a bad start/end marker, bad hex or a failed LRC check decode to nothing
+[[nodiscard]] std::optional<RtuRequest> DecodeAsciiRequest(std::string_view frame,
+                                                           RtuRequest::allocator_type allocator = {});
+[[nodiscard]] std::optional<RtuResponse> DecodeAsciiResponse(std::string_view frame,
+                                                             RtuResponse::allocator_type allocator = {});
+
+}  // namespace supermb
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <stop_token>
+#include <vector>
+#include "../rtu/rtu_request.hpp"
+#include "../rtu/rtu_response.hpp"
+#include "event_loop.hpp"
+#include "task.hpp"
+
+namespace supermb {
+
+enum class TransactionStatus : uint8_t {
+  kOk,
+  kTimeout,
+  kCancelled,
+  kIoError,
+  // Bad CRC, wrong slave or function code, or an oversized frame
+  kInvalidResponse
+};
+
+struct TransactionResult {
+  TransactionStatus status{TransactionStatus::kIoError};
+  // Set with kOk, except for broadcasts (slave id 0), which get no response
+  std::optional<RtuResponse> response{};
+};
+
+// Modbus RTU master on a non-blocking descriptor (serial port, pty or any byte stream), driven by an EventLoop:
+//
+//   Task<void> Poll(AsyncRtuMaster &master) {
+//     RtuRequest request{{7, FunctionCode::kReadHR}};
+//     request.SetAddressSpan({0, 10});
+//     TransactionResult const result = co_await master.Transact(request, 100ms);
+//     ...
+//   }
+//
+// The bus is half duplex, so concurrent transactions queue up in call order and go out one at a time; any number of
+// device conversations can share a master without a thread each. The timeout covers the response only. A stop
+// request cancels a transaction waiting for its response at once and a queued one when its turn comes.
+class AsyncRtuMaster {
+ public:
+  // fd is not owned and must be in non-blocking mode
+  AsyncRtuMaster(EventLoop &loop, int fd)
+      : loop_(loop),
+        fd_(fd) {}
+  AsyncRtuMaster(AsyncRtuMaster const &) = delete;
+  AsyncRtuMaster &operator=(AsyncRtuMaster const &) = delete;
+  AsyncRtuMaster(AsyncRtuMaster &&) = delete;
+  AsyncRtuMaster &operator=(AsyncRtuMaster &&) = delete;
+  ~AsyncRtuMaster() = default;
+
+  Task<TransactionResult> Transact(RtuRequest request, std::chrono::milliseconds timeout, std::stop_token stop = {});
+
+ private:
+  class LineAwaiter {
+   public:
+    explicit LineAwaiter(AsyncRtuMaster &master)
+        : master_(master) {}
+
+    [[nodiscard]] bool await_ready() const noexcept { return !master_.line_busy_; }
+    void await_suspend(std::coroutine_handle<> handle) { master_.line_waiters_.push_back(handle); }
+    void await_resume() const noexcept { master_.line_busy_ = true; }
+
+   private:
+    AsyncRtuMaster &master_;
+  };
+
+  // Hands the line to the next queued transaction
+  class LineLease {
+   public:
+    explicit LineLease(AsyncRtuMaster &master)
+        : master_(master) {}
+    LineLease(LineLease const &) = delete;
+    LineLease &operator=(LineLease const &) = delete;
+    ~LineLease() { master_.ReleaseLine(); }
+
+   private:
+    AsyncRtuMaster &master_;
+  };
+
+  Task<TransactionResult> Exchange(RtuRequest const &request, std::chrono::milliseconds timeout,
+                                   std::stop_token const &stop);
+  void ReleaseLine();
+  // Writes what fits without blocking, advancing written; false on error
+  bool WriteAvailable(size_t &written);
+  // Appends what can be read without blocking; false on error or end of stream
+  bool ReadAvailable();
+  [[nodiscard]] TransactionResult CheckResponse(RtuRequest const &request, size_t frame_size) const;
+
+  EventLoop &loop_;
+  int fd_;
+  bool line_busy_{false};
+  std::deque<std::coroutine_handle<>> line_waiters_{};
+  // Only touched by the transaction holding the line
+  std::vector<uint8_t> transmit_buffer_{};
+  std::vector<uint8_t> receive_buffer_{};
+};
+
+}  // namespace supermb
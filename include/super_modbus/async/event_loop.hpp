@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <utility>
+#include <vector>
+#include "task.hpp"
+
+namespace supermb {
+
+enum class WaitResult : uint8_t {
+  kReady,
+  kTimeout,
+  kCancelled,
+  // The descriptor could not be watched, for instance because another coroutine already waits on it
+  kError
+};
+
+// Single-threaded epoll event loop driving coroutines. Coroutines suspend on descriptor readiness, timeouts and
+// cancellation (std::stop_token); all state of a suspended wait lives in the awaiting coroutine's frame, so the loop
+// itself allocates nothing per wait beyond its queues' amortized growth.
+//
+// Everything except Stop and the cancellation of a stop_token must happen on the thread calling Run.
+class EventLoop {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  class WaitAwaiter;
+
+  EventLoop();
+  EventLoop(EventLoop const &) = delete;
+  EventLoop &operator=(EventLoop const &) = delete;
+  EventLoop(EventLoop &&) = delete;
+  EventLoop &operator=(EventLoop &&) = delete;
+  ~EventLoop();
+
+  [[nodiscard]] bool IsValid() const noexcept { return epoll_fd_ >= 0 && wake_fd_ >= 0; }
+
+  // Starts task right away; the loop keeps it alive until it finishes. Tasks still suspended when the loop is
+  // destroyed are leaked, so let Run return first.
+  void Spawn(Task<void> task);
+
+  // Runs until every spawned task has finished or Stop is called
+  void Run();
+  // May be called from any thread
+  void Stop();
+
+  // Suspends until fd is readable (or writable), the timeout expires or stop is requested. One coroutine at a time
+  // may wait on a given descriptor.
+  [[nodiscard]] WaitAwaiter Readable(int fd, Clock::duration timeout, std::stop_token stop = {});
+  [[nodiscard]] WaitAwaiter Writable(int fd, Clock::duration timeout, std::stop_token stop = {});
+  // Completes with kTimeout, or kCancelled if stop is requested first
+  [[nodiscard]] WaitAwaiter Sleep(Clock::duration duration, std::stop_token stop = {});
+
+  // Resumes handle from the loop on its next iteration
+  void Schedule(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+ private:
+  struct Waiter;
+
+  struct CancelRequest {
+    Waiter *waiter;
+    void operator()() const noexcept;
+  };
+
+  struct Waiter {
+    EventLoop *loop{nullptr};
+    std::coroutine_handle<> handle{};
+    int fd{-1};
+    uint32_t events{0};
+    Clock::time_point deadline{Clock::time_point::max()};
+    size_t timer_index{kNoTimer};
+    WaitResult result{WaitResult::kReady};
+    bool done{false};
+    std::stop_token stop{};
+    std::optional<std::stop_callback<CancelRequest>> stop_callback{};
+  };
+
+  static constexpr size_t kNoTimer{static_cast<size_t>(-1)};
+
+  WaitAwaiter Wait(int fd, uint32_t events, Clock::duration timeout, std::stop_token stop);
+  void Register(Waiter &waiter);
+  void Complete(Waiter &waiter, WaitResult result);
+  void DrainCancellations();
+  void ExpireTimers();
+  [[nodiscard]] int GetEpollTimeout() const;
+  void PushTimer(Waiter &waiter);
+  void RemoveTimer(Waiter &waiter);
+  void SwapTimers(size_t lhs, size_t rhs);
+  void SiftTimerUp(size_t index);
+  void SiftTimerDown(size_t index);
+
+  int epoll_fd_{-1};
+  // eventfd waking epoll_wait for Stop and cross-thread cancellation
+  int wake_fd_{-1};
+  size_t live_tasks_{0};
+  std::deque<std::coroutine_handle<>> ready_{};
+  // Min-heap on deadline; each waiter knows its index
+  std::vector<Waiter *> timers_{};
+  std::mutex cancel_mutex_{};
+  std::vector<Waiter *> cancelled_{};
+  std::atomic<bool> stop_requested_{false};
+
+ public:
+  class WaitAwaiter {
+   public:
+    [[nodiscard]] bool await_ready() const noexcept { return waiter_.stop.stop_requested(); }
+    void await_suspend(std::coroutine_handle<> handle) {
+      waiter_.handle = handle;
+      waiter_.loop->Register(waiter_);
+    }
+    [[nodiscard]] WaitResult await_resume() const noexcept {
+      return waiter_.handle ? waiter_.result : WaitResult::kCancelled;
+    }
+
+   private:
+    friend class EventLoop;
+    WaitAwaiter(EventLoop &loop, int fd, uint32_t events, Clock::time_point deadline, std::stop_token stop) {
+      waiter_.loop = &loop;
+      waiter_.fd = fd;
+      waiter_.events = events;
+      waiter_.deadline = deadline;
+      waiter_.stop = std::move(stop);
+    }
+
+    Waiter waiter_{};
+  };
+};
+
+}  // namespace supermb
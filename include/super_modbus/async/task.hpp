@@ -0,0 +1,89 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace supermb {
+
+// Lazily started coroutine returning T. A Task runs when it is co_awaited and resumes its awaiter when it finishes
+// (symmetric transfer, so long await chains do not grow the stack). The frame is the only allocation per task.
+// Exceptions are not propagated: the library does not throw, and one escaping a task terminates.
+template <typename T>
+class [[nodiscard]] Task {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter {
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+      auto const continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  struct PromiseBase {
+    std::coroutine_handle<> continuation{};
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+
+  struct promise_type : PromiseBase {
+    std::optional<T> value{};
+
+    Task get_return_object() noexcept { return Task{Handle::from_promise(*this)}; }
+    template <typename Value>
+    void return_value(Value &&result) {
+      value.emplace(std::forward<Value>(result));
+    }
+  };
+
+  Task(Task const &) = delete;
+  Task &operator=(Task const &) = delete;
+  Task(Task &&other) noexcept
+      : handle_(std::exchange(other.handle_, {})) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~Task() { Reset(); }
+
+  [[nodiscard]] bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  T await_resume() { return std::move(handle_.promise().value.value()); }
+
+ private:
+  explicit Task(Handle handle)
+      : handle_(handle) {}
+
+  void Reset() noexcept {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+  Handle handle_{};
+};
+
+template <>
+struct Task<void>::promise_type : Task<void>::PromiseBase {
+  Task get_return_object() noexcept { return Task{Handle::from_promise(*this)}; }
+  void return_void() const noexcept {}
+};
+
+template <>
+inline void Task<void>::await_resume() {}
+
+}  // namespace supermb
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include "../common/spsc_ring.hpp"
+#include "../rtu/rtu_slave.hpp"
+#include "../tcp/mbap.hpp"
+
+namespace supermb {
+
+// Capture file layout (all integers little-endian):
+//
+//   header:  "SMBCAP" | version (1) | framing (1) | wall clock start, ns since epoch (8)
+//   record:  timestamp delta to the previous record, ns (LEB128) | direction (1) | port (1) | size (LEB128) | ADU
+//
+// A typical RTU record costs five bytes on top of the ADU itself.
+static constexpr size_t kCaptureHeaderSize{16};
+static constexpr uint8_t kCaptureVersion{1};
+static constexpr size_t kMaxCaptureAduSize{kMaxMbapFrameSize};
+
+enum class CaptureFraming : uint8_t {
+  kRtu = 0,
+  kMbap = 1
+};
+
+// Seen from the capture point, normally the slave or server: requests are received, responses are sent
+enum class CaptureDirection : uint8_t {
+  kReceived = 0,
+  kSent = 1
+};
+
+struct CaptureRecord {
+  // Since the start of the capture
+  std::chrono::nanoseconds timestamp{0};
+  CaptureDirection direction{CaptureDirection::kReceived};
+  uint8_t port{0};
+  uint16_t size{0};
+  std::array<uint8_t, kMaxCaptureAduSize> adu{};
+
+  [[nodiscard]] std::span<uint8_t const> GetAdu() const noexcept { return std::span{adu}.first(size); }
+};
+
+// Writes a capture file from an I/O thread without blocking it. Record only copies the ADU into a lock-free ring;
+// a background thread encodes and writes the records. When the ring is full the record is dropped and counted
+// instead of stalling the caller. Record must always be called from the same thread.
+class CaptureWriter {
+ public:
+  static constexpr size_t kQueueDepth{1024};
+
+  CaptureWriter(std::string const &path, CaptureFraming framing);
+  CaptureWriter(CaptureWriter const &) = delete;
+  CaptureWriter &operator=(CaptureWriter const &) = delete;
+  CaptureWriter(CaptureWriter &&) = delete;
+  CaptureWriter &operator=(CaptureWriter &&) = delete;
+  ~CaptureWriter();
+
+  [[nodiscard]] bool IsOpen() const noexcept { return writer_.joinable(); }
+
+  // Returns false if the record was dropped. ADUs longer than kMaxCaptureAduSize are dropped as well.
+  bool Record(CaptureDirection direction, uint8_t port, std::span<uint8_t const> adu);
+
+  [[nodiscard]] uint64_t GetDroppedCount() const noexcept { return dropped_count_.load(std::memory_order_relaxed); }
+
+  // Writes out everything recorded so far and closes the file
+  void Close();
+
+ private:
+  void Run();
+
+  std::ofstream file_{};
+  std::chrono::steady_clock::time_point start_{};
+  SpscRing<CaptureRecord, kQueueDepth> records_{};
+  std::atomic<uint32_t> pending_signal_{0};
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> dropped_count_{0};
+  std::thread writer_{};
+};
+
+// Streams the records of a capture file in order
+class CaptureReader {
+ public:
+  [[nodiscard]] static std::optional<CaptureReader> Open(std::string const &path);
+
+  [[nodiscard]] CaptureFraming GetFraming() const noexcept { return framing_; }
+  [[nodiscard]] std::chrono::system_clock::time_point GetStartTime() const noexcept { return start_time_; }
+
+  // Nothing at the end of the file or at the first malformed record
+  [[nodiscard]] std::optional<CaptureRecord> Next();
+
+ private:
+  CaptureReader(std::ifstream file, CaptureFraming framing, std::chrono::system_clock::time_point start_time)
+      : file_(std::move(file)),
+        framing_(framing),
+        start_time_(start_time) {}
+
+  std::ifstream file_;
+  CaptureFraming framing_;
+  std::chrono::system_clock::time_point start_time_;
+  std::chrono::nanoseconds timestamp_{0};
+};
+
+using ReplaySink = std::function<void(CaptureRecord const &record)>;
+
+// Hands every remaining record of reader to sink, paced like the original traffic divided by speed (2.0 replays
+// twice as fast). A speed of 0 replays without waiting. Returns the number of records replayed.
+size_t Replay(CaptureReader &reader, double speed, ReplaySink const &sink);
+
+struct SlaveReplayResult {
+  size_t requests{0};
+  // Responses that differ from the captured ones
+  size_t mismatches{0};
+  size_t undecodable{0};
+};
+
+// Replays the received requests of a slave-side capture into slave. Each response is compared with the next
+// response captured on the same port.
+SlaveReplayResult ReplayIntoSlave(CaptureReader &reader, RtuSlave &slave, double speed);
+
+}  // namespace supermb
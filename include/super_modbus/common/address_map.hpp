@@ -1,50 +1,388 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
-#include <unordered_map>
+#include <span>
+#include <utility>
+#include <vector>
 #include "address_span.hpp"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace supermb {
 
+// Values of the 16-bit Modbus address space, stored in fixed-size pages allocated on first use. Each page keeps its
+// values contiguous next to a presence bitmap, so a whole span is validated with a few word operations and copied
+// without per-address lookups.
+//
+// Pages are copy-on-write. Copying a map (Snapshot) copies one pointer per page and no values; the first write to a
+// shared page copies that page only, so a snapshot stays a consistent point-in-time view while writes continue on
+// the original. Maps sharing pages may each be read and written from their own threads. Reads never lock. A write
+// takes the map's mutex only the first time it touches a page since the last copy, to unshare it; after that the
+// page is the map's own and writes to it are lock-free again.
 template <typename DataType>
 class AddressMap {
  public:
+  static constexpr size_t kAddressCount{0x10000};
+  static constexpr size_t kPageSize{256};
+
+  AddressMap() = default;
+
+  // Copies may be taken concurrently from several threads; only reference counts and ownership flags are written.
+  // Neither side owns the pages afterwards.
+  AddressMap(AddressMap const &other)
+      : slots_(other.slots_) {
+    other.DisownPages();
+  }
+
+  AddressMap &operator=(AddressMap const &other) {
+    if (this != &other) {
+      slots_ = std::vector<Slot>(other.slots_);
+      retired_.clear();
+      other.DisownPages();
+    }
+    return *this;
+  }
+
+  AddressMap(AddressMap &&other) noexcept
+      : slots_(std::move(other.slots_)),
+        retired_(std::move(other.retired_)) {}
+
+  AddressMap &operator=(AddressMap &&other) noexcept {
+    slots_ = std::move(other.slots_);
+    retired_ = std::move(other.retired_);
+    return *this;
+  }
+
+  ~AddressMap() = default;
+
+  // Point-in-time copy sharing every page with this map. The snapshot may be read from another thread while this
+  // map is written, since shared pages are never written in place. Taking it must not race with other accesses to
+  // this map; serialize it with them (RtuSlave does, through Process). It also frees the pages this map unshared
+  // since the last snapshot, which concurrent readers may have been using until then.
+  [[nodiscard]] AddressMap Snapshot() const {
+    retired_.clear();
+    return *this;
+  }
+
+  // Addresses beyond the address space are ignored
   void AddAddressSpan(AddressSpan span) {
-    for (uint16_t i = span.start_address; i < span.start_address + span.reg_count; ++i) {
-      if (!data_.contains(i)) {
-        data_[i] = DataType{};
+    retired_.clear();
+    ForEachChunk(ClampSpan(span), [this](size_t page_index, size_t offset, size_t count) {
+      if (page_index >= slots_.size()) {
+        slots_.resize(page_index + 1);
       }
-    }
+      Slot &slot = slots_[page_index];
+      if (!slot.owner) {
+        slot.owner = std::make_shared<Page>();
+        slot.page.store(slot.owner.get(), std::memory_order_relaxed);
+        slot.owned.store(true, std::memory_order_relaxed);
+      }
+      Page &page = GetMutablePage(page_index);
+      for (size_t i = offset; i < offset + count; ++i) {
+        if (!page.IsPresent(i)) {
+          page.values[i] = DataType{};
+          page.present[i / kWordBits] |= uint64_t{1} << (i % kWordBits);
+        }
+      }
+      return true;
+    });
   }
 
   void RemoveAddressSpan(AddressSpan span) {
-    for (uint16_t i = span.start_address; i < span.start_address + span.reg_count; ++i) {
-      data_.erase(i);
-    }
+    retired_.clear();
+    ForEachChunk(ClampSpan(span), [this](size_t page_index, size_t offset, size_t count) {
+      if (GetPage(page_index) == nullptr) {
+        return true;
+      }
+      Page &page = GetMutablePage(page_index);
+      for (size_t i = offset; i < offset + count; ++i) {
+        page.present[i / kWordBits] &= ~(uint64_t{1} << (i % kWordBits));
+      }
+      if (std::ranges::all_of(page.present, [](uint64_t word) { return word == 0; })) {
+        Slot &slot = slots_[page_index];
+        slot.page.store(nullptr, std::memory_order_relaxed);
+        slot.owned.store(false, std::memory_order_relaxed);
+        slot.owner.reset();
+      }
+      return true;
+    });
   }
 
+  // Values are accessed through std::atomic_ref so Set, MaskWrite, WriteRange and reads of existing addresses may
+  // run concurrently, snapshot or not. None of them lock, except a write that is the first to a page since the map
+  // was copied. Adding or removing spans changes the map itself and needs exclusive access.
   bool Set(int address, DataType value) {
-    auto const value_iter = data_.find(address);
-    if (value_iter != data_.end()) {
-      value_iter->second = value;
-      return true;
+    DataType *const slot = FindMutable(address);
+    if (slot == nullptr) {
+      return false;
     }
 
-    return false;
+    std::atomic_ref<DataType>{*slot}.store(value, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Applies (current AND and_mask) OR (or_mask AND NOT and_mask) as a compare-and-swap, so concurrent masked
+  // writes to the same address never lose each other's bits. Returns the value stored, which a later read may no
+  // longer see once other writers got in.
+  std::optional<DataType> MaskWrite(int address, DataType and_mask, DataType or_mask) {
+    DataType *const slot = FindMutable(address);
+    if (slot == nullptr) {
+      return {};
+    }
+
+    std::atomic_ref<DataType> value{*slot};
+    DataType current = value.load(std::memory_order_relaxed);
+    auto desired = static_cast<DataType>((current & and_mask) | (or_mask & ~and_mask));
+    while (!value.compare_exchange_weak(current, desired, std::memory_order_relaxed)) {
+      desired = static_cast<DataType>((current & and_mask) | (or_mask & ~and_mask));
+    }
+    return desired;
   }
 
   [[nodiscard]] std::optional<DataType> operator[](int address) const {
-    auto const value_iter = data_.find(address);
-    if (value_iter != data_.end()) {
-      return value_iter->second;
+    DataType *const slot = Find(address);
+    if (slot != nullptr) {
+      return std::atomic_ref<DataType>{*slot}.load(std::memory_order_relaxed);
     }
 
     return {};
   }
 
+  // True if every address of span exists
+  [[nodiscard]] bool Contains(AddressSpan span) const {
+    if (static_cast<size_t>(span.start_address) + span.reg_count > kAddressCount) {
+      return false;
+    }
+    return ForEachChunk(span, [this](size_t page_index, size_t offset, size_t count) {
+      Page const *const page = GetPage(page_index);
+      return page != nullptr && page->AllPresent(offset, count);
+    });
+  }
+
+  // Copies span into the front of out. Nothing is copied unless every address exists and out is large enough.
+  bool ReadRange(AddressSpan span, std::span<DataType> out) const {
+    if (out.size() < span.reg_count || !Contains(span)) {
+      return false;
+    }
+
+    auto out_iter = out.begin();
+    ForEachChunk(span, [this, &out_iter](size_t page_index, size_t offset, size_t count) {
+      Page *const page = GetPage(page_index);
+      for (size_t i = offset; i < offset + count; ++i) {
+        *out_iter++ = std::atomic_ref<DataType>{page->values[i]}.load(std::memory_order_relaxed);
+      }
+      return true;
+    });
+    return true;
+  }
+
+  // Writes the first span.reg_count values, or nothing unless every address exists and values is large enough
+  bool WriteRange(AddressSpan span, std::span<DataType const> values) {
+    if (values.size() < span.reg_count || !Contains(span)) {
+      return false;
+    }
+
+    auto value_iter = values.begin();
+    ForEachChunk(span, [this, &value_iter](size_t page_index, size_t offset, size_t count) {
+      Page &page = GetMutablePage(page_index);
+      for (size_t i = offset; i < offset + count; ++i) {
+        std::atomic_ref<DataType>{page.values[i]}.store(*value_iter++, std::memory_order_relaxed);
+      }
+      return true;
+    });
+    return true;
+  }
+
+  // Direct view of span's storage when every address exists and the span does not cross a page boundary, nothing
+  // otherwise. Reading through the view bypasses std::atomic_ref, so it must not race with writers.
+  [[nodiscard]] std::optional<std::span<DataType const>> GetContiguousView(AddressSpan span) const {
+    size_t const offset = span.start_address % kPageSize;
+    if (offset + span.reg_count > kPageSize || !Contains(span)) {
+      return {};
+    }
+    if (span.reg_count == 0) {
+      return std::span<DataType const>{};
+    }
+
+    return std::span<DataType const>{GetPage(span.start_address / kPageSize)->values}.subspan(offset, span.reg_count);
+  }
+
  private:
-  std::unordered_map<int, DataType> data_{};
+  static constexpr size_t kWordBits{64};
+  static constexpr size_t kPresentWords{kPageSize / kWordBits};
+  // Lets AllPresent load the bitmap with aligned vector loads
+  static constexpr size_t kPresentAlignment{32};
+
+  struct Page {
+    std::array<DataType, kPageSize> values{};
+    alignas(kPresentAlignment) std::array<uint64_t, kPresentWords> present{};
+
+    [[nodiscard]] bool IsPresent(size_t offset) const {
+      return (present[offset / kWordBits] >> (offset % kWordBits) & 1U) != 0;
+    }
+
+    // The span's bits of every bitmap word are tested together, with no early exit and no branch per word: one
+    // 256-bit test with AVX2, two 128-bit compares with SSE2. A span the slave has to reject costs no more than one it
+    // serves, which keeps masters that scan address ranges cheap to answer.
+    [[nodiscard]] bool AllPresent(size_t offset, size_t count) const {
+      alignas(kPresentAlignment) std::array<uint64_t, kPresentWords> span_bits;
+      for (size_t word = 0; word < kPresentWords; ++word) {
+        span_bits[word] = GetSpanWordMask(word, offset, offset + count);
+      }
+#if defined(__AVX2__)
+      static_assert(kPresentWords == 4);
+      auto const *const present_vector = reinterpret_cast<__m256i const *>(present.data());
+      auto const *const span_vector = reinterpret_cast<__m256i const *>(span_bits.data());
+      return _mm256_testc_si256(_mm256_load_si256(present_vector), _mm256_load_si256(span_vector)) != 0;
+#elif defined(__SSE2__)
+      __m128i missing = _mm_setzero_si128();
+      for (size_t word = 0; word < kPresentWords; word += 2) {
+        auto const *const present_vector = reinterpret_cast<__m128i const *>(&present[word]);
+        auto const *const span_vector = reinterpret_cast<__m128i const *>(&span_bits[word]);
+        missing = _mm_or_si128(missing, _mm_andnot_si128(_mm_load_si128(present_vector), _mm_load_si128(span_vector)));
+      }
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+#else
+      uint64_t missing = 0;
+      for (size_t word = 0; word < kPresentWords; ++word) {
+        missing |= span_bits[word] & ~present[word];
+      }
+      return missing == 0;
+#endif
+    }
+
+    // Bits of bitmap word that fall in the page offsets [begin, end)
+    [[nodiscard]] static constexpr uint64_t GetSpanWordMask(size_t word, size_t begin, size_t end) {
+      size_t const word_begin = word * kWordBits;
+      size_t const low = std::clamp(begin, word_begin, word_begin + kWordBits) - word_begin;
+      size_t const high = std::clamp(end, word_begin, word_begin + kWordBits) - word_begin;
+      return high == low ? 0 : (~uint64_t{0} >> (kWordBits - (high - low))) << low;
+    }
+  };
+
+  // One page of the map. Reads and in-place writes go through page; owner keeps it alive and is only touched under
+  // the unshare mutex or with exclusive access.
+  struct Slot {
+    Slot() = default;
+    Slot(Slot const &other)
+        : page(other.page.load(std::memory_order_relaxed)),
+          owner(other.owner) {}
+    Slot(Slot &&other) noexcept
+        : page(other.page.load(std::memory_order_relaxed)),
+          owned(other.owned.load(std::memory_order_relaxed)),
+          owner(std::move(other.owner)) {}
+    Slot &operator=(Slot const &) = delete;
+    Slot &operator=(Slot &&) = delete;
+    ~Slot() = default;
+
+    std::atomic<Page *> page{nullptr};
+    // Set once no other map can reach the page, so writes may go to it in place. Only a copy of the map shares the
+    // page again, and copying clears it; mutable since copying clears the source's too.
+    mutable std::atomic<bool> owned{false};
+    std::shared_ptr<Page> owner{};
+  };
+
+  static AddressSpan ClampSpan(AddressSpan span) {
+    size_t const end = std::min(kAddressCount, static_cast<size_t>(span.start_address) + span.reg_count);
+    return {span.start_address, static_cast<uint16_t>(end - span.start_address)};
+  }
+
+  // Calls visit(page_index, offset, count) for each page the span touches, stopping early if visit returns false.
+  // The span must lie within the address space.
+  template <typename Visit>
+  static bool ForEachChunk(AddressSpan span, Visit &&visit) {
+    size_t address = span.start_address;
+    size_t remaining = span.reg_count;
+    while (remaining > 0) {
+      size_t const offset = address % kPageSize;
+      size_t const count = std::min(remaining, kPageSize - offset);
+      if (!visit(address / kPageSize, offset, count)) {
+        return false;
+      }
+      address += count;
+      remaining -= count;
+    }
+    return true;
+  }
+
+  // Pages are owned through pointers, so const reads can still wrap values in std::atomic_ref, which requires a
+  // non-const referent
+  [[nodiscard]] Page *GetPage(size_t page_index) const {
+    return page_index < slots_.size() ? slots_[page_index].page.load(std::memory_order_acquire) : nullptr;
+  }
+
+  void DisownPages() const {
+    for (Slot const &slot : slots_) {
+      slot.owned.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  // A copy that just let go of shared storage on another thread may still have been reading it. Its reference
+  // count decrement is a release, so this fence orders those reads before our writes.
+  static void AcquireSoleOwnership() { std::atomic_thread_fence(std::memory_order_acquire); }
+
+  // The page must exist. Lock-free once the page is the map's own.
+  Page &GetMutablePage(size_t page_index) {
+    Slot &slot = slots_[page_index];
+    if (slot.owned.load(std::memory_order_acquire)) {
+      return *slot.page.load(std::memory_order_relaxed);
+    }
+    return UnsharePage(slot);
+  }
+
+  // Writers racing to unshare the same page serialize here, so the page is copied once and no write lands on the
+  // copy being replaced. Readers of this map may still be on the replaced page: it is retired, not freed.
+  Page &UnsharePage(Slot &slot) {
+    std::lock_guard const lock{unshare_mutex_};
+    if (!slot.owned.load(std::memory_order_relaxed)) {
+      if (slot.owner.use_count() > 1) {
+        auto copy = std::make_shared<Page>(*slot.owner);
+        retired_.push_back(std::exchange(slot.owner, std::move(copy)));
+        slot.page.store(slot.owner.get(), std::memory_order_release);
+      } else {
+        AcquireSoleOwnership();
+      }
+      slot.owned.store(true, std::memory_order_release);
+    }
+    return *slot.owner;
+  }
+
+  [[nodiscard]] DataType *Find(int address) const {
+    if (address < 0 || static_cast<size_t>(address) >= kAddressCount) {
+      return nullptr;
+    }
+    size_t const offset = static_cast<size_t>(address) % kPageSize;
+    Page *const page = GetPage(static_cast<size_t>(address) / kPageSize);
+    if (page == nullptr || !page->IsPresent(offset)) {
+      return nullptr;
+    }
+    return &page->values[offset];
+  }
+
+  [[nodiscard]] DataType *FindMutable(int address) {
+    if (Find(address) == nullptr) {
+      return nullptr;
+    }
+    auto const index = static_cast<size_t>(address);
+    return &GetMutablePage(index / kPageSize).values[index % kPageSize];
+  }
+
+  // Indexed by page; shorter than the address space when its upper pages were never added
+  std::vector<Slot> slots_{};
+  // Pages this map unshared, kept for readers that may still be on them until the next Snapshot or span change
+  mutable std::vector<std::shared_ptr<Page>> retired_{};
+  std::mutex unshare_mutex_{};
 };
 
 }  // namespace supermb
@@ -9,4 +9,8 @@ struct AddressSpan {
   uint16_t reg_count{0};
 };
 
+[[nodiscard]] constexpr bool Overlaps(AddressSpan lhs, AddressSpan rhs) noexcept {
+  return lhs.start_address < rhs.start_address + rhs.reg_count && rhs.start_address < lhs.start_address + lhs.reg_count;
+}
+
 }  // namespace supermb
@@ -15,7 +15,8 @@ static inline constexpr uint8_t GetHighByte(uint16_t value) {
   return (value >> kBitsPerByte) & kMaxByte;
 }
 
-// TODO: account for endianness? (if not already handled in the transport implementation)
+// Bytes are combined by significance, so the result does not depend on host endianness. Values spanning several
+// registers are decoded with RegisterCodec (register_codec.hpp).
 static inline constexpr int16_t MakeInt16(uint8_t low_byte, uint8_t high_byte) {
   return static_cast<int16_t>(static_cast<int16_t>(high_byte) << kBitsPerByte | static_cast<int16_t>(low_byte));
 }
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <version>
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+#include <expected>
+#else
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#endif
+
+namespace supermb {
+
+// std::expected where the standard library has it. Otherwise a stand-in with the same spelling for the parts the
+// library uses (has_value, operator bool, operator*, operator->, value, error, value_or), so callers compile
+// unchanged either way. Neither throws on the paths the library takes: check has_value before value or error.
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+
+template <typename T, typename E>
+using Expected = std::expected<T, E>;
+template <typename E>
+using Unexpected = std::unexpected<E>;
+
+#else
+
+template <typename E>
+class Unexpected {
+ public:
+  constexpr explicit Unexpected(E error)
+      : error_(std::move(error)) {}
+
+  [[nodiscard]] constexpr E const &error() const & noexcept { return error_; }
+  [[nodiscard]] constexpr E &error() & noexcept { return error_; }
+
+ private:
+  E error_;
+};
+
+template <typename E>
+Unexpected(E) -> Unexpected<E>;
+
+// value() on an error is a precondition violation here rather than a thrown std::bad_expected_access
+template <typename T, typename E>
+class Expected {
+ public:
+  using value_type = T;
+  using error_type = E;
+
+  // Implicit, like std::expected, so functions can return either a value or an Unexpected
+  constexpr Expected(T value)  // NOLINT(google-explicit-constructor)
+      : storage_(std::in_place_index<0>, std::move(value)) {}
+  template <typename G>
+    requires std::is_constructible_v<E, G const &>
+  constexpr Expected(Unexpected<G> const &unexpected)  // NOLINT(google-explicit-constructor)
+      : storage_(std::in_place_index<1>, unexpected.error()) {}
+
+  [[nodiscard]] constexpr bool has_value() const noexcept { return storage_.index() == 0; }
+  constexpr explicit operator bool() const noexcept { return has_value(); }
+
+  [[nodiscard]] constexpr T &value() & noexcept { return **this; }
+  [[nodiscard]] constexpr T const &value() const & noexcept { return **this; }
+  [[nodiscard]] constexpr T &&value() && noexcept { return std::move(**this); }
+
+  [[nodiscard]] constexpr T &operator*() & noexcept {
+    assert(has_value());
+    return *std::get_if<0>(&storage_);
+  }
+  [[nodiscard]] constexpr T const &operator*() const & noexcept {
+    assert(has_value());
+    return *std::get_if<0>(&storage_);
+  }
+  [[nodiscard]] constexpr T &&operator*() && noexcept {
+    assert(has_value());
+    return std::move(*std::get_if<0>(&storage_));
+  }
+  [[nodiscard]] constexpr T *operator->() noexcept { return &**this; }
+  [[nodiscard]] constexpr T const *operator->() const noexcept { return &**this; }
+
+  [[nodiscard]] constexpr E const &error() const & noexcept {
+    assert(!has_value());
+    return *std::get_if<1>(&storage_);
+  }
+
+  template <typename U>
+  [[nodiscard]] constexpr T value_or(U &&default_value) const & {
+    return has_value() ? **this : static_cast<T>(std::forward<U>(default_value));
+  }
+
+ private:
+  std::variant<T, E> storage_;
+};
+
+#endif
+
+}  // namespace supermb
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "spsc_ring.hpp"
+
+namespace supermb {
+
+// Queue behind a Modbus FIFO pointer address, for one producer thread and one consumer thread. It never holds more
+// than one FC 24 response may carry, so a read can always drain it and the producer can never wedge it full.
+class FifoQueue {
+ public:
+  // Modbus limits a single FC 24 read to 31 queued registers
+  static constexpr uint16_t kMaxCount{31};
+
+  // Producer side: false, with nothing queued, if kMaxCount values are already queued. The count may lag a
+  // concurrent pop, which only makes a push fail early.
+  bool TryPush(int16_t value) { return ring_.Size() < kMaxCount && ring_.TryPush(value); }
+
+  // Consumer side
+  std::optional<int16_t> TryPop() { return ring_.TryPop(); }
+
+  // Exact when called from either end while the other end is idle, otherwise a snapshot
+  [[nodiscard]] size_t Size() const noexcept { return ring_.Size(); }
+
+ private:
+  SpscRing<int16_t, 32> ring_{};
+};
+
+}  // namespace supermb
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace supermb {
+
+// Reference type every FC 20/21 sub-request must carry
+static constexpr uint8_t kFileRecordReferenceType{6};
+static constexpr uint16_t kMaxFileRecordNumber{9999};
+
+struct FileRecordSpan {
+  uint16_t file_number{0};
+  uint16_t record_number{0};
+  uint16_t record_length{0};
+};
+
+struct FileRecord {
+  uint16_t file_number{0};
+  uint16_t record_number{0};
+  std::vector<int16_t> record_data{};
+};
+
+}  // namespace supermb
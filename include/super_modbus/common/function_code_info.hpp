@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "byte_helpers.hpp"
+#include "function_code.hpp"
+
+namespace supermb {
+
+// Field index of a layout that has no such field
+static constexpr uint8_t kNoFieldIndex{0xFF};
+
+// How a byte count in the request data follows from the quantity it describes
+enum class ByteCountUnit : uint8_t {
+  kNone,
+  // One bit per coil, rounded up to whole bytes
+  kBits,
+  kRegisters
+};
+
+// Big-endian quantity field of the request data and its inclusive bounds
+struct QuantityRule {
+  uint8_t index{kNoFieldIndex};
+  uint16_t min{0};
+  uint16_t max{0};
+};
+
+// Request data (PDU after the function code) layout of one function code
+struct FunctionCodeInfo {
+  bool known{false};
+  // Data starts with a start address and a quantity (see RtuRequest::GetAddressSpan)
+  bool has_address_span{false};
+  // Data is exactly min_size bytes; otherwise it is at least min_size bytes
+  bool fixed_size{false};
+  uint8_t min_size{0};
+  // Data ends right after byte_count_index + 1 + byte count bytes
+  uint8_t byte_count_index{kNoFieldIndex};
+  uint8_t min_byte_count{0};
+  uint8_t max_byte_count{0xFF};
+  // The byte count is checked against the write quantity if there is one, against the quantity otherwise
+  ByteCountUnit byte_count_unit{ByteCountUnit::kNone};
+  QuantityRule quantity{};
+  QuantityRule write_quantity{};
+};
+
+namespace detail {
+
+constexpr FunctionCodeInfo MakeFixedSizeInfo(uint8_t size, QuantityRule quantity = {}, bool has_address_span = false) {
+  FunctionCodeInfo info{};
+  info.known = true;
+  info.has_address_span = has_address_span;
+  info.fixed_size = true;
+  info.min_size = size;
+  info.quantity = quantity;
+  return info;
+}
+
+constexpr FunctionCodeInfo MakeByteCountInfo(uint8_t byte_count_index, uint8_t min_byte_count, uint8_t max_byte_count,
+                                             ByteCountUnit unit = ByteCountUnit::kNone, QuantityRule quantity = {},
+                                             QuantityRule write_quantity = {}) {
+  FunctionCodeInfo info{};
+  info.known = true;
+  info.has_address_span = quantity.index != kNoFieldIndex;
+  info.min_size = static_cast<uint8_t>(byte_count_index + 1 + min_byte_count);
+  info.byte_count_index = byte_count_index;
+  info.min_byte_count = min_byte_count;
+  info.max_byte_count = max_byte_count;
+  info.byte_count_unit = unit;
+  info.quantity = quantity;
+  info.write_quantity = write_quantity;
+  return info;
+}
+
+inline constexpr std::array<FunctionCodeInfo, 25> kFunctionCodeInfos{[] {
+  std::array<FunctionCodeInfo, 25> infos{};
+  auto const at = [&infos](FunctionCode function_code) -> FunctionCodeInfo & {
+    return infos[static_cast<uint8_t>(function_code)];
+  };
+
+  at(FunctionCode::kReadCoils) = MakeFixedSizeInfo(4, {2, 1, 2000}, true);
+  at(FunctionCode::kReadDI) = MakeFixedSizeInfo(4, {2, 1, 2000}, true);
+  at(FunctionCode::kReadHR) = MakeFixedSizeInfo(4, {2, 1, 125}, true);
+  at(FunctionCode::kReadIR) = MakeFixedSizeInfo(4, {2, 1, 125}, true);
+  // Output value and register value have no quantity to bound
+  at(FunctionCode::kWriteSingleCoil) = MakeFixedSizeInfo(4, {}, true);
+  at(FunctionCode::kWriteSingleReg) = MakeFixedSizeInfo(4, {}, true);
+  at(FunctionCode::kReadExceptionStatus) = MakeFixedSizeInfo(0);
+  // Sub-function and echoed data
+  at(FunctionCode::kDiagnostics) = {true, false, false, 2};
+  at(FunctionCode::kGetComEventCounter) = MakeFixedSizeInfo(0);
+  at(FunctionCode::kGetComEventLog) = MakeFixedSizeInfo(0);
+  at(FunctionCode::kWriteMultCoils) = MakeByteCountInfo(4, 1, 246, ByteCountUnit::kBits, {2, 1, 1968});
+  at(FunctionCode::kWriteMultRegs) = MakeByteCountInfo(4, 2, 246, ByteCountUnit::kRegisters, {2, 1, 123});
+  at(FunctionCode::kReportSlaveID) = MakeFixedSizeInfo(0);
+  at(FunctionCode::kReadFileRecord) = MakeByteCountInfo(0, 0x07, 0xF5);
+  at(FunctionCode::kWriteFileRecord) = MakeByteCountInfo(0, 0x09, 0xFB);
+  // And mask and or mask follow the address
+  at(FunctionCode::kMaskWriteReg) = MakeFixedSizeInfo(6, {}, true);
+  at(FunctionCode::kReadWriteMultRegs) =
+      MakeByteCountInfo(8, 2, 242, ByteCountUnit::kRegisters, {2, 1, 125}, {6, 1, 121});
+  at(FunctionCode::kReadFIFOQueue) = MakeFixedSizeInfo(2);
+  return infos;
+}()};
+
+// Fixed fields must lie within the minimum size, which is what lets IsRequestDataValid read them unchecked
+static_assert([] {
+  for (FunctionCodeInfo const &info : kFunctionCodeInfos) {
+    for (QuantityRule const &rule : {info.quantity, info.write_quantity}) {
+      if (rule.index != kNoFieldIndex && rule.index + 2 > info.min_size) {
+        return false;
+      }
+    }
+    if (info.byte_count_index != kNoFieldIndex && info.byte_count_index >= info.min_size) {
+      return false;
+    }
+  }
+  return true;
+}());
+
+constexpr bool IsQuantityValid(QuantityRule rule, std::span<uint8_t const> data) {
+  if (rule.index == kNoFieldIndex) {
+    return true;
+  }
+  auto const quantity = static_cast<uint16_t>(MakeInt16(data[rule.index + 1], data[rule.index]));
+  return quantity >= rule.min && quantity <= rule.max;
+}
+
+}  // namespace detail
+
+// Unknown function codes get an entry with known == false
+[[nodiscard]] constexpr FunctionCodeInfo const &GetFunctionCodeInfo(FunctionCode function_code) {
+  auto const index = static_cast<uint8_t>(function_code);
+  return detail::kFunctionCodeInfos[index < detail::kFunctionCodeInfos.size() ? index : 0];
+}
+
+// Checks the request data length, byte count and quantities of a known function code against its table entry, so
+// handlers may index any fixed field without further size checks. Address existence and values are left to them.
+[[nodiscard]] constexpr bool IsRequestDataValid(FunctionCode function_code, std::span<uint8_t const> data) {
+  FunctionCodeInfo const &info = GetFunctionCodeInfo(function_code);
+  if (!info.known || data.size() < info.min_size || (info.fixed_size && data.size() != info.min_size)) {
+    return false;
+  }
+
+  if (info.byte_count_index != kNoFieldIndex) {
+    uint8_t const byte_count = data[info.byte_count_index];
+    if (byte_count < info.min_byte_count || byte_count > info.max_byte_count ||
+        data.size() != static_cast<size_t>(info.byte_count_index) + 1 + byte_count) {
+      return false;
+    }
+  }
+
+  if (!detail::IsQuantityValid(info.quantity, data) || !detail::IsQuantityValid(info.write_quantity, data)) {
+    return false;
+  }
+
+  QuantityRule const &counted = info.write_quantity.index != kNoFieldIndex ? info.write_quantity : info.quantity;
+  if (info.byte_count_unit == ByteCountUnit::kNone || counted.index == kNoFieldIndex) {
+    return true;
+  }
+  auto const quantity = static_cast<uint16_t>(MakeInt16(data[counted.index + 1], data[counted.index]));
+  size_t const expected = info.byte_count_unit == ByteCountUnit::kBits ? (quantity + kBitsPerByte - 1) / kBitsPerByte
+                                                                                 : static_cast<size_t>(quantity) * 2;
+  return data[info.byte_count_index] == expected;
+}
+
+}  // namespace supermb
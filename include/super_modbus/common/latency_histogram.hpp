@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace supermb {
+
+// Fixed-size log-linear histogram of latencies in nanoseconds. Values below 128 are exact; above that every power of
+// two is split into 64 linear buckets, so a reported value is within 1/64 (about 1.6 %) of the recorded one. Values
+// up to kMaxValue (about 36 minutes) are tracked, larger ones are clamped. Recording is a handful of integer
+// operations and never allocates, so it is safe on a hot path; the histogram itself is not thread safe, keep one per
+// thread and Merge them.
+class LatencyHistogram {
+ public:
+  static constexpr uint64_t kMaxValue{(uint64_t{1} << 41) - 1};
+
+  void Record(uint64_t value, uint64_t count = 1) noexcept {
+    value = std::min(value, kMaxValue);
+    counts_[GetIndex(value)] += count;
+    total_count_ += count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value) * static_cast<double>(count);
+  }
+
+  void Merge(LatencyHistogram const &other) noexcept {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+  }
+
+  void Reset() noexcept { *this = LatencyHistogram{}; }
+
+  [[nodiscard]] uint64_t GetCount() const noexcept { return total_count_; }
+  [[nodiscard]] uint64_t GetMin() const noexcept { return total_count_ == 0 ? 0 : min_; }
+  [[nodiscard]] uint64_t GetMax() const noexcept { return max_; }
+  [[nodiscard]] double GetMean() const noexcept {
+    return total_count_ == 0 ? 0.0 : sum_ / static_cast<double>(total_count_);
+  }
+
+  // Highest value of the bucket holding the given percentile (0 to 100), capped at the largest recorded value
+  [[nodiscard]] uint64_t GetValueAtPercentile(double percentile) const noexcept {
+    if (total_count_ == 0) {
+      return 0;
+    }
+    double const clamped = std::clamp(percentile, 0.0, 100.0);
+    auto const rank = std::max<uint64_t>(
+        static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(total_count_))), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return std::min(GetHighestEquivalentValue(i), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static constexpr int kSubBucketBits{7};
+  static constexpr uint64_t kSubBucketCount{uint64_t{1} << kSubBucketBits};
+  static constexpr uint64_t kSubBucketHalfCount{kSubBucketCount / 2};
+  static constexpr int kMaxShift{std::bit_width(kMaxValue) - kSubBucketBits};
+  static constexpr size_t kBucketCount{kSubBucketCount + kMaxShift * kSubBucketHalfCount};
+
+  static constexpr size_t GetIndex(uint64_t value) noexcept {
+    if (value < kSubBucketCount) {
+      return static_cast<size_t>(value);
+    }
+    int const shift = std::bit_width(value) - kSubBucketBits;
+    return static_cast<size_t>(kSubBucketCount + (shift - 1) * kSubBucketHalfCount +
+                               ((value >> shift) - kSubBucketHalfCount));
+  }
+
+  static constexpr uint64_t GetHighestEquivalentValue(size_t index) noexcept {
+    if (index < kSubBucketCount) {
+      return index;
+    }
+    size_t const offset = index - kSubBucketCount;
+    auto const shift = static_cast<int>(offset / kSubBucketHalfCount) + 1;
+    uint64_t const sub_bucket = offset % kSubBucketHalfCount + kSubBucketHalfCount;
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+
+  std::array<uint64_t, kBucketCount> counts_{};
+  uint64_t total_count_{0};
+  uint64_t min_{std::numeric_limits<uint64_t>::max()};
+  uint64_t max_{0};
+  double sum_{0.0};
+};
+
+}  // namespace supermb
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace supermb {
+
+// Read/write shared memory mapping of a whole local file. Accesses go straight to the page cache; the only
+// syscalls are in Open, Sync and the destructor.
+class MappedFile {
+ public:
+  [[nodiscard]] static std::optional<MappedFile> Open(std::string const &path);
+
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  [[nodiscard]] std::span<uint8_t> GetBytes() noexcept { return {data_, size_}; }
+  [[nodiscard]] std::span<uint8_t const> GetBytes() const noexcept { return {data_, size_}; }
+  [[nodiscard]] size_t GetSize() const noexcept { return size_; }
+
+  // Flushes dirty pages to the file (msync)
+  bool Sync();
+
+ private:
+  MappedFile(int file_descriptor, uint8_t *data, size_t size)
+      : file_descriptor_(file_descriptor),
+        data_(data),
+        size_(size) {}
+
+  void Reset() noexcept;
+
+  int file_descriptor_{-1};
+  uint8_t *data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace supermb
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include "address_span.hpp"
+#include "exception_code.hpp"
+#include "expected.hpp"
+#include "function_code.hpp"
+
+namespace supermb {
+
+enum class ModbusErrorKind : uint8_t {
+  // Frame shorter than slave id, function code and CRC
+  kFrameLength,
+  kCrc,
+  // PDU that no request or response can start with, or whose byte count disagrees with its data
+  kMalformedPdu,
+  // Function code the slave does not implement
+  kFunction,
+  // Request data length, byte count, quantity or another field outside what the function code allows
+  kLength,
+  // Registers, FIFO queues or file records the slave does not have
+  kAddress,
+  // The slave cannot take the request right now (its write journal is full); the master may retry
+  kBusy
+};
+
+// Plain value, so returning one never allocates
+struct ModbusError {
+  ModbusErrorKind kind{ModbusErrorKind::kMalformedPdu};
+  FunctionCode function_code{FunctionCode::kInvalid};
+  // Registers the request asked for (its read span for FC 23), for kAddress errors of register requests
+  AddressSpan span{};
+
+  // Exception a slave answers the error with; framing errors are never answered
+  [[nodiscard]] constexpr ExceptionCode GetExceptionCode() const noexcept {
+    switch (kind) {
+      case ModbusErrorKind::kFunction:
+        return ExceptionCode::kIllegalFunction;
+      case ModbusErrorKind::kLength:
+        return ExceptionCode::kIllegalDataValue;
+      case ModbusErrorKind::kAddress:
+        return ExceptionCode::kIllegalDataAddress;
+      case ModbusErrorKind::kBusy:
+        return ExceptionCode::kServerDeviceBusy;
+      default:
+        return ExceptionCode::kInvalidExceptionCode;
+    }
+  }
+};
+
+template <typename T>
+using ModbusResult = Expected<T, ModbusError>;
+
+}  // namespace supermb
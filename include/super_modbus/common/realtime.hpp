@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace supermb {
+
+// Real-time settings for a latency-critical service thread. Every setting is best effort: most need privileges
+// (CAP_SYS_NICE, CAP_IPC_LOCK or a raised RLIMIT_MEMLOCK), and a thread that cannot get one still works, with more
+// jitter. Defaults leave the thread as it is.
+struct RealtimeConfig {
+  // SCHED_FIFO priority, 1 to 99; 0 keeps the default scheduler
+  int fifo_priority{0};
+  // Core to pin the thread to; negative leaves it free to migrate
+  int cpu{-1};
+  // mlockall(MCL_CURRENT | MCL_FUTURE), for the whole process
+  bool lock_memory{false};
+  // Touch kPrefaultStackSize bytes of stack so the first requests do not take page faults on it
+  bool prefault_stack{false};
+};
+
+// What ApplyRealtimeConfig managed to set. Settings that were not asked for count as applied.
+struct RealtimeStatus {
+  bool scheduling{true};
+  bool affinity{true};
+  bool memory_locked{true};
+
+  [[nodiscard]] bool AllApplied() const noexcept { return scheduling && affinity && memory_locked; }
+};
+
+static constexpr size_t kPrefaultStackSize{64 * 1024};
+
+// Applies config to the calling thread
+RealtimeStatus ApplyRealtimeConfig(RealtimeConfig const &config);
+
+}  // namespace supermb
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include "address_map.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace supermb {
+
+// Order of the bytes of a multi-register value on the wire, named after a 32 bit value with bytes A (most
+// significant) to D. kAbcd is plain big-endian, the Modbus default. For 64 bit values the same two properties carry
+// over: whether the most significant register comes first (kAbcd, kBadc) and whether the bytes within each register
+// are swapped (kBadc, kDcba).
+enum class WordOrder : uint8_t {
+  kAbcd,
+  kCdab,
+  kBadc,
+  kDcba
+};
+
+template <typename T>
+concept RegisterValue = (std::is_integral_v<T> || std::is_floating_point_v<T>) &&
+                        (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+template <RegisterValue T, WordOrder Order = WordOrder::kAbcd>
+class RegisterCodec {
+ public:
+  static constexpr size_t kRegisterCount{sizeof(T) / 2};
+
+  [[nodiscard]] static constexpr T Decode(std::span<uint16_t const, kRegisterCount> registers) noexcept {
+    Bits bits = 0;
+    for (size_t i = 0; i < kRegisterCount; ++i) {
+      uint16_t word = registers[i];
+      if constexpr (kSwapBytes) {
+        word = SwapBytes(word);
+      }
+      size_t const word_index = kMostSignificantFirst ? kRegisterCount - 1 - i : i;
+      bits |= static_cast<Bits>(word) << (16 * word_index);
+    }
+    return std::bit_cast<T>(bits);
+  }
+
+  [[nodiscard]] static constexpr std::array<uint16_t, kRegisterCount> Encode(T value) noexcept {
+    auto const bits = std::bit_cast<Bits>(value);
+    std::array<uint16_t, kRegisterCount> registers{};
+    for (size_t i = 0; i < kRegisterCount; ++i) {
+      size_t const word_index = kMostSignificantFirst ? kRegisterCount - 1 - i : i;
+      auto word = static_cast<uint16_t>(bits >> (16 * word_index));
+      if constexpr (kSwapBytes) {
+        word = SwapBytes(word);
+      }
+      registers[i] = word;
+    }
+    return registers;
+  }
+
+  // Bulk decode of register bytes as carried in a response payload (each register high byte first). Decodes
+  // min(out.size(), bytes.size() / sizeof(T)) values and returns that count. On x86-64 sixteen bytes are
+  // converted per step with SSE2 lane shuffles, so a full 125 register read is 62 floats in about 16 steps.
+  static size_t DecodeBytes(std::span<uint8_t const> bytes, std::span<T> out) noexcept {
+    size_t const count = std::min(out.size(), bytes.size() / sizeof(T));
+    uint8_t const *source = bytes.data();
+    auto *destination = reinterpret_cast<uint8_t *>(out.data());
+    size_t const byte_count = count * sizeof(T);
+    size_t offset = 0;
+
+#if defined(__SSE2__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    static constexpr size_t kVectorSize{16};
+    for (; offset + kVectorSize <= byte_count; offset += kVectorSize) {
+      __m128i vector = _mm_loadu_si128(reinterpret_cast<__m128i const *>(source + offset));
+      // Wire registers are big-endian, so bytes are swapped unless the order already swaps them
+      if constexpr (!kSwapBytes) {
+        vector = _mm_or_si128(_mm_slli_epi16(vector, 8), _mm_srli_epi16(vector, 8));
+      }
+      if constexpr (kMostSignificantFirst && kRegisterCount == 2) {
+        vector = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vector, 0xB1), 0xB1);
+      } else if constexpr (kMostSignificantFirst && kRegisterCount == 4) {
+        vector = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vector, 0x1B), 0x1B);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + offset), vector);
+    }
+#endif
+
+    for (size_t index = offset / sizeof(T); index < count; ++index) {
+      std::array<uint16_t, kRegisterCount> registers{};
+      for (size_t i = 0; i < kRegisterCount; ++i) {
+        uint8_t const *register_bytes = source + index * sizeof(T) + i * 2;
+        registers[i] = static_cast<uint16_t>(register_bytes[0] << 8 | register_bytes[1]);
+      }
+      out[index] = Decode(registers);
+    }
+
+    return count;
+  }
+
+ private:
+  using Bits = std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+
+  static constexpr bool kSwapBytes{Order == WordOrder::kBadc || Order == WordOrder::kDcba};
+  static constexpr bool kMostSignificantFirst{Order == WordOrder::kAbcd || Order == WordOrder::kBadc};
+
+  static constexpr uint16_t SwapBytes(uint16_t word) noexcept { return static_cast<uint16_t>(word << 8 | word >> 8); }
+};
+
+// Typed view over consecutive addresses of an AddressMap. Fails without side effects if any of the addresses is
+// missing.
+template <RegisterValue T, WordOrder Order = WordOrder::kAbcd, typename DataType>
+[[nodiscard]] std::optional<T> ReadValue(AddressMap<DataType> const &address_map, int address) {
+  using Codec = RegisterCodec<T, Order>;
+  std::array<DataType, Codec::kRegisterCount> values{};
+  if (address < 0 || address > UINT16_MAX ||
+      !address_map.ReadRange({static_cast<uint16_t>(address), Codec::kRegisterCount}, values)) {
+    return {};
+  }
+
+  std::array<uint16_t, Codec::kRegisterCount> registers{};
+  std::ranges::transform(values, registers.begin(), [](DataType value) { return static_cast<uint16_t>(value); });
+  return Codec::Decode(registers);
+}
+
+template <RegisterValue T, WordOrder Order = WordOrder::kAbcd, typename DataType>
+bool WriteValue(AddressMap<DataType> &address_map, int address, T value) {
+  using Codec = RegisterCodec<T, Order>;
+  if (address < 0 || address > UINT16_MAX) {
+    return false;
+  }
+
+  auto const registers = Codec::Encode(value);
+  std::array<DataType, Codec::kRegisterCount> values{};
+  std::ranges::transform(registers, values.begin(), [](uint16_t reg) { return static_cast<DataType>(reg); });
+  return address_map.WriteRange({static_cast<uint16_t>(address), Codec::kRegisterCount}, values);
+}
+
+}  // namespace supermb
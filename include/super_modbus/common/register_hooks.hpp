@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "address_map.hpp"
+#include "address_span.hpp"
+
+namespace supermb {
+
+// Side effects attached to register addresses. IsHooked is consulted once per span; only spans it accepts pay for
+// OnRead (which may replace each value read) and OnWrite (called for each value after it is stored).
+template <typename Hooks, typename DataType>
+concept RegisterHooks = requires(Hooks const &hooks, AddressSpan span, uint16_t address, DataType value) {
+  { hooks.IsHooked(span) } -> std::convertible_to<bool>;
+  { hooks.OnRead(address, value) } -> std::convertible_to<DataType>;
+  hooks.OnWrite(address, value);
+};
+
+// Hooks known at compile time to be absent; every check folds away
+struct NoRegisterHooks {
+  [[nodiscard]] static constexpr bool IsHooked(AddressSpan /*span*/) noexcept { return false; }
+  template <typename DataType>
+  [[nodiscard]] static constexpr DataType OnRead(uint16_t /*address*/, DataType value) noexcept {
+    return value;
+  }
+  template <typename DataType>
+  static constexpr void OnWrite(uint16_t /*address*/, DataType /*value*/) noexcept {}
+};
+
+// Hooks registered at run time. Until the first hook is added the table holds no bitmap and IsHooked is a single
+// null check; afterwards it tests the span's bits a 64-bit word at a time.
+template <typename DataType>
+class RegisterHookTable {
+ public:
+  // Gets the address and the stored value, returns the value to report
+  using ReadHook = std::function<DataType(uint16_t, DataType)>;
+  // Gets the address and the value just stored
+  using WriteHook = std::function<void(uint16_t, DataType)>;
+
+  // Either hook may be empty. Spans added later take precedence where they overlap earlier ones.
+  void AddHook(AddressSpan span, ReadHook read_hook, WriteHook write_hook) {
+    if (!hooked_) {
+      hooked_ = std::make_unique<Bitmap>();
+    }
+    size_t const end = std::min(kAddressCount, static_cast<size_t>(span.start_address) + span.reg_count);
+    for (size_t address = span.start_address; address < end; ++address) {
+      (*hooked_)[address / kWordBits] |= uint64_t{1} << (address % kWordBits);
+    }
+    hooks_.push_back({span, std::move(read_hook), std::move(write_hook)});
+  }
+
+  [[nodiscard]] bool IsHooked(AddressSpan span) const {
+    if (!hooked_) {
+      return false;
+    }
+    size_t const end = std::min(kAddressCount, static_cast<size_t>(span.start_address) + span.reg_count);
+    for (size_t address = span.start_address; address < end;) {
+      size_t const bit = address % kWordBits;
+      size_t const bit_count = std::min(end - address, kWordBits - bit);
+      uint64_t const mask = (bit_count == kWordBits ? ~uint64_t{0} : (uint64_t{1} << bit_count) - 1) << bit;
+      if (((*hooked_)[address / kWordBits] & mask) != 0) {
+        return true;
+      }
+      address += bit_count;
+    }
+    return false;
+  }
+
+  [[nodiscard]] DataType OnRead(uint16_t address, DataType value) const {
+    Hook const *const hook = Find(address);
+    return hook != nullptr && hook->read_hook ? hook->read_hook(address, value) : value;
+  }
+
+  void OnWrite(uint16_t address, DataType value) const {
+    Hook const *const hook = Find(address);
+    if (hook != nullptr && hook->write_hook) {
+      hook->write_hook(address, value);
+    }
+  }
+
+ private:
+  static constexpr size_t kAddressCount{0x10000};
+  static constexpr size_t kWordBits{64};
+  using Bitmap = std::array<uint64_t, kAddressCount / kWordBits>;
+
+  struct Hook {
+    AddressSpan span;
+    ReadHook read_hook;
+    WriteHook write_hook;
+  };
+
+  // Hooked spans are few, so a backwards scan beats an index
+  [[nodiscard]] Hook const *Find(uint16_t address) const {
+    for (auto hook_iter = hooks_.rbegin(); hook_iter != hooks_.rend(); ++hook_iter) {
+      if (address >= hook_iter->span.start_address &&
+          address - hook_iter->span.start_address < hook_iter->span.reg_count) {
+        return &*hook_iter;
+      }
+    }
+    return nullptr;
+  }
+
+  std::unique_ptr<Bitmap> hooked_{};
+  std::vector<Hook> hooks_{};
+};
+
+// AddressMap::ReadRange followed by the read hooks of span, if it has any
+template <typename DataType, RegisterHooks<DataType> Hooks>
+bool ReadRegisters(AddressMap<DataType> const &address_map, Hooks const &hooks, AddressSpan span,
+                   std::type_identity_t<std::span<DataType>> out) {
+  if (!address_map.ReadRange(span, out)) {
+    return false;
+  }
+  if (hooks.IsHooked(span)) {
+    for (uint16_t i = 0; i < span.reg_count; ++i) {
+      out[i] = hooks.OnRead(static_cast<uint16_t>(span.start_address + i), out[i]);
+    }
+  }
+  return true;
+}
+
+// AddressMap::WriteRange followed by the write hooks of span, if it has any
+template <typename DataType, RegisterHooks<DataType> Hooks>
+bool WriteRegisters(AddressMap<DataType> &address_map, Hooks const &hooks, AddressSpan span,
+                    std::type_identity_t<std::span<DataType const>> values) {
+  if (!address_map.WriteRange(span, values)) {
+    return false;
+  }
+  if (hooks.IsHooked(span)) {
+    for (uint16_t i = 0; i < span.reg_count; ++i) {
+      hooks.OnWrite(static_cast<uint16_t>(span.start_address + i), values[i]);
+    }
+  }
+  return true;
+}
+
+}  // namespace supermb
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace supermb {
+
+// Bounded lock-free ring for exactly one producer thread and one consumer thread. Head and tail are free-running
+// counters on separate cache lines, so the producer and consumer only share a line when the ring is full or empty.
+template <typename DataType, size_t Capacity>
+class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  [[nodiscard]] static constexpr size_t GetCapacity() noexcept { return Capacity; }
+
+  // Producer side
+  bool TryPush(DataType const &value) { return Push(value); }
+  bool TryPush(DataType &&value) { return Push(std::move(value)); }
+
+  // Producer side: true if a push would fail right now
+  [[nodiscard]] bool Full() noexcept {
+    size_t const tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == Capacity) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    return tail - cached_head_ == Capacity;
+  }
+
+  // Consumer side
+  std::optional<DataType> TryPop() {
+    size_t const head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return {};
+      }
+    }
+
+    DataType value = std::move(buffer_[head & kIndexMask]);
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // Exact when called from either end while the other end is idle, otherwise a snapshot
+  [[nodiscard]] size_t Size() const noexcept {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] bool Empty() const noexcept { return Size() == 0; }
+
+ private:
+  template <typename Value>
+  bool Push(Value &&value) {
+    size_t const tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == Capacity) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == Capacity) {
+        return false;
+      }
+    }
+
+    buffer_[tail & kIndexMask] = std::forward<Value>(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  static constexpr size_t kIndexMask{Capacity - 1};
+  static constexpr size_t kCacheLineSize{64};
+
+  // Consumer owned
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t cached_tail_{0};
+
+  // Producer owned
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t cached_head_{0};
+
+  alignas(kCacheLineSize) std::array<DataType, Capacity> buffer_{};
+};
+
+}  // namespace supermb
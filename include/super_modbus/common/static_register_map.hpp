@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace supermb {
+
+enum class RegisterType : uint8_t {
+  kInt16,
+  kUInt16,
+  kInt32,
+  kUInt32,
+  kFloat32,
+  kFloat64
+};
+
+enum class RegisterAccess : uint8_t {
+  kReadOnly,
+  kWriteOnly,
+  kReadWrite
+};
+
+static inline constexpr uint16_t GetRegisterWidth(RegisterType type) {
+  switch (type) {
+    case RegisterType::kInt32:
+    case RegisterType::kUInt32:
+    case RegisterType::kFloat32:
+      return 2;
+    case RegisterType::kFloat64:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+struct RegisterDefinition {
+  std::string_view name;
+  uint16_t address{0};
+  RegisterType type{RegisterType::kInt16};
+  RegisterAccess access{RegisterAccess::kReadWrite};
+};
+
+// Register map whose layout is fixed at compile time. Registers is a constexpr array of RegisterDefinition with
+// static storage duration:
+//
+//   static constexpr std::array kProfile{
+//       RegisterDefinition{"status", 0, RegisterType::kUInt16, RegisterAccess::kReadOnly},
+//       RegisterDefinition{"setpoint", 1, RegisterType::kFloat32, RegisterAccess::kReadWrite}};
+//   StaticRegisterMap<kProfile> registers;
+//
+// Overlapping addresses and duplicate names fail to compile. Dense profiles store each word at (address - first
+// address) and need no lookup at all; sparse profiles pack their words and resolve addresses through a perfect hash
+// (hash and displace) built at compile time, so every lookup is two table reads and one key compare.
+template <auto const &Registers>
+class StaticRegisterMap {
+ public:
+  struct Slot {
+    uint16_t address{0};
+    uint16_t offset{0};
+    RegisterAccess access{RegisterAccess::kReadOnly};
+    bool valid{false};
+  };
+
+  static constexpr size_t kDefinitionCount{Registers.size()};
+  static constexpr size_t kWordCount{[] {
+    size_t word_count = 0;
+    for (auto const &reg : Registers) {
+      word_count += GetRegisterWidth(reg.type);
+    }
+    return word_count;
+  }()};
+
+  static_assert(kDefinitionCount > 0, "register map must define at least one register");
+
+ private:
+  struct Word {
+    uint16_t address;
+    uint16_t offset;
+    RegisterAccess access;
+  };
+
+  static constexpr bool kFitsAddressSpace{std::ranges::all_of(Registers, [](RegisterDefinition const &reg) {
+    return static_cast<uint32_t>(reg.address) + GetRegisterWidth(reg.type) <= 0x10000;
+  })};
+  static_assert(kFitsAddressSpace, "register runs past the end of the 16 bit address space");
+
+  static constexpr std::array<Word, kWordCount> kWords{[] {
+    std::array<Word, kWordCount> words{};
+    size_t index = 0;
+    for (auto const &reg : Registers) {
+      for (uint16_t i = 0; i < GetRegisterWidth(reg.type); ++i) {
+        words[index] = {static_cast<uint16_t>(reg.address + i), static_cast<uint16_t>(index), reg.access};
+        ++index;
+      }
+    }
+    return words;
+  }()};
+
+  static constexpr bool kHasOverlap{[] {
+    std::array<uint16_t, kWordCount> addresses{};
+    std::ranges::transform(kWords, addresses.begin(), &Word::address);
+    std::ranges::sort(addresses);
+    return std::ranges::adjacent_find(addresses) != addresses.end();
+  }()};
+  static_assert(!kHasOverlap, "register definitions overlap");
+
+  static constexpr bool kHasDuplicateName{[] {
+    for (size_t i = 0; i < kDefinitionCount; ++i) {
+      for (size_t j = i + 1; j < kDefinitionCount; ++j) {
+        if (Registers[i].name == Registers[j].name) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }()};
+  static_assert(!kHasDuplicateName, "register names must be unique");
+
+ public:
+  static constexpr uint16_t kFirstAddress{std::ranges::min(kWords, {}, &Word::address).address};
+  static constexpr uint32_t kEndAddress{static_cast<uint32_t>(std::ranges::max(kWords, {}, &Word::address).address) +
+                                        1};
+  // Direct tables waste at most half their slots
+  static constexpr bool kIsDense{kEndAddress - kFirstAddress <= kWordCount * 2};
+  static constexpr size_t kStorageSize{kIsDense ? kEndAddress - kFirstAddress : kWordCount};
+
+  [[nodiscard]] static constexpr std::optional<uint16_t> GetOffset(int address) noexcept {
+    Slot const *slot = FindSlot(address);
+    if (slot == nullptr) {
+      return {};
+    }
+    return slot->offset;
+  }
+
+  [[nodiscard]] static constexpr bool IsReadable(int address) noexcept {
+    Slot const *slot = FindSlot(address);
+    return slot != nullptr && slot->access != RegisterAccess::kWriteOnly;
+  }
+
+  [[nodiscard]] static constexpr bool IsWritable(int address) noexcept {
+    Slot const *slot = FindSlot(address);
+    return slot != nullptr && slot->access != RegisterAccess::kReadOnly;
+  }
+
+  // Compile-time lookups by name; an unknown name fails to compile
+  [[nodiscard]] static consteval RegisterDefinition const &GetDefinition(std::string_view name) {
+    for (auto const &reg : Registers) {
+      if (reg.name == name) {
+        return reg;
+      }
+    }
+    UnknownRegisterName();
+    return Registers[0];
+  }
+
+  [[nodiscard]] static consteval uint16_t GetOffset(std::string_view name) {
+    return GetOffset(GetDefinition(name).address).value();
+  }
+
+  [[nodiscard]] constexpr std::optional<int16_t> operator[](int address) const noexcept {
+    Slot const *slot = FindSlot(address);
+    if (slot == nullptr) {
+      return {};
+    }
+    return values_[slot->offset];
+  }
+
+  constexpr bool Set(int address, int16_t value) noexcept {
+    Slot const *slot = FindSlot(address);
+    if (slot == nullptr) {
+      return false;
+    }
+    values_[slot->offset] = value;
+    return true;
+  }
+
+  // Words of a multi-word register are adjacent in storage, starting at GetOffset(name)
+  [[nodiscard]] constexpr std::span<int16_t, kStorageSize> GetWords() noexcept { return values_; }
+  [[nodiscard]] constexpr std::span<int16_t const, kStorageSize> GetWords() const noexcept { return values_; }
+
+ private:
+  static void UnknownRegisterName();  // not constexpr: reaching it in a consteval call is a compile error
+
+  static constexpr uint32_t Hash(uint32_t key, uint32_t seed) noexcept {
+    uint32_t hash = key ^ (seed * 0x9E3779B9U);
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+    return hash;
+  }
+
+  static constexpr size_t kBucketCount{std::bit_ceil(std::max<size_t>(kWordCount / 2, 1))};
+  static constexpr size_t kSlotCount{kIsDense ? kStorageSize : std::bit_ceil(kWordCount * 2)};
+
+  struct Table {
+    std::array<Slot, kSlotCount> slots{};
+    std::array<uint32_t, kBucketCount> seeds{};
+    bool complete{false};
+  };
+
+  // Commits the bucket's keys to slots only if every one of them lands on a free slot
+  static constexpr bool TryPlaceBucket(std::array<Slot, kSlotCount> &slots, size_t bucket, uint32_t seed) noexcept {
+    std::array<Slot, kSlotCount> candidate = slots;
+    for (auto const &word : kWords) {
+      if ((Hash(word.address, 0) & (kBucketCount - 1)) == bucket) {
+        Slot &slot = candidate[Hash(word.address, seed) & (kSlotCount - 1)];
+        if (slot.valid) {
+          return false;
+        }
+        slot = {word.address, word.offset, word.access, true};
+      }
+    }
+    slots = candidate;
+    return true;
+  }
+
+  static constexpr Table kTable{[] {
+    Table table{};
+    if constexpr (kIsDense) {
+      for (auto const &word : kWords) {
+        uint16_t const offset = word.address - kFirstAddress;
+        table.slots[offset] = {word.address, offset, word.access, true};
+      }
+      table.complete = true;
+    } else {
+      // Place the largest buckets first, each with the first seed that maps all of its keys to free slots
+      std::array<size_t, kBucketCount> bucket_sizes{};
+      for (auto const &word : kWords) {
+        ++bucket_sizes[Hash(word.address, 0) & (kBucketCount - 1)];
+      }
+
+      std::array<size_t, kBucketCount> bucket_order{};
+      for (size_t i = 0; i < kBucketCount; ++i) {
+        bucket_order[i] = i;
+      }
+      std::ranges::sort(bucket_order, [&bucket_sizes](size_t lhs, size_t rhs) {
+        return bucket_sizes[lhs] > bucket_sizes[rhs] || (bucket_sizes[lhs] == bucket_sizes[rhs] && lhs < rhs);
+      });
+
+      constexpr uint32_t kMaxSeed{1U << 16};
+      table.complete = true;
+      for (size_t i = 0; i < kBucketCount && table.complete; ++i) {
+        size_t const bucket = bucket_order[i];
+        uint32_t seed = 1;
+        while (seed < kMaxSeed && bucket_sizes[bucket] > 0 && !TryPlaceBucket(table.slots, bucket, seed)) {
+          ++seed;
+        }
+        table.seeds[bucket] = seed;
+        table.complete = seed < kMaxSeed;
+      }
+    }
+    return table;
+  }()};
+  static_assert(kTable.complete, "failed to build a perfect hash for the register map");
+
+  static constexpr Slot const *FindSlot(int address) noexcept {
+    if constexpr (kIsDense) {
+      auto const index = static_cast<uint32_t>(address - kFirstAddress);
+      if (index >= kStorageSize || !kTable.slots[index].valid) {
+        return nullptr;
+      }
+      return &kTable.slots[index];
+    } else {
+      if (address < 0 || address > 0xFFFF) {
+        return nullptr;
+      }
+      auto const key = static_cast<uint32_t>(address);
+      uint32_t const seed = kTable.seeds[Hash(key, 0) & (kBucketCount - 1)];
+      Slot const &slot = kTable.slots[Hash(key, seed) & (kSlotCount - 1)];
+      if (!slot.valid || slot.address != key) {
+        return nullptr;
+      }
+      return &slot;
+    }
+  }
+
+  std::array<int16_t, kStorageSize> values_{};
+};
+
+}  // namespace supermb
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace supermb {
+
+// Lets any number of shared writers through at once, or one exclusive writer alone. Passing as a shared writer is an
+// atomic increment and a load, with no mutex; it only waits while an exclusive writer is inside. Works with
+// std::shared_lock and std::unique_lock.
+class WriteGate {
+ public:
+  void lock_shared() {
+    while (true) {
+      shared_count_.fetch_add(1, std::memory_order_seq_cst);
+      if (!exclusive_.load(std::memory_order_seq_cst)) {
+        return;
+      }
+      shared_count_.fetch_sub(1, std::memory_order_release);
+      // Blocks until the exclusive writer is done
+      std::lock_guard const wait{exclusive_mutex_};
+    }
+  }
+
+  void unlock_shared() { shared_count_.fetch_sub(1, std::memory_order_release); }
+
+  // Exclusive writers queue on a mutex, then wait for the shared writers already inside to leave
+  void lock() {
+    exclusive_mutex_.lock();
+    exclusive_.store(true, std::memory_order_seq_cst);
+    while (shared_count_.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock() {
+    exclusive_.store(false, std::memory_order_release);
+    exclusive_mutex_.unlock();
+  }
+
+ private:
+  std::atomic<uint32_t> shared_count_{0};
+  std::atomic<bool> exclusive_{false};
+  std::mutex exclusive_mutex_{};
+};
+
+}  // namespace supermb
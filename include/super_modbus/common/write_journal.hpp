@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <tuple>
+
+namespace supermb {
+
+// One register value a master wrote. sequence orders writes across every producer of a journal.
+struct JournaledWrite {
+  uint64_t sequence{0};
+  uint8_t slave_id{0};
+  uint16_t address{0};
+  int16_t value{0};
+};
+
+// Bounded lock-free log of register writes for many producer threads (slaves on different ports) and one consumer
+// (the application's control loop). A producer reserves all the registers of a request with one compare-and-swap, so
+// a request is journaled in full or not at all and its registers are contiguous in the log; the consumer drains at
+// its own cadence.
+//
+// A producer that has reserved but not yet published its entries holds back the entries after them, so Drain may
+// return fewer entries than are reserved; they show up on a later call.
+class WriteJournal {
+ public:
+  // Capacity is rounded up to a power of two
+  explicit WriteJournal(size_t capacity)
+      : capacity_(std::bit_ceil(std::max<size_t>(capacity, 1))),
+        cells_(std::make_unique<Cell[]>(capacity_)) {}
+
+  [[nodiscard]] size_t GetCapacity() const noexcept { return capacity_; }
+
+  // Producer side: false, with nothing appended, if values.size() entries do not fit
+  bool TryAppend(uint8_t slave_id, uint16_t start_address, std::span<int16_t const> values) {
+    size_t const count = values.size();
+    uint64_t position = head_.load(std::memory_order_relaxed);
+    do {
+      if (position + count - tail_.load(std::memory_order_acquire) > capacity_) {
+        return false;
+      }
+    } while (!head_.compare_exchange_weak(position, position + count, std::memory_order_relaxed));
+
+    for (size_t i = 0; i < count; ++i) {
+      Cell &cell = cells_[(position + i) & (capacity_ - 1)];
+      cell.write = {position + i, slave_id, static_cast<uint16_t>(start_address + i), values[i]};
+      cell.published.store(position + i + 1, std::memory_order_release);
+    }
+    return true;
+  }
+
+  // Consumer side: moves up to out.size() published entries into out, in sequence order, and returns their count
+  size_t Drain(std::span<JournaledWrite> out) {
+    uint64_t const tail = tail_.load(std::memory_order_relaxed);
+    size_t count = 0;
+    for (; count < out.size(); ++count) {
+      Cell const &cell = cells_[(tail + count) & (capacity_ - 1)];
+      if (cell.published.load(std::memory_order_acquire) != tail + count + 1) {
+        break;
+      }
+      out[count] = cell.write;
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer side: Drain, then keeps only the last write to each register of each slave. The survivors are sorted by
+  // slave id and address, which is the order a control loop usually wants to apply them in. Does not allocate.
+  size_t DrainCoalesced(std::span<JournaledWrite> out) {
+    auto const drained = out.first(Drain(out));
+    std::ranges::sort(drained, {}, [](JournaledWrite const &write) {
+      return std::tuple{write.slave_id, write.address, write.sequence};
+    });
+
+    size_t count = 0;
+    for (size_t i = 0; i < drained.size(); ++i) {
+      bool const superseded = i + 1 < drained.size() && drained[i + 1].slave_id == drained[i].slave_id &&
+                              drained[i + 1].address == drained[i].address;
+      if (!superseded) {
+        drained[count++] = drained[i];
+      }
+    }
+    return count;
+  }
+
+  // Snapshot of the entries appended but not yet drained
+  [[nodiscard]] size_t Size() const noexcept {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize{64};
+
+  struct Cell {
+    // Sequence + 1 of the write stored here once it is readable; sequences never repeat, so stale cells never match
+    std::atomic<uint64_t> published{0};
+    JournaledWrite write{};
+  };
+
+  size_t const capacity_;
+  std::unique_ptr<Cell[]> const cells_;
+  // Producers
+  alignas(kCacheLineSize) std::atomic<uint64_t> head_{0};
+  // Consumer
+  alignas(kCacheLineSize) std::atomic<uint64_t> tail_{0};
+};
+
+}  // namespace supermb
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "../common/address_span.hpp"
+#include "../common/function_code.hpp"
+
+namespace supermb {
+
+// Address range whose register reads may be answered from the cache for up to ttl
+struct ReadCacheRange {
+  uint8_t unit_id{0};
+  FunctionCode function_code{FunctionCode::kReadHR};
+  AddressSpan span{};
+  std::chrono::milliseconds ttl{0};
+};
+
+// Fixed-capacity cache of register read results (FC 3 and FC 4) keyed by unit id, function code and span. A lookup
+// is served by any live entry whose span contains the requested one. Not synchronized; the gateway guards it.
+class ReadCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kMaxEntries{64};
+  static constexpr size_t kMaxRegisters{125};
+
+  explicit ReadCache(std::vector<ReadCacheRange> ranges)
+      : ranges_(std::move(ranges)) {}
+
+  // TTL of the configured range containing span, or nothing if reads of span are not cached
+  [[nodiscard]] std::optional<std::chrono::milliseconds> GetTtl(uint8_t unit_id, FunctionCode function_code,
+                                                                AddressSpan span) const noexcept;
+
+  // Copies the register bytes (high byte first) of span to out, which must hold 2 * span.reg_count bytes
+  bool Lookup(uint8_t unit_id, FunctionCode function_code, AddressSpan span, Clock::time_point now,
+              std::span<uint8_t> out) const noexcept;
+
+  void Insert(uint8_t unit_id, FunctionCode function_code, AddressSpan span, std::span<uint8_t const> register_bytes,
+              Clock::time_point now) noexcept;
+
+  // Drops every entry of unit_id and function_code that overlaps span
+  void Invalidate(uint8_t unit_id, FunctionCode function_code, AddressSpan span) noexcept;
+
+ private:
+  struct Entry {
+    bool valid{false};
+    uint8_t unit_id{0};
+    FunctionCode function_code{FunctionCode::kInvalid};
+    AddressSpan span{};
+    Clock::time_point expiry{};
+    std::array<uint8_t, kMaxRegisters * 2> register_bytes{};
+  };
+
+  std::vector<ReadCacheRange> ranges_;
+  std::array<Entry, kMaxEntries> entries_{};
+};
+
+}  // namespace supermb
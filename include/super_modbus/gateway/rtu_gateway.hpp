@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+#include "../common/address_span.hpp"
+#include "../common/exception_code.hpp"
+#include "../common/function_code.hpp"
+#include "../common/spsc_ring.hpp"
+#include "read_cache.hpp"
+#include "../rtu/rtu_frame.hpp"
+#include "../tcp/mbap.hpp"
+
+namespace supermb {
+
+// Half-duplex serial bus the gateway talks RTU over. Transact sends one request ADU (CRC included) and waits for the
+// reply, returning the number of bytes written to response, or 0 if nothing valid arrived within timeout.
+class SerialLine {
+ public:
+  SerialLine() = default;
+  SerialLine(SerialLine const &) = delete;
+  SerialLine &operator=(SerialLine const &) = delete;
+  SerialLine(SerialLine &&) = delete;
+  SerialLine &operator=(SerialLine &&) = delete;
+  virtual ~SerialLine() = default;
+
+  virtual size_t Transact(std::span<uint8_t const> request, std::span<uint8_t, kMaxRtuFrameSize> response,
+                          std::chrono::milliseconds timeout) = 0;
+};
+
+struct RtuGatewayConfig {
+  // How long a slave gets to answer once its request is on the wire
+  std::chrono::milliseconds response_timeout{1000};
+  // Requests that waited longer than this for the bus are failed without being sent
+  std::chrono::milliseconds queue_timeout{2000};
+  // Register ranges (FC 3/4) whose reads may be served from a cache. Empty disables caching.
+  std::vector<ReadCacheRange> read_cache_ranges{};
+};
+
+// Modbus TCP to RTU gateway. Each serial line has a bounded queue of kLineQueueDepth transactions drained by its own
+// worker thread, since only one request can be on a half-duplex bus at a time. When a line's queue is full the
+// request is answered with kGatewayPathUnavailable right away; requests that time out in the queue or on the bus are
+// answered with kGatewayTargetDeviceFailedToRespond. Queued requests are expired by a timer thread within
+// kExpiryInterval of their queue_timeout, so an expired request is not held up behind the transactions ahead of it.
+//
+// Transactions live in a fixed pool per line and move between the network thread and the worker through SPSC rings,
+// so the MBAP transaction id mapping needs no allocation and no lock per transaction. Submit must always be called
+// from the same (network) thread; the response handler is called from the worker threads, the timer thread, or from
+// Submit itself for requests that are rejected up front.
+//
+// With read_cache_ranges configured, register reads inside those ranges are answered from a per-line cache while
+// fresh, including sub-ranges of a cached read. Writes passing through invalidate the registers they touch. A cached
+// read that misses while an identical read is already queued or on the bus waits for that transaction instead of
+// issuing its own (single-flight).
+class RtuGateway {
+ public:
+  using ConnectionId = uint32_t;
+  using ResponseHandler = std::function<void(ConnectionId connection, std::span<uint8_t const> mbap_frame)>;
+
+  static constexpr size_t kLineQueueDepth{32};
+  static constexpr std::chrono::milliseconds kExpiryInterval{10};
+
+  RtuGateway(RtuGatewayConfig config, ResponseHandler response_handler);
+  RtuGateway(RtuGateway const &) = delete;
+  RtuGateway &operator=(RtuGateway const &) = delete;
+  RtuGateway(RtuGateway &&) = delete;
+  RtuGateway &operator=(RtuGateway &&) = delete;
+  ~RtuGateway();
+
+  // Setup, before Start. Returns the index of the new line.
+  size_t AddSerialLine(std::unique_ptr<SerialLine> serial_line);
+  void RouteUnit(uint8_t unit_id, size_t line_index);
+
+  void Start();
+  void Stop();
+
+  // Takes one complete MBAP request frame. Returns false if the frame is malformed, in which case nothing will be
+  // sent back and the connection should be dropped.
+  bool Submit(ConnectionId connection, std::span<uint8_t const> mbap_frame);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int16_t kNoTransaction{-1};
+
+  // Who owns a transaction. Submit makes it kQueued (or kWaiting behind an identical in-flight read); the worker takes
+  // a queued one by moving it to kSending, the timer by moving it through kExpiring to kExpired. The worker recycles
+  // every transaction it dequeues, expired or not, since it is the only producer of free_transactions.
+  enum class TransactionState : uint8_t {
+    kFree,
+    kWaiting,
+    kQueued,
+    kSending,
+    kExpiring,
+    kExpired
+  };
+
+  // Register read or write span of a request, used for caching
+  struct RegisterAccess {
+    FunctionCode function_code{FunctionCode::kInvalid};
+    AddressSpan span{};
+    bool is_write{false};
+  };
+
+  struct Transaction {
+    ConnectionId connection{0};
+    std::atomic<TransactionState> state{TransactionState::kFree};
+    // Read by the timer while the transaction may be recycled, hence atomic; in Clock ticks
+    std::atomic<Clock::rep> queue_deadline{0};
+    std::optional<RegisterAccess> register_access{};
+    bool cacheable_read{false};
+    // Set while this transaction carries a cacheable read that later identical reads may wait on, chained through
+    // next_waiter; cleared early once a write to its span is queued behind it
+    bool in_flight_read{false};
+    // Set with in_flight_read cleared by a write: the response predates the write, so it answers the waiters but is
+    // not cached
+    bool overtaken_by_write{false};
+    int16_t next_waiter{kNoTransaction};
+    size_t size{0};
+    // Holds the MBAP request on the way in and the MBAP response on the way out
+    std::array<uint8_t, kMaxMbapFrameSize> frame{};
+  };
+
+  struct Line {
+    std::unique_ptr<SerialLine> serial_line;
+    std::array<Transaction, kLineQueueDepth> transactions{};
+    // Worker produces, Submit consumes
+    SpscRing<uint16_t, kLineQueueDepth> free_transactions{};
+    // Submit produces, worker consumes
+    SpscRing<uint16_t, kLineQueueDepth> pending_transactions{};
+    std::atomic<uint32_t> pending_signal{0};
+    std::thread worker{};
+
+    // Guards the cache and the waiter chains of in-flight cacheable reads
+    std::mutex cache_mutex{};
+    std::optional<ReadCache> read_cache{};
+  };
+
+  [[nodiscard]] static std::optional<RegisterAccess> GetRegisterAccess(std::span<uint8_t const> mbap_frame);
+  bool TryServeFromCache(Line &line, ConnectionId connection, std::span<uint8_t const> mbap_frame,
+                         RegisterAccess const &register_access);
+  [[nodiscard]] static int16_t FindInFlightRead(Line const &line, Transaction const &transaction);
+  static void DetachInFlightReads(Line &line, uint8_t unit_id, RegisterAccess const &write);
+  void Respond(Line &line, uint16_t transaction_index, std::span<uint8_t const> response_pdu);
+
+  void RunLine(Line &line);
+  void RunExpiry();
+  void ExpireQueued(Line &line, Clock::time_point now);
+  [[nodiscard]] bool TakeQueued(Line &line, uint16_t transaction_index);
+  void Finish(Line &line, uint16_t transaction_index, std::span<uint8_t const> response_pdu);
+  void SendException(ConnectionId connection, std::span<uint8_t const> request_frame, ExceptionCode exception_code);
+
+  static constexpr int16_t kNoRoute{-1};
+
+  RtuGatewayConfig config_;
+  ResponseHandler response_handler_;
+  std::vector<std::unique_ptr<Line>> lines_{};
+  std::array<int16_t, 256> routes_{};
+  std::atomic<bool> running_{false};
+  std::thread expiry_worker_{};
+  std::mutex expiry_mutex_{};
+  std::condition_variable expiry_cv_{};
+};
+
+}  // namespace supermb
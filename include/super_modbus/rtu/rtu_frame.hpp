@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "../common/modbus_error.hpp"
+#include "rtu_request.hpp"
+#include "rtu_response.hpp"
+
+namespace supermb {
+
+// Slave id, function code and CRC
+static constexpr size_t kMinRtuFrameSize{4};
+static constexpr size_t kMaxRtuFrameSize{256};
+
+// Modbus CRC-16 (polynomial 0xA001, initial value 0xFFFF). On the wire the low byte goes first.
+[[nodiscard]] uint16_t ComputeCrc16(std::span<uint8_t const> bytes) noexcept;
+[[nodiscard]] bool CheckRtuFrameCrc(std::span<uint8_t const> frame) noexcept;
+
+// RTU frames carry no length, so a master splits its receive stream by function code. Returns the size of the
+// response frame starting at bytes once enough of it has arrived to tell, or nothing if it cannot tell yet or the
+// function code's response size is not fixed by its header (callers then fall back to the CRC or bus silence).
+[[nodiscard]] std::optional<size_t> GetRtuResponseFrameSize(std::span<uint8_t const> bytes) noexcept;
+// Same for a request frame, sized from the function code table
+[[nodiscard]] std::optional<size_t> GetRtuRequestFrameSize(std::span<uint8_t const> bytes) noexcept;
+
+// Appends slave id, PDU and CRC to out
+void EncodeRtuFrame(RtuRequest const &request, std::vector<uint8_t> &out);
+void EncodeRtuFrame(RtuResponse const &response, std::vector<uint8_t> &out);
+
+// Frames that are too short or fail the CRC check decode to nothing
+[[nodiscard]] std::optional<RtuRequest> DecodeRtuRequestFrame(std::span<uint8_t const> frame,
+                                                              RtuRequest::allocator_type allocator = {});
+[[nodiscard]] std::optional<RtuResponse> DecodeRtuResponseFrame(std::span<uint8_t const> frame,
+                                                                RtuResponse::allocator_type allocator = {});
+
+// Same, but a rejected frame says why: kFrameLength, kCrc or kMalformedPdu. Nothing is allocated before the frame
+// is known to be good.
+[[nodiscard]] ModbusResult<RtuRequest> ParseRtuRequestFrame(std::span<uint8_t const> frame,
+                                                            RtuRequest::allocator_type allocator = {});
+[[nodiscard]] ModbusResult<RtuResponse> ParseRtuResponseFrame(std::span<uint8_t const> frame,
+                                                              RtuResponse::allocator_type allocator = {});
+
+}  // namespace supermb
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "rtu_request.hpp"
+#include "rtu_response.hpp"
+
+namespace supermb {
+
+// Conversion between RtuRequest/RtuResponse and protocol data units (function code followed by its data), shared by
+// every framing. Encoders append to out so callers can place the PDU after their own header. Response data leaves out
+// the byte counts of read responses; they are derived here.
+void EncodeRequestPdu(RtuRequest const &request, std::vector<uint8_t> &out);
+void EncodeResponsePdu(RtuResponse const &response, std::vector<uint8_t> &out);
+
+// Decoded data is allocated from allocator; the same holds for every framing's decoders
+[[nodiscard]] std::optional<RtuRequest> DecodeRequestPdu(uint8_t slave_id, std::span<uint8_t const> pdu,
+                                                         RtuRequest::allocator_type allocator = {});
+[[nodiscard]] std::optional<RtuResponse> DecodeResponsePdu(uint8_t slave_id, std::span<uint8_t const> pdu,
+                                                           RtuResponse::allocator_type allocator = {});
+
+}  // namespace supermb
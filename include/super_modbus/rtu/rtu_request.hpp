@@ -1,34 +1,67 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <optional>
+#include <span>
+#include <utility>
 #include <vector>
 #include "../common/address_span.hpp"
+#include "../common/file_record.hpp"
 #include "../common/function_code.hpp"
 
 namespace supermb {
 
+// Request data is a std::pmr::vector: pass a memory resource (a per-connection std::pmr::monotonic_buffer_resource,
+// say) to keep requests off the global heap. Copies use the default resource unless one is given.
 class RtuRequest {
  public:
+  using allocator_type = std::pmr::polymorphic_allocator<uint8_t>;
+
   struct Header {
     uint8_t slave_id;
     FunctionCode function_code;
   };
 
-  explicit RtuRequest(Header header)
-      : header_(header) {}
+  explicit RtuRequest(Header header, allocator_type allocator = {})
+      : header_(header),
+        data_(allocator) {}
+  RtuRequest(RtuRequest const &other, allocator_type allocator)
+      : header_(other.header_),
+        data_(other.data_, allocator) {}
+  RtuRequest(RtuRequest &&other, allocator_type allocator)
+      : header_(other.header_),
+        data_(std::move(other.data_), allocator) {}
+  RtuRequest(RtuRequest const &) = default;
+  RtuRequest(RtuRequest &&) = default;
+  RtuRequest &operator=(RtuRequest const &) = default;
+  RtuRequest &operator=(RtuRequest &&) = default;
+  ~RtuRequest() = default;
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return data_.get_allocator(); }
 
   [[nodiscard]] uint8_t GetSlaveId() const { return header_.slave_id; }
   [[nodiscard]] FunctionCode GetFunctionCode() const { return header_.function_code; }
-  [[nodiscard]] std::vector<uint8_t> const &GetData() const { return data_; }
+  [[nodiscard]] std::pmr::vector<uint8_t> const &GetData() const { return data_; }
   [[nodiscard]] std::optional<AddressSpan> GetAddressSpan() const;
+  [[nodiscard]] std::optional<AddressSpan> GetWriteAddressSpan() const;
+
+  // Raw PDU data as received from a transport; validation is left to the slave
+  void SetRawData(std::span<uint8_t const> data) { data_.assign(data.begin(), data.end()); }
 
   bool SetAddressSpan(AddressSpan address_span);
   bool SetWriteSingleRegisterData(uint16_t register_address, int16_t register_value);
+  bool SetWriteMultipleRegistersData(uint16_t start_address, std::vector<int16_t> const &values);
+  bool SetMaskWriteRegisterData(uint16_t register_address, uint16_t and_mask, uint16_t or_mask);
+  bool SetReadFifoQueueData(uint16_t fifo_address);
+  bool SetReadFileRecordData(std::vector<FileRecordSpan> const &sub_requests);
+  bool SetWriteFileRecordData(std::vector<FileRecord> const &sub_requests);
+  bool SetReadWriteMultipleRegistersData(AddressSpan read_span, uint16_t write_start_address,
+                                         std::vector<int16_t> const &write_values);
 
  private:
   Header header_;
-  std::vector<uint8_t> data_{};
+  std::pmr::vector<uint8_t> data_;
 };
 
 }  // namespace supermb
@@ -1,34 +1,73 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <utility>
 #include <vector>
 #include "../common/exception_code.hpp"
 #include "../common/function_code.hpp"
 
 namespace supermb {
 
+// Allocator-aware like RtuRequest
 class RtuResponse {
  public:
-  RtuResponse(uint8_t slave_id, FunctionCode function_code)
+  using allocator_type = std::pmr::polymorphic_allocator<uint8_t>;
+
+  RtuResponse(uint8_t slave_id, FunctionCode function_code, allocator_type allocator = {})
       : slave_id_(slave_id),
-        function_code_(function_code) {}
+        function_code_(function_code),
+        data_(allocator) {}
+  RtuResponse(RtuResponse const &other, allocator_type allocator)
+      : slave_id_(other.slave_id_),
+        function_code_(other.function_code_),
+        exception_code_(other.exception_code_),
+        data_(other.data_, allocator) {}
+  RtuResponse(RtuResponse &&other, allocator_type allocator)
+      : slave_id_(other.slave_id_),
+        function_code_(other.function_code_),
+        exception_code_(other.exception_code_),
+        data_(std::move(other.data_), allocator) {}
+  RtuResponse(RtuResponse const &) = default;
+  RtuResponse(RtuResponse &&) = default;
+  RtuResponse &operator=(RtuResponse const &) = default;
+  RtuResponse &operator=(RtuResponse &&) = default;
+  ~RtuResponse() = default;
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return data_.get_allocator(); }
 
   [[nodiscard]] uint8_t GetSlaveId() const noexcept { return slave_id_; }
 
   [[nodiscard]] FunctionCode GetFunctionCode() const noexcept { return function_code_; }
   [[nodiscard]] ExceptionCode GetExceptionCode() const noexcept { return exception_code_; }
-  [[nodiscard]] std::vector<uint8_t> GetData() const { return data_; }
+  [[nodiscard]] std::pmr::vector<uint8_t> const &GetData() const { return data_; }
 
   void SetExceptionCode(ExceptionCode const &exception_code) noexcept { exception_code_ = exception_code; }
 
-  void SetData(std::vector<uint8_t> const &data) { data_ = data; };
+  void SetData(std::span<uint8_t const> data) { data_.assign(data.begin(), data.end()); }
   void EmplaceBack(uint8_t data) { data_.emplace_back(data); }
+  void Append(std::span<uint8_t const> data) { data_.insert(data_.end(), data.begin(), data.end()); }
 
  private:
-  const uint8_t slave_id_{};
-  const FunctionCode function_code_{};
+  uint8_t slave_id_{};
+  FunctionCode function_code_{};
   ExceptionCode exception_code_{ExceptionCode::kInvalidExceptionCode};
-  std::vector<uint8_t> data_{};
+  std::pmr::vector<uint8_t> data_;
+};
+
+// Response of one request processed by RtuSlave::ProcessBatch. The data is not owned: it lives in the arena the batch
+// was written to.
+struct BatchResponse {
+  uint8_t slave_id{0};
+  FunctionCode function_code{FunctionCode::kInvalid};
+  ExceptionCode exception_code{ExceptionCode::kInvalidExceptionCode};
+  uint32_t data_offset{0};
+  uint32_t data_size{0};
+
+  [[nodiscard]] std::span<uint8_t const> GetData(std::span<uint8_t const> arena) const noexcept {
+    return arena.subspan(data_offset, data_size);
+  }
 };
 
 }  // namespace supermb
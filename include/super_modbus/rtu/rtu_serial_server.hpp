@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../common/latency_histogram.hpp"
+#include "../common/realtime.hpp"
+#include "rtu_frame.hpp"
+#include "rtu_slave.hpp"
+
+namespace supermb {
+
+struct RtuSerialServerConfig {
+  // Applied to every port thread. A non-negative cpu is the core of port 0; port i is pinned to cpu + i.
+  RealtimeConfig realtime{};
+};
+
+// Serves RtuSlaves on serial lines (or ptys), one thread per port since each line is half duplex. Frames are split
+// by function code (GetRtuRequestFrameSize); bytes that do not make a frame are dropped after a short silence, as on
+// a real bus. Requests for a slave id not on the port are ignored, broadcasts are processed by every slave on the
+// port and never answered.
+//
+// Every port measures its turnaround: the time from reading the last byte of a request to writing the first byte of
+// the response. This is the part of the master's response time the server controls, so its tail shows processing
+// and preemption jitter; wake-up latency after the request arrives is only visible from the master's side.
+//
+// The request path does not allocate: receive and transmit buffers and the arena requests and responses are built
+// in are fixed-size members of the port, zeroed (and so faulted in) when the port is added.
+class RtuSerialServer {
+ public:
+  explicit RtuSerialServer(RtuSerialServerConfig config = {});
+  RtuSerialServer(RtuSerialServer const &) = delete;
+  RtuSerialServer &operator=(RtuSerialServer const &) = delete;
+  RtuSerialServer(RtuSerialServer &&) = delete;
+  RtuSerialServer &operator=(RtuSerialServer &&) = delete;
+  ~RtuSerialServer();
+
+  // Setup, before Start. fd must be a raw-mode serial line; the server neither configures nor closes it. Returns the
+  // index of the new port.
+  size_t AddPort(int fd);
+  // The slave is used from the port's thread while the server runs, so add it to one port only
+  void AddSlave(size_t port, RtuSlave &slave);
+
+  // Returns once every port thread has applied the real-time config
+  void Start();
+  void Stop();
+
+  // Valid from Start on
+  [[nodiscard]] RealtimeStatus GetRealtimeStatus(size_t port) const { return ports_[port]->realtime_status; }
+  // Valid once Stop returns; the histograms are not synchronized while ports are running
+  [[nodiscard]] LatencyHistogram const &GetTurnaround(size_t port) const { return ports_[port]->turnaround; }
+
+ private:
+  static constexpr size_t kArenaSize{4096};
+
+  struct Port {
+    int fd{-1};
+    std::array<RtuSlave *, 256> slaves{};
+    std::array<uint8_t, 2 * kMaxRtuFrameSize> receive_buffer{};
+    size_t received{0};
+    // Reserved to kMaxRtuFrameSize up front
+    std::vector<uint8_t> transmit_buffer{};
+    std::array<std::byte, kArenaSize> arena{};
+    RealtimeStatus realtime_status{};
+    LatencyHistogram turnaround{};
+    std::thread worker{};
+  };
+
+  void RunPort(Port &port);
+  static void ProcessFrames(Port &port, std::chrono::steady_clock::time_point request_end);
+
+  RtuSerialServerConfig config_;
+  std::vector<std::unique_ptr<Port>> ports_{};
+  std::atomic<bool> running_{false};
+};
+
+}  // namespace supermb
@@ -1,35 +1,143 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "../common/address_map.hpp"
 #include "../common/address_span.hpp"
+#include "../common/fifo_queue.hpp"
+#include "../common/file_record.hpp"
+#include "../common/mapped_file.hpp"
+#include "../common/modbus_error.hpp"
+#include "../common/register_hooks.hpp"
+#include "../common/write_gate.hpp"
+#include "../common/write_journal.hpp"
 #include "rtu_request.hpp"
 #include "rtu_response.hpp"
 
 namespace supermb {
 
+// Register requests (FC 3, 4, 6, 16, 22, 23) may be processed on one slave from several threads at once. Without a
+// write journal FC 6, 16 and 22 write without locking, FC 22 as a compare-and-swap that never loses a concurrent
+// writer's bits. FC 23 closes the slave's write gate, so its write and the following read are one critical section
+// that no other register write interleaves with; with a journal every register write closes it. FC 20, 21 and 24
+// requests and ProcessBatch must still come from one thread at a time, and SnapshotRegisters and the setup calls need
+// the slave to themselves.
 class RtuSlave {
  public:
+  static constexpr uint16_t kMaxFifoCount{FifoQueue::kMaxCount};
+  using RegisterReadHook = RegisterHookTable<int16_t>::ReadHook;
+  using RegisterWriteHook = RegisterHookTable<int16_t>::WriteHook;
+
+  // Point-in-time copy of the register maps, sharing their pages until the slave writes to them
+  struct RegisterSnapshot {
+    AddressMap<int16_t> holding_registers;
+    AddressMap<int16_t> input_registers;
+  };
+
   explicit RtuSlave(uint8_t slave_id)
       : id_(slave_id) {}
 
+  // Starts from registers, sharing their pages until this slave writes to them
+  RtuSlave(uint8_t slave_id, RegisterSnapshot registers)
+      : id_(slave_id),
+        holding_registers_(std::move(registers.holding_registers)),
+        input_registers_(std::move(registers.input_registers)) {}
+
   [[nodiscard]] uint8_t GetId() const noexcept { return id_; }
   void SetId(uint8_t slave_id) noexcept { id_ = slave_id; }
 
-  RtuResponse Process(RtuRequest const &request);
+  // Response data is allocated from allocator. A request the slave rejects is answered with the exception response
+  // for its TryProcess error.
+  RtuResponse Process(RtuRequest const &request, RtuResponse::allocator_type allocator = {});
+
+  // Same as Process, but a rejected request returns why instead of an exception response. Rejection is decided before
+  // any response data is produced, so error paths never allocate.
+  [[nodiscard]] ModbusResult<RtuResponse> TryProcess(RtuRequest const &request,
+                                                     RtuResponse::allocator_type allocator = {});
+
+  // Processes min(requests.size(), responses.size()) requests and returns that count. responses[i] answers
+  // requests[i] exactly as Process would, but all response data is appended to arena instead of being owned by each
+  // response. arena is reserved once from the request sizes, so register reads append to it in place; any other
+  // request goes through Process, whose response data is allocated from arena's memory resource and then copied in.
+  // Backing arena with a preallocated buffer keeps batches off the heap. Register reads between two writes are served
+  // grouped by register map and address, which keeps their lookups cache-hot; writes stay in request order.
+  size_t ProcessBatch(std::span<RtuRequest const> requests, std::span<BatchResponse> responses,
+                      std::pmr::vector<uint8_t> &arena);
+
+  // Consistent across both maps, and copies one pointer per page rather than any register. Serialize with Process
+  // (call it between requests on the serving thread); the snapshot can then be handed to a historian thread and read
+  // there without locks while Process keeps writing.
+  [[nodiscard]] RegisterSnapshot SnapshotRegisters() const;
 
   void AddHoldingRegisters(AddressSpan span);
   void AddInputRegisters(AddressSpan span);
 
+  // Hooks run inside Process. A read hook computes the value reported for an address from the stored one; a write
+  // hook sees each value after FC 6, 16, 22 or 23 stores it. Spans without hooks cost one bitmap check per request.
+  void AddHoldingRegisterHooks(AddressSpan span, RegisterReadHook read_hook, RegisterWriteHook write_hook = {});
+  void AddInputRegisterHook(AddressSpan span, RegisterReadHook read_hook);
+
+  // Journal mode: every holding register value FC 6, 16, 22 or 23 stores is also appended to journal, so an
+  // application thread can drain the writes at its own cadence instead of polling the registers. The journal may be
+  // shared by slaves on several threads and must outlive its use here; nullptr turns journaling off. A write that
+  // does not fit is rejected as kBusy before any register changes. Journaled writes to a slave are serialized, so its
+  // entries are in the order the values were stored.
+  void SetWriteJournal(WriteJournal *journal) noexcept { write_journal_ = journal; }
+
+  // Returns the queue behind a FIFO pointer address. The application thread is the single producer; Process
+  // (FC 24) is the single consumer. Reads are destructive: a request removes every queued value it returns. The
+  // queue refuses pushes past kMaxFifoCount values, so one request always drains it.
+  FifoQueue &AddFifoQueue(uint16_t fifo_address);
+
+  // Maps a local file onto a Modbus file number for FC 20/21. The file holds the records as big-endian register
+  // images (record N at byte offset 2 * N), so requests are served with plain copies to and from the mapping.
+  // Returns false if the file cannot be mapped.
+  bool AddFileRecord(uint16_t file_number, std::string const &path);
+
  private:
-  static void ProcessReadRegisters(AddressMap<int16_t> const &address_map, RtuRequest const &request,
-                                   RtuResponse &response);
-  static void ProcessWriteSingleRegister(AddressMap<int16_t> &address_map, RtuRequest const &request,
-                                         RtuResponse &response);
+  struct BatchRead {
+    FunctionCode function_code;
+    uint16_t start_address;
+    uint32_t index;
+  };
+
+  static void ProcessReadRegisters(AddressMap<int16_t> const &address_map, RegisterHookTable<int16_t> const &hooks,
+                                   RtuRequest const &request, RtuResponse &response);
+  static void ProcessWriteSingleRegister(AddressMap<int16_t> &address_map, RegisterHookTable<int16_t> const &hooks,
+                                         RtuRequest const &request, RtuResponse &response);
+  static void ProcessWriteMultipleRegisters(AddressMap<int16_t> &address_map, RegisterHookTable<int16_t> const &hooks,
+                                            RtuRequest const &request, RtuResponse &response);
+  static void ProcessMaskWriteRegister(AddressMap<int16_t> &address_map, RegisterHookTable<int16_t> const &hooks,
+                                       RtuRequest const &request, RtuResponse &response);
+  static void ProcessReadWriteMultipleRegisters(AddressMap<int16_t> &address_map,
+                                                RegisterHookTable<int16_t> const &hooks, RtuRequest const &request,
+                                                RtuResponse &response);
+  void ProcessReadFifoQueue(RtuRequest const &request, RtuResponse &response);
+  void ProcessReadFileRecord(RtuRequest const &request, RtuResponse &response);
+  void ProcessWriteFileRecord(RtuRequest const &request, RtuResponse &response);
+  [[nodiscard]] std::optional<std::span<uint8_t>> GetFileRecordBytes(FileRecordSpan span);
+  void ProcessBatchRead(RtuRequest const &request, BatchResponse &response, std::pmr::vector<uint8_t> &arena) const;
+  [[nodiscard]] bool JournalRegisterWrite(RtuRequest const &request);
 
   uint8_t id_{1};
   AddressMap<int16_t> holding_registers_{};
   AddressMap<int16_t> input_registers_{};
+  RegisterHookTable<int16_t> holding_hooks_{};
+  RegisterHookTable<int16_t> input_hooks_{};
+  std::unordered_map<uint16_t, std::unique_ptr<FifoQueue>> fifo_queues_{};
+  std::unordered_map<uint16_t, MappedFile> file_records_{};
+  WriteJournal *write_journal_{nullptr};
+  // Shared by FC 6, 16 and 22, held alone by FC 23
+  WriteGate holding_write_gate_{};
+  // Scratch for ProcessBatch, kept to avoid an allocation per batch
+  std::vector<BatchRead> batch_reads_{};
 };
 
 }  // namespace supermb
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+#include "../common/address_span.hpp"
+#include "../common/byte_helpers.hpp"
+#include "../common/exception_code.hpp"
+#include "../common/function_code.hpp"
+#include "../common/function_code_info.hpp"
+#include "rtu_request.hpp"
+#include "rtu_response.hpp"
+
+namespace supermb {
+
+// Register ranges of a StaticRtuSlave, fixed at compile time:
+//
+//   struct PumpLayout {
+//     static constexpr AddressSpan kHoldingRegisters{0, 16};
+//     static constexpr AddressSpan kInputRegisters{100, 8};
+//   };
+template <typename Layout>
+concept StaticSlaveLayout = requires {
+  { Layout::kHoldingRegisters } -> std::convertible_to<AddressSpan>;
+  { Layout::kInputRegisters } -> std::convertible_to<AddressSpan>;
+};
+
+// RtuSlave for a fixed layout: each register type is one contiguous std::array, addresses translate to offsets with
+// a subtraction against a constant, and the whole of Process lives in this header so it inlines into the caller. It
+// answers the register function codes (3, 4, 6, 16, 22, 23) exactly like RtuSlave and everything else with
+// kIllegalFunction. No hooks, no allocation besides the response data.
+template <StaticSlaveLayout Layout>
+class StaticRtuSlave {
+ public:
+  static constexpr AddressSpan kHoldingRegisters{Layout::kHoldingRegisters};
+  static constexpr AddressSpan kInputRegisters{Layout::kInputRegisters};
+
+  static_assert(static_cast<size_t>(kHoldingRegisters.start_address) + kHoldingRegisters.reg_count <= 0x10000 &&
+                    static_cast<size_t>(kInputRegisters.start_address) + kInputRegisters.reg_count <= 0x10000,
+                "register range runs past the end of the 16 bit address space");
+
+  explicit constexpr StaticRtuSlave(uint8_t slave_id)
+      : id_(slave_id) {}
+
+  [[nodiscard]] constexpr uint8_t GetId() const noexcept { return id_; }
+  constexpr void SetId(uint8_t slave_id) noexcept { id_ = slave_id; }
+
+  // Storage of each range; element i holds address range.start_address + i
+  [[nodiscard]] constexpr std::span<int16_t, kHoldingRegisters.reg_count> GetHoldingRegisters() noexcept {
+    return holding_registers_;
+  }
+  [[nodiscard]] constexpr std::span<int16_t, kInputRegisters.reg_count> GetInputRegisters() noexcept {
+    return input_registers_;
+  }
+
+  // Offset of span within range, if range covers all of it
+  [[nodiscard]] static constexpr std::optional<size_t> GetOffset(AddressSpan range, AddressSpan span) noexcept {
+    if (span.start_address < range.start_address ||
+        static_cast<size_t>(span.start_address) + span.reg_count >
+            static_cast<size_t>(range.start_address) + range.reg_count) {
+      return {};
+    }
+    return span.start_address - range.start_address;
+  }
+
+  // Same contract as RtuSlave::Process
+  RtuResponse Process(RtuRequest const &request, RtuResponse::allocator_type allocator = {}) {
+    RtuResponse response{request.GetSlaveId(), request.GetFunctionCode(), allocator};
+    FunctionCode const function_code = request.GetFunctionCode();
+    if (function_code != FunctionCode::kReadHR && function_code != FunctionCode::kReadIR &&
+        function_code != FunctionCode::kWriteSingleReg && function_code != FunctionCode::kWriteMultRegs &&
+        function_code != FunctionCode::kMaskWriteReg && function_code != FunctionCode::kReadWriteMultRegs) {
+      response.SetExceptionCode(ExceptionCode::kIllegalFunction);
+      return response;
+    }
+    auto const &data = request.GetData();
+    if (!IsRequestDataValid(function_code, data)) {
+      response.SetExceptionCode(ExceptionCode::kIllegalDataValue);
+      return response;
+    }
+
+    // Every handled layout starts with an address; the reads and FC 16 and 23 follow it with a quantity
+    AddressSpan const span{static_cast<uint16_t>(MakeInt16(data[1], data[0])),
+                           static_cast<uint16_t>(MakeInt16(data[3], data[2]))};
+    ExceptionCode exception_code = ExceptionCode::kIllegalDataAddress;
+    switch (function_code) {
+      case FunctionCode::kReadHR:
+        exception_code = Read(holding_registers_, kHoldingRegisters, span, response);
+        break;
+      case FunctionCode::kReadIR:
+        exception_code = Read(input_registers_, kInputRegisters, span, response);
+        break;
+      case FunctionCode::kWriteSingleReg:
+        if (auto const offset = GetOffset(kHoldingRegisters, {span.start_address, 1}); offset.has_value()) {
+          holding_registers_[*offset] = MakeInt16(data[3], data[2]);
+          // Normal response is an echo of the request
+          response.SetData(data);
+          exception_code = ExceptionCode::kAcknowledge;
+        }
+        break;
+      case FunctionCode::kWriteMultRegs:
+        if (Write(std::span{data}.subspan(kWriteMultipleValuesIndex), span)) {
+          // Normal response echoes the start address and quantity
+          response.SetData(std::span{data}.first(kWriteMultipleEchoSize));
+          exception_code = ExceptionCode::kAcknowledge;
+        }
+        break;
+      case FunctionCode::kMaskWriteReg:
+        if (auto const offset = GetOffset(kHoldingRegisters, {span.start_address, 1}); offset.has_value()) {
+          int16_t const and_mask = MakeInt16(data[3], data[2]);
+          int16_t const or_mask = MakeInt16(data[5], data[4]);
+          int16_t &value = holding_registers_[*offset];
+          value = static_cast<int16_t>((value & and_mask) | (or_mask & ~and_mask));
+          response.SetData(data);
+          exception_code = ExceptionCode::kAcknowledge;
+        }
+        break;
+      case FunctionCode::kReadWriteMultRegs: {
+        // Both spans are checked before the write, so the request applies in full or not at all
+        AddressSpan const write_span{static_cast<uint16_t>(MakeInt16(data[5], data[4])),
+                                     static_cast<uint16_t>(MakeInt16(data[7], data[6]))};
+        if (GetOffset(kHoldingRegisters, span).has_value() &&
+            Write(std::span{data}.subspan(kReadWriteValuesIndex), write_span)) {
+          exception_code = Read(holding_registers_, kHoldingRegisters, span, response);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+
+    response.SetExceptionCode(exception_code);
+    return response;
+  }
+
+  // Same contract as RtuSlave::ProcessBatch, without its read grouping: the arrays are small enough to stay cached
+  size_t ProcessBatch(std::span<RtuRequest const> requests, std::span<BatchResponse> responses,
+                      std::pmr::vector<uint8_t> &arena) {
+    size_t const count = std::min(requests.size(), responses.size());
+    for (size_t i = 0; i < count; ++i) {
+      RtuResponse const response = Process(requests[i], arena.get_allocator());
+      auto const &data = response.GetData();
+      responses[i] = {response.GetSlaveId(), response.GetFunctionCode(), response.GetExceptionCode(),
+                      static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(data.size())};
+      arena.insert(arena.end(), data.begin(), data.end());
+    }
+    return count;
+  }
+
+ private:
+  static constexpr size_t kWriteMultipleEchoSize{4};
+  static constexpr size_t kWriteMultipleValuesIndex{5};
+  static constexpr size_t kReadWriteValuesIndex{9};
+
+  template <size_t Size>
+  static ExceptionCode Read(std::array<int16_t, Size> const &registers, AddressSpan range, AddressSpan span,
+                            RtuResponse &response) {
+    auto const offset = GetOffset(range, span);
+    if (!offset.has_value()) {
+      return ExceptionCode::kIllegalDataAddress;
+    }
+    for (size_t i = *offset; i < *offset + span.reg_count; ++i) {
+      response.EmplaceBack(GetHighByte(registers[i]));
+      response.EmplaceBack(GetLowByte(registers[i]));
+    }
+    return ExceptionCode::kAcknowledge;
+  }
+
+  // The request table has already matched the byte count to the span
+  bool Write(std::span<uint8_t const> bytes, AddressSpan span) {
+    auto const offset = GetOffset(kHoldingRegisters, span);
+    if (!offset.has_value()) {
+      return false;
+    }
+    for (size_t i = 0; i < span.reg_count; ++i) {
+      holding_registers_[*offset + i] = MakeInt16(bytes[i * 2 + 1], bytes[i * 2]);
+    }
+    return true;
+  }
+
+  uint8_t id_{1};
+  std::array<int16_t, kHoldingRegisters.reg_count> holding_registers_{};
+  std::array<int16_t, kInputRegisters.reg_count> input_registers_{};
+};
+
+}  // namespace supermb
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "../common/address_span.hpp"
+#include "../rtu/rtu_slave.hpp"
+
+namespace supermb {
+
+// Device config file layout (all integers little-endian):
+//
+//   header:  "SMBDEV" | version (1) | profile count (2) | device count (4)
+//   profile: holding span count (2) | spans | input span count (2) | spans |
+//            holding value count (2) | values | input value count (2) | values
+//   span:    start address (2) | register count (2)
+//   value:   address (2) | value (2)
+//   device:  slave id (1) | profile index (2)
+static constexpr uint8_t kDeviceConfigVersion{1};
+
+struct InitialRegisterValue {
+  uint16_t address{0};
+  int16_t value{0};
+};
+
+// Register layout shared by every device built from it. Values for addresses outside the spans are ignored.
+struct DeviceProfile {
+  std::vector<AddressSpan> holding_registers{};
+  std::vector<AddressSpan> input_registers{};
+  std::vector<InitialRegisterValue> holding_values{};
+  std::vector<InitialRegisterValue> input_values{};
+};
+
+struct DeviceEntry {
+  uint8_t slave_id{1};
+  uint16_t profile{0};
+};
+
+struct DeviceConfig {
+  std::vector<DeviceProfile> profiles{};
+  std::vector<DeviceEntry> devices{};
+};
+
+void EncodeDeviceConfig(DeviceConfig const &config, std::vector<uint8_t> &out);
+
+// Nothing if the bytes are truncated, have trailing data or a device names a profile that does not exist
+[[nodiscard]] std::optional<DeviceConfig> DecodeDeviceConfig(std::span<uint8_t const> bytes);
+[[nodiscard]] std::optional<DeviceConfig> LoadDeviceConfig(std::string const &path);
+
+// Builds one slave per device, in config order, on up to thread_count threads (0 picks one per core). Each profile's
+// registers are built once; its devices start from a snapshot of them, so they share the profile's pages until they
+// write to them and memory grows with the number of profiles rather than devices. Nothing if a device names a
+// profile that does not exist.
+[[nodiscard]] std::optional<std::vector<std::unique_ptr<RtuSlave>>> BuildSlaves(DeviceConfig const &config,
+                                                                                size_t thread_count = 0);
+
+}  // namespace supermb
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <thread>
+#include <vector>
+#include "../common/exception_code.hpp"
+#include "../common/spsc_ring.hpp"
+#include "../rtu/rtu_frame.hpp"
+#include "../rtu/rtu_request.hpp"
+#include "../rtu/rtu_response.hpp"
+#include "../rtu/rtu_slave.hpp"
+
+namespace supermb {
+
+// Thread-per-core runtime for simulating many slaves at once. Slaves are partitioned by id over shard_count worker
+// threads (optionally pinned to one core each); a shard owns its slaves outright, so no slave state is shared between
+// threads. Every client thread talks to every shard through its own pair of SPSC rings, which keeps the whole request
+// path free of locks and of shared writable cache lines.
+//
+// Requests and responses cross the rings as PDU bytes stored in the ring slots, so nothing allocated on one thread is
+// freed on another: a shard works out of its own pool, and Poll rebuilds each response on the client's stack.
+//
+// Requests for a slave id nobody simulates complete with kGatewayTargetDeviceFailedToRespond.
+class SlaveSimulator {
+ public:
+  using ClientId = size_t;
+  using Tag = uint64_t;
+
+  static constexpr size_t kQueueDepth{1024};
+
+  explicit SlaveSimulator(size_t shard_count, bool pin_threads = true);
+  SlaveSimulator(SlaveSimulator const &) = delete;
+  SlaveSimulator &operator=(SlaveSimulator const &) = delete;
+  SlaveSimulator(SlaveSimulator &&) = delete;
+  SlaveSimulator &operator=(SlaveSimulator &&) = delete;
+  ~SlaveSimulator();
+
+  // Setup, before Start. The returned slave belongs to its shard's thread once started.
+  RtuSlave &AddSlave(uint8_t slave_id);
+  // Takes over a prebuilt slave (see BuildSlaves), replacing any slave with the same id
+  RtuSlave &AddSlave(std::unique_ptr<RtuSlave> slave);
+  // Setup, before Start: running shards read the client list without synchronization
+  ClientId AddClient();
+
+  void Start();
+  void Stop();
+
+  [[nodiscard]] size_t GetShardCount() const noexcept { return shards_.size(); }
+  [[nodiscard]] size_t GetShard(uint8_t slave_id) const noexcept { return slave_id % shards_.size(); }
+
+  // Client thread only. Returns false if the owning shard's queue from this client is full, or if the request's data
+  // does not fit in an RTU frame.
+  bool Submit(ClientId client, Tag tag, RtuRequest const &request);
+
+  // Client thread only. Calls handler(tag, response) for every completed request of this client and returns how
+  // many there were. The response's data lives on Poll's stack, so it is only valid during the call; copies of it
+  // allocate normally.
+  template <typename Handler>
+  size_t Poll(ClientId client, Handler &&handler) {
+    size_t completed = 0;
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+      auto &responses = GetChannel(client, shard).responses;
+      for (auto envelope = responses.TryPop(); envelope.has_value(); envelope = responses.TryPop()) {
+        std::array<std::byte, kMaxPduDataSize> buffer;
+        std::pmr::monotonic_buffer_resource memory{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+        RtuResponse response{envelope->slave_id, envelope->function_code, &memory};
+        response.SetExceptionCode(envelope->exception_code);
+        response.SetData(envelope->GetData());
+        handler(envelope->tag, response);
+        ++completed;
+      }
+    }
+    return completed;
+  }
+
+ private:
+  // PDU data of the largest RTU frame: all of it but the slave id, function code and CRC
+  static constexpr size_t kMaxPduDataSize{kMaxRtuFrameSize - 4};
+
+  struct RequestEnvelope {
+    Tag tag{0};
+    RtuRequest::Header header{0, FunctionCode::kInvalid};
+    uint16_t data_size{0};
+    std::array<uint8_t, kMaxPduDataSize> data{};
+
+    [[nodiscard]] std::span<uint8_t const> GetData() const noexcept { return {data.data(), data_size}; }
+  };
+
+  struct ResponseEnvelope {
+    Tag tag{0};
+    uint8_t slave_id{0};
+    FunctionCode function_code{FunctionCode::kInvalid};
+    ExceptionCode exception_code{ExceptionCode::kInvalidExceptionCode};
+    uint16_t data_size{0};
+    std::array<uint8_t, kMaxPduDataSize> data{};
+
+    [[nodiscard]] std::span<uint8_t const> GetData() const noexcept { return {data.data(), data_size}; }
+  };
+
+  struct Channel {
+    SpscRing<RequestEnvelope, kQueueDepth> requests{};
+    SpscRing<ResponseEnvelope, kQueueDepth> responses{};
+  };
+
+  struct Shard {
+    std::array<std::unique_ptr<RtuSlave>, 256> slaves{};
+    // Requests and responses are rebuilt in here while the shard processes them; only its worker thread uses it
+    std::pmr::unsynchronized_pool_resource memory{};
+    std::thread worker{};
+  };
+
+  [[nodiscard]] Channel &GetChannel(ClientId client, size_t shard) {
+    return *channels_[client * shards_.size() + shard];
+  }
+  void RunShard(size_t shard_index);
+  static void Respond(Channel &channel, Tag tag, RtuResponse const &response);
+
+  bool pin_threads_;
+  std::vector<std::unique_ptr<Shard>> shards_{};
+  // One per (client, shard) pair, client major
+  std::vector<std::unique_ptr<Channel>> channels_{};
+  size_t client_count_{0};
+  std::atomic<bool> running_{false};
+};
+
+}  // namespace supermb
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "../rtu/rtu_request.hpp"
+#include "../rtu/rtu_response.hpp"
+
+namespace supermb {
+
+// Modbus TCP application protocol header. length counts the unit id and the PDU.
+struct MbapHeader {
+  uint16_t transaction_id{0};
+  uint16_t protocol_id{0};
+  uint16_t length{0};
+  uint8_t unit_id{0};
+};
+
+static constexpr size_t kMbapHeaderSize{7};
+static constexpr size_t kMaxMbapFrameSize{260};
+
+[[nodiscard]] std::optional<MbapHeader> DecodeMbapHeader(std::span<uint8_t const> bytes) noexcept;
+void EncodeMbapHeader(MbapHeader const &header, std::span<uint8_t, kMbapHeaderSize> out) noexcept;
+
+// Size of the frame starting at bytes once its length field has arrived, for splitting a TCP stream into frames.
+// Returns nothing while fewer than six bytes are available.
+[[nodiscard]] std::optional<size_t> GetMbapFrameSize(std::span<uint8_t const> bytes) noexcept;
+
+void EncodeMbapFrame(uint16_t transaction_id, RtuRequest const &request, std::vector<uint8_t> &out);
+void EncodeMbapFrame(uint16_t transaction_id, RtuResponse const &response, std::vector<uint8_t> &out);
+
+[[nodiscard]] std::optional<std::pair<MbapHeader, RtuRequest>> DecodeMbapRequestFrame(
+    std::span<uint8_t const> frame, RtuRequest::allocator_type allocator = {});
+[[nodiscard]] std::optional<std::pair<MbapHeader, RtuResponse>> DecodeMbapResponseFrame(
+    std::span<uint8_t const> frame, RtuResponse::allocator_type allocator = {});
+
+}  // namespace supermb
@@ -0,0 +1,191 @@
+#include <memory_resource>
+#include <vector>
+#include "ascii/ascii_codec.hpp"
+#include "rtu/rtu_pdu.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace supermb {
+
+static constexpr char kFrameStart{':'};
+static constexpr std::string_view kFrameEnd{"\r\n"};
+// Slave id, function code and LRC
+static constexpr size_t kMinFrameBytes{3};
+static constexpr std::string_view kHexDigits{"0123456789ABCDEF"};
+static constexpr uint8_t kNibbleMask{0x0F};
+static constexpr uint8_t kNibbleBits{4};
+
+static constexpr int8_t HexValue(char hex_char) {
+  if (hex_char >= '0' && hex_char <= '9') {
+    return static_cast<int8_t>(hex_char - '0');
+  }
+  char const lower = static_cast<char>(hex_char | 0x20);
+  if (lower >= 'a' && lower <= 'f') {
+    return static_cast<int8_t>(lower - 'a' + 10);
+  }
+  return -1;
+}
+
+uint8_t EncodeAsciiHex(std::span<uint8_t const> bytes, char *out) noexcept {
+  uint32_t sum = 0;
+  size_t index = 0;
+
+#if defined(__SSE2__)
+  static constexpr size_t kVectorSize{16};
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const nibble_mask = _mm_set1_epi8(kNibbleMask);
+  __m128i const nine = _mm_set1_epi8(9);
+  __m128i const digit_offset = _mm_set1_epi8('0');
+  __m128i const letter_offset = _mm_set1_epi8('A' - '0' - 10);
+  auto const to_hex = [&](__m128i nibbles) {
+    return _mm_add_epi8(_mm_add_epi8(nibbles, digit_offset),
+                        _mm_and_si128(_mm_cmpgt_epi8(nibbles, nine), letter_offset));
+  };
+
+  __m128i sums = zero;
+  for (; index + kVectorSize <= bytes.size(); index += kVectorSize) {
+    __m128i const input = _mm_loadu_si128(reinterpret_cast<__m128i const *>(bytes.data() + index));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(input, zero));
+    __m128i const high = _mm_and_si128(_mm_srli_epi16(input, kNibbleBits), nibble_mask);
+    __m128i const low = _mm_and_si128(input, nibble_mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + index * 2), to_hex(_mm_unpacklo_epi8(high, low)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + index * 2 + kVectorSize), to_hex(_mm_unpackhi_epi8(high, low)));
+  }
+  sum += static_cast<uint32_t>(_mm_cvtsi128_si32(sums)) + static_cast<uint32_t>(_mm_extract_epi16(sums, 4));
+#endif
+
+  for (; index < bytes.size(); ++index) {
+    sum += bytes[index];
+    out[index * 2] = kHexDigits[bytes[index] >> kNibbleBits];
+    out[index * 2 + 1] = kHexDigits[bytes[index] & kNibbleMask];
+  }
+
+  return static_cast<uint8_t>(sum);
+}
+
+std::optional<uint8_t> DecodeAsciiHex(std::string_view hex, uint8_t *out) noexcept {
+  if (hex.size() % 2 != 0) {
+    return {};
+  }
+
+  size_t const byte_count = hex.size() / 2;
+  uint32_t sum = 0;
+  size_t index = 0;
+
+#if defined(__SSE2__)
+  static constexpr size_t kVectorSize{16};
+  static constexpr int kAllLanes{0xFFFF};
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const digit_low = _mm_set1_epi8('0' - 1);
+  __m128i const digit_high = _mm_set1_epi8('9' + 1);
+  __m128i const letter_low = _mm_set1_epi8('a' - 1);
+  __m128i const letter_high = _mm_set1_epi8('f' + 1);
+  __m128i const case_bit = _mm_set1_epi8(0x20);
+  __m128i const digit_offset = _mm_set1_epi8('0');
+  __m128i const letter_offset = _mm_set1_epi8('a' - 10);
+  __m128i const low_byte_mask = _mm_set1_epi16(0x00FF);
+
+  // Nibble values of 16 hex characters, or nothing if any of them is not a hex digit
+  auto const to_nibbles = [&](__m128i chars, bool &valid) {
+    __m128i const is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, digit_low), _mm_cmplt_epi8(chars, digit_high));
+    __m128i const lower = _mm_or_si128(chars, case_bit);
+    __m128i const is_letter = _mm_and_si128(_mm_cmpgt_epi8(lower, letter_low), _mm_cmplt_epi8(lower, letter_high));
+    valid = valid && _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) == kAllLanes;
+    return _mm_or_si128(_mm_and_si128(is_digit, _mm_sub_epi8(chars, digit_offset)),
+                        _mm_and_si128(is_letter, _mm_sub_epi8(lower, letter_offset)));
+  };
+  // Each 16 bit lane holds (high nibble, low nibble) in memory order
+  auto const to_bytes = [&](__m128i nibbles) {
+    return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, low_byte_mask), kNibbleBits),
+                        _mm_srli_epi16(nibbles, 8));
+  };
+
+  __m128i sums = zero;
+  bool valid = true;
+  for (; index + kVectorSize <= byte_count; index += kVectorSize) {
+    __m128i const first = _mm_loadu_si128(reinterpret_cast<__m128i const *>(hex.data() + index * 2));
+    __m128i const second = _mm_loadu_si128(reinterpret_cast<__m128i const *>(hex.data() + index * 2 + kVectorSize));
+    __m128i const output = _mm_packus_epi16(to_bytes(to_nibbles(first, valid)), to_bytes(to_nibbles(second, valid)));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(output, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + index), output);
+  }
+  if (!valid) {
+    return {};
+  }
+  sum += static_cast<uint32_t>(_mm_cvtsi128_si32(sums)) + static_cast<uint32_t>(_mm_extract_epi16(sums, 4));
+#endif
+
+  for (; index < byte_count; ++index) {
+    int8_t const high = HexValue(hex[index * 2]);
+    int8_t const low = HexValue(hex[index * 2 + 1]);
+    if (high < 0 || low < 0) {
+      return {};
+    }
+    out[index] = static_cast<uint8_t>(high << kNibbleBits | low);
+    sum += out[index];
+  }
+
+  return static_cast<uint8_t>(sum);
+}
+
+static std::string EncodeFrame(std::vector<uint8_t> const &adu) {
+  std::string frame(1 + (adu.size() + 1) * 2 + kFrameEnd.size(), kFrameStart);
+  uint8_t const sum = EncodeAsciiHex(adu, frame.data() + 1);
+  uint8_t const lrc = static_cast<uint8_t>(-sum);
+  EncodeAsciiHex({&lrc, 1}, frame.data() + 1 + adu.size() * 2);
+  frame.replace(frame.size() - kFrameEnd.size(), kFrameEnd.size(), kFrameEnd);
+  return frame;
+}
+
+// Returns slave id, PDU and LRC bytes after checking the frame markers and the LRC
+static std::optional<std::pmr::vector<uint8_t>> DecodeFrame(std::string_view frame,
+                                                            std::pmr::polymorphic_allocator<uint8_t> allocator) {
+  if (frame.size() < 1 + kMinFrameBytes * 2 + kFrameEnd.size() || frame.front() != kFrameStart ||
+      !frame.ends_with(kFrameEnd)) {
+    return {};
+  }
+
+  std::string_view const hex = frame.substr(1, frame.size() - 1 - kFrameEnd.size());
+  std::pmr::vector<uint8_t> adu(hex.size() / 2, allocator);
+  auto const sum = DecodeAsciiHex(hex, adu.data());
+  // The LRC is the two's complement of the sum of the other bytes, so the sum over all of them is zero
+  if (!sum.has_value() || sum.value() != 0) {
+    return {};
+  }
+
+  return adu;
+}
+
+std::string EncodeAsciiRequest(RtuRequest const &request) {
+  std::vector<uint8_t> adu{request.GetSlaveId()};
+  EncodeRequestPdu(request, adu);
+  return EncodeFrame(adu);
+}
+
+std::string EncodeAsciiResponse(RtuResponse const &response) {
+  std::vector<uint8_t> adu{response.GetSlaveId()};
+  EncodeResponsePdu(response, adu);
+  return EncodeFrame(adu);
+}
+
+std::optional<RtuRequest> DecodeAsciiRequest(std::string_view frame, RtuRequest::allocator_type allocator) {
+  auto const adu = DecodeFrame(frame, allocator);
+  if (!adu.has_value()) {
+    return {};
+  }
+
+  return DecodeRequestPdu(adu->front(), std::span{adu.value()}.subspan(1, adu->size() - 2), allocator);
+}
+
+std::optional<RtuResponse> DecodeAsciiResponse(std::string_view frame, RtuResponse::allocator_type allocator) {
+  auto const adu = DecodeFrame(frame, allocator);
+  if (!adu.has_value()) {
+    return {};
+  }
+
+  return DecodeResponsePdu(adu->front(), std::span{adu.value()}.subspan(1, adu->size() - 2), allocator);
+}
+
+}  // namespace supermb
@@ -0,0 +1,138 @@
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include "async/async_rtu_master.hpp"
+#include "rtu/rtu_frame.hpp"
+
+namespace supermb {
+
+static constexpr uint8_t kBroadcastSlaveId{0};
+
+static TransactionStatus ToTransactionStatus(WaitResult result) {
+  switch (result) {
+    case WaitResult::kTimeout:
+      return TransactionStatus::kTimeout;
+    case WaitResult::kCancelled:
+      return TransactionStatus::kCancelled;
+    default:
+      return TransactionStatus::kIoError;
+  }
+}
+
+Task<TransactionResult> AsyncRtuMaster::Transact(RtuRequest request, std::chrono::milliseconds timeout,
+                                                 std::stop_token stop) {
+  co_await LineAwaiter{*this};
+  LineLease const lease{*this};
+  if (stop.stop_requested()) {
+    co_return TransactionResult{TransactionStatus::kCancelled};
+  }
+  co_return co_await Exchange(request, timeout, stop);
+}
+
+Task<TransactionResult> AsyncRtuMaster::Exchange(RtuRequest const &request, std::chrono::milliseconds timeout,
+                                                 std::stop_token const &stop) {
+  // Drops what is left of responses to earlier transactions that timed out
+  receive_buffer_.clear();
+  if (!ReadAvailable()) {
+    co_return TransactionResult{TransactionStatus::kIoError};
+  }
+  receive_buffer_.clear();
+
+  transmit_buffer_.clear();
+  EncodeRtuFrame(request, transmit_buffer_);
+  size_t written = 0;
+  while (true) {
+    if (!WriteAvailable(written)) {
+      co_return TransactionResult{TransactionStatus::kIoError};
+    }
+    if (written == transmit_buffer_.size()) {
+      break;
+    }
+    WaitResult const result = co_await loop_.Writable(fd_, EventLoop::Clock::duration::max(), stop);
+    if (result != WaitResult::kReady) {
+      co_return TransactionResult{ToTransactionStatus(result)};
+    }
+  }
+
+  if (request.GetSlaveId() == kBroadcastSlaveId) {
+    co_return TransactionResult{TransactionStatus::kOk};
+  }
+
+  auto const deadline = EventLoop::Clock::now() + timeout;
+  while (true) {
+    if (!ReadAvailable()) {
+      co_return TransactionResult{TransactionStatus::kIoError};
+    }
+    auto const frame_size = GetRtuResponseFrameSize(receive_buffer_);
+    if (frame_size.has_value()) {
+      if (frame_size.value() > kMaxRtuFrameSize) {
+        co_return TransactionResult{TransactionStatus::kInvalidResponse};
+      }
+      if (receive_buffer_.size() >= frame_size.value()) {
+        co_return CheckResponse(request, frame_size.value());
+      }
+    } else if (receive_buffer_.size() >= kMinRtuFrameSize && CheckRtuFrameCrc(receive_buffer_)) {
+      // Unknown length: the first prefix with a good CRC is taken as the frame
+      co_return CheckResponse(request, receive_buffer_.size());
+    } else if (receive_buffer_.size() >= kMaxRtuFrameSize) {
+      co_return TransactionResult{TransactionStatus::kInvalidResponse};
+    }
+
+    WaitResult const result = co_await loop_.Readable(fd_, deadline - EventLoop::Clock::now(), stop);
+    if (result != WaitResult::kReady) {
+      co_return TransactionResult{ToTransactionStatus(result)};
+    }
+  }
+}
+
+void AsyncRtuMaster::ReleaseLine() {
+  if (line_waiters_.empty()) {
+    line_busy_ = false;
+    return;
+  }
+
+  // The line stays busy so a transaction started meanwhile cannot overtake the queued one
+  auto const handle = line_waiters_.front();
+  line_waiters_.pop_front();
+  loop_.Schedule(handle);
+}
+
+bool AsyncRtuMaster::WriteAvailable(size_t &written) {
+  while (written < transmit_buffer_.size()) {
+    ssize_t const count = write(fd_, transmit_buffer_.data() + written, transmit_buffer_.size() - written);
+    if (count > 0) {
+      written += static_cast<size_t>(count);
+    } else if (count < 0 && errno == EINTR) {
+      continue;
+    } else {
+      return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+  }
+  return true;
+}
+
+bool AsyncRtuMaster::ReadAvailable() {
+  std::array<uint8_t, kMaxRtuFrameSize> chunk{};
+  while (receive_buffer_.size() < kMaxRtuFrameSize) {
+    ssize_t const count = read(fd_, chunk.data(), chunk.size());
+    if (count > 0) {
+      receive_buffer_.insert(receive_buffer_.end(), chunk.begin(), chunk.begin() + count);
+    } else if (count < 0 && errno == EINTR) {
+      continue;
+    } else {
+      return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+  }
+  return true;
+}
+
+TransactionResult AsyncRtuMaster::CheckResponse(RtuRequest const &request, size_t frame_size) const {
+  auto response = DecodeRtuResponseFrame({receive_buffer_.data(), frame_size});
+  if (!response.has_value() || response->GetSlaveId() != request.GetSlaveId() ||
+      response->GetFunctionCode() != request.GetFunctionCode()) {
+    return {TransactionStatus::kInvalidResponse};
+  }
+  return {TransactionStatus::kOk, std::move(response)};
+}
+
+}  // namespace supermb
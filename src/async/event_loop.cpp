@@ -0,0 +1,247 @@
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include "async/event_loop.hpp"
+
+namespace supermb {
+
+static constexpr int kMaxEvents{64};
+
+namespace {
+
+// Started on Spawn, destroys itself when the wrapped task finishes
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+DetachedTask RunDetached(Task<void> task, size_t &live_tasks) {
+  co_await task;
+  --live_tasks;
+}
+
+}  // namespace
+
+EventLoop::EventLoop()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  if (IsValid()) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+  }
+}
+
+EventLoop::~EventLoop() {
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+void EventLoop::Spawn(Task<void> task) {
+  ++live_tasks_;
+  RunDetached(std::move(task), live_tasks_);
+}
+
+void EventLoop::Stop() {
+  stop_requested_.store(true, std::memory_order_release);
+  uint64_t const one = 1;
+  [[maybe_unused]] auto const written = write(wake_fd_, &one, sizeof(one));
+}
+
+void EventLoop::Run() {
+  std::array<epoll_event, kMaxEvents> events{};
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    // Handles scheduled while resuming run on the next pass, after I/O had its turn
+    for (size_t ready_count = ready_.size(); ready_count > 0; --ready_count) {
+      auto const handle = ready_.front();
+      ready_.pop_front();
+      handle.resume();
+    }
+    if (live_tasks_ == 0 && ready_.empty()) {
+      break;
+    }
+
+    int const event_count = epoll_wait(epoll_fd_, events.data(), kMaxEvents, ready_.empty() ? GetEpollTimeout() : 0);
+    for (int i = 0; i < event_count; ++i) {
+      if (events[i].data.ptr == nullptr) {
+        uint64_t count = 0;
+        [[maybe_unused]] auto const received = read(wake_fd_, &count, sizeof(count));
+        DrainCancellations();
+      } else {
+        Complete(*static_cast<Waiter *>(events[i].data.ptr), WaitResult::kReady);
+      }
+    }
+    ExpireTimers();
+  }
+  // Lets a later Run start over
+  stop_requested_.store(false, std::memory_order_relaxed);
+}
+
+EventLoop::WaitAwaiter EventLoop::Readable(int fd, Clock::duration timeout, std::stop_token stop) {
+  return Wait(fd, EPOLLIN, timeout, std::move(stop));
+}
+
+EventLoop::WaitAwaiter EventLoop::Writable(int fd, Clock::duration timeout, std::stop_token stop) {
+  return Wait(fd, EPOLLOUT, timeout, std::move(stop));
+}
+
+EventLoop::WaitAwaiter EventLoop::Sleep(Clock::duration duration, std::stop_token stop) {
+  return Wait(-1, 0, duration, std::move(stop));
+}
+
+EventLoop::WaitAwaiter EventLoop::Wait(int fd, uint32_t events, Clock::duration timeout, std::stop_token stop) {
+  auto const now = Clock::now();
+  auto const deadline = timeout >= Clock::time_point::max() - now ? Clock::time_point::max() : now + timeout;
+  return WaitAwaiter{*this, fd, events, deadline, std::move(stop)};
+}
+
+void EventLoop::CancelRequest::operator()() const noexcept {
+  EventLoop &loop = *waiter->loop;
+  {
+    std::lock_guard lock{loop.cancel_mutex_};
+    loop.cancelled_.push_back(waiter);
+  }
+  uint64_t const one = 1;
+  [[maybe_unused]] auto const written = write(loop.wake_fd_, &one, sizeof(one));
+}
+
+void EventLoop::Register(Waiter &waiter) {
+  if (waiter.fd >= 0) {
+    epoll_event event{};
+    event.events = waiter.events | EPOLLONESHOT;
+    event.data.ptr = &waiter;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, waiter.fd, &event) != 0) {
+      waiter.fd = -1;
+      Complete(waiter, WaitResult::kError);
+      return;
+    }
+  }
+  if (waiter.deadline != Clock::time_point::max()) {
+    PushTimer(waiter);
+  }
+  if (waiter.stop.stop_possible()) {
+    // Runs the callback right away if stop was requested after await_ready
+    waiter.stop_callback.emplace(waiter.stop, CancelRequest{&waiter});
+  }
+}
+
+void EventLoop::Complete(Waiter &waiter, WaitResult result) {
+  if (waiter.done) {
+    return;
+  }
+
+  waiter.done = true;
+  waiter.result = result;
+  if (waiter.fd >= 0) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, waiter.fd, nullptr);
+  }
+  RemoveTimer(waiter);
+  // Waits for a callback running on another thread, after which it cannot be queued anymore
+  waiter.stop_callback.reset();
+  {
+    std::lock_guard lock{cancel_mutex_};
+    std::erase(cancelled_, &waiter);
+  }
+  Schedule(waiter.handle);
+}
+
+void EventLoop::DrainCancellations() {
+  std::vector<Waiter *> cancelled;
+  {
+    std::lock_guard lock{cancel_mutex_};
+    cancelled.swap(cancelled_);
+  }
+  for (Waiter *waiter : cancelled) {
+    Complete(*waiter, WaitResult::kCancelled);
+  }
+}
+
+void EventLoop::ExpireTimers() {
+  auto const now = Clock::now();
+  while (!timers_.empty() && timers_.front()->deadline <= now) {
+    Complete(*timers_.front(), WaitResult::kTimeout);
+  }
+}
+
+int EventLoop::GetEpollTimeout() const {
+  if (timers_.empty()) {
+    return -1;
+  }
+  auto const remaining = timers_.front()->deadline - Clock::now();
+  if (remaining <= Clock::duration::zero()) {
+    return 0;
+  }
+  // Rounded up, so a timer is never woken for early and spun on
+  auto const milliseconds = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+  return static_cast<int>(std::min<int64_t>(milliseconds, INT32_MAX));
+}
+
+void EventLoop::PushTimer(Waiter &waiter) {
+  waiter.timer_index = timers_.size();
+  timers_.push_back(&waiter);
+  SiftTimerUp(waiter.timer_index);
+}
+
+void EventLoop::RemoveTimer(Waiter &waiter) {
+  if (waiter.timer_index == kNoTimer) {
+    return;
+  }
+
+  size_t const index = waiter.timer_index;
+  SwapTimers(index, timers_.size() - 1);
+  timers_.pop_back();
+  waiter.timer_index = kNoTimer;
+  if (index < timers_.size()) {
+    SiftTimerUp(index);
+    SiftTimerDown(index);
+  }
+}
+
+void EventLoop::SwapTimers(size_t lhs, size_t rhs) {
+  std::swap(timers_[lhs], timers_[rhs]);
+  timers_[lhs]->timer_index = lhs;
+  timers_[rhs]->timer_index = rhs;
+}
+
+void EventLoop::SiftTimerUp(size_t index) {
+  while (index > 0) {
+    size_t const parent = (index - 1) / 2;
+    if (timers_[parent]->deadline <= timers_[index]->deadline) {
+      break;
+    }
+    SwapTimers(parent, index);
+    index = parent;
+  }
+}
+
+void EventLoop::SiftTimerDown(size_t index) {
+  while (true) {
+    size_t smallest = index;
+    for (size_t const child : {index * 2 + 1, index * 2 + 2}) {
+      if (child < timers_.size() && timers_[child]->deadline < timers_[smallest]->deadline) {
+        smallest = child;
+      }
+    }
+    if (smallest == index) {
+      break;
+    }
+    SwapTimers(smallest, index);
+    index = smallest;
+  }
+}
+
+}  // namespace supermb
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "capture/capture.hpp"
+#include "rtu/rtu_frame.hpp"
+
+namespace supermb {
+
+static constexpr std::array<char, 6> kCaptureMagic{'S', 'M', 'B', 'C', 'A', 'P'};
+static constexpr uint8_t kVarIntContinue{0x80};
+static constexpr uint8_t kVarIntPayloadMask{0x7F};
+static constexpr int kVarIntPayloadBits{7};
+// Enough for any 64 bit value
+static constexpr int kMaxVarIntBytes{10};
+
+static void AppendVarInt(uint64_t value, std::vector<uint8_t> &out) {
+  while (value >= kVarIntContinue) {
+    out.emplace_back(static_cast<uint8_t>(value & kVarIntPayloadMask) | kVarIntContinue);
+    value >>= kVarIntPayloadBits;
+  }
+  out.emplace_back(static_cast<uint8_t>(value));
+}
+
+static std::optional<uint64_t> ReadVarInt(std::istream &in) {
+  uint64_t value = 0;
+  for (int i = 0; i < kMaxVarIntBytes; ++i) {
+    int const byte = in.get();
+    if (byte == std::istream::traits_type::eof()) {
+      return {};
+    }
+    value |= static_cast<uint64_t>(byte & kVarIntPayloadMask) << (kVarIntPayloadBits * i);
+    if ((byte & kVarIntContinue) == 0) {
+      return value;
+    }
+  }
+  return {};
+}
+
+CaptureWriter::CaptureWriter(std::string const &path, CaptureFraming framing)
+    : file_(path, std::ios::binary | std::ios::trunc) {
+  if (!file_) {
+    return;
+  }
+
+  auto const wall_clock_start = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  std::array<char, kCaptureHeaderSize> header{};
+  std::ranges::copy(kCaptureMagic, header.begin());
+  header[kCaptureMagic.size()] = static_cast<char>(kCaptureVersion);
+  header[kCaptureMagic.size() + 1] = static_cast<char>(framing);
+  for (size_t i = 0; i < sizeof(wall_clock_start); ++i) {
+    header[kCaptureMagic.size() + 2 + i] = static_cast<char>(wall_clock_start >> (8 * i));
+  }
+  file_.write(header.data(), header.size());
+
+  start_ = std::chrono::steady_clock::now();
+  running_.store(true, std::memory_order_release);
+  writer_ = std::thread{[this] { Run(); }};
+}
+
+CaptureWriter::~CaptureWriter() {
+  Close();
+}
+
+bool CaptureWriter::Record(CaptureDirection direction, uint8_t port, std::span<uint8_t const> adu) {
+  if (!running_.load(std::memory_order_relaxed) || adu.size() > kMaxCaptureAduSize || records_.Full()) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  CaptureRecord record;
+  record.timestamp = std::chrono::steady_clock::now() - start_;
+  record.direction = direction;
+  record.port = port;
+  record.size = static_cast<uint16_t>(adu.size());
+  std::ranges::copy(adu, record.adu.begin());
+  records_.TryPush(record);
+  pending_signal_.fetch_add(1, std::memory_order_release);
+  pending_signal_.notify_one();
+  return true;
+}
+
+void CaptureWriter::Close() {
+  if (!writer_.joinable()) {
+    return;
+  }
+
+  running_.store(false, std::memory_order_release);
+  pending_signal_.fetch_add(1, std::memory_order_release);
+  pending_signal_.notify_one();
+  writer_.join();
+  file_.close();
+}
+
+void CaptureWriter::Run() {
+  std::vector<uint8_t> encoded;
+  std::chrono::nanoseconds previous_timestamp{0};
+  while (true) {
+    uint32_t const signal = pending_signal_.load(std::memory_order_acquire);
+    auto record = records_.TryPop();
+    if (!record.has_value()) {
+      // Anything pushed before Close is visible here, so stopping on an empty ring loses nothing
+      if (!running_.load(std::memory_order_acquire) && records_.Empty()) {
+        break;
+      }
+      file_.flush();
+      pending_signal_.wait(signal, std::memory_order_acquire);
+      continue;
+    }
+
+    encoded.clear();
+    AppendVarInt(static_cast<uint64_t>(std::max(record->timestamp - previous_timestamp, std::chrono::nanoseconds{0})
+                                           .count()),
+                 encoded);
+    previous_timestamp = std::max(previous_timestamp, record->timestamp);
+    encoded.emplace_back(static_cast<uint8_t>(record->direction));
+    encoded.emplace_back(record->port);
+    AppendVarInt(record->size, encoded);
+    auto const adu = record->GetAdu();
+    encoded.insert(encoded.end(), adu.begin(), adu.end());
+    file_.write(reinterpret_cast<char const *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+  }
+}
+
+std::optional<CaptureReader> CaptureReader::Open(std::string const &path) {
+  std::ifstream file{path, std::ios::binary};
+  std::array<char, kCaptureHeaderSize> header{};
+  if (!file.read(header.data(), header.size()) ||
+      !std::equal(kCaptureMagic.begin(), kCaptureMagic.end(), header.begin()) ||
+      static_cast<uint8_t>(header[kCaptureMagic.size()]) != kCaptureVersion) {
+    return {};
+  }
+
+  auto const framing = static_cast<CaptureFraming>(header[kCaptureMagic.size() + 1]);
+  if (framing != CaptureFraming::kRtu && framing != CaptureFraming::kMbap) {
+    return {};
+  }
+
+  uint64_t wall_clock_start = 0;
+  for (size_t i = 0; i < sizeof(wall_clock_start); ++i) {
+    wall_clock_start |= static_cast<uint64_t>(static_cast<uint8_t>(header[kCaptureMagic.size() + 2 + i])) << (8 * i);
+  }
+  std::chrono::system_clock::time_point const start_time{
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{wall_clock_start})};
+  return CaptureReader{std::move(file), framing, start_time};
+}
+
+std::optional<CaptureRecord> CaptureReader::Next() {
+  auto const delta = ReadVarInt(file_);
+  int const direction = file_.get();
+  int const port = file_.get();
+  auto const size = ReadVarInt(file_);
+  if (!delta.has_value() || !size.has_value() || size.value() > kMaxCaptureAduSize ||
+      (direction != static_cast<int>(CaptureDirection::kReceived) &&
+       direction != static_cast<int>(CaptureDirection::kSent)) ||
+      port == std::istream::traits_type::eof()) {
+    return {};
+  }
+
+  CaptureRecord record;
+  timestamp_ += std::chrono::nanoseconds{delta.value()};
+  record.timestamp = timestamp_;
+  record.direction = static_cast<CaptureDirection>(direction);
+  record.port = static_cast<uint8_t>(port);
+  record.size = static_cast<uint16_t>(size.value());
+  if (!file_.read(reinterpret_cast<char *>(record.adu.data()), record.size)) {
+    return {};
+  }
+  return record;
+}
+
+size_t Replay(CaptureReader &reader, double speed, ReplaySink const &sink) {
+  size_t replayed = 0;
+  auto const replay_start = std::chrono::steady_clock::now();
+  std::optional<std::chrono::nanoseconds> first_timestamp;
+  for (auto record = reader.Next(); record.has_value(); record = reader.Next()) {
+    if (!first_timestamp.has_value()) {
+      first_timestamp = record->timestamp;
+    }
+    if (speed > 0.0) {
+      std::chrono::duration<double, std::nano> const offset = (record->timestamp - first_timestamp.value()) / speed;
+      std::this_thread::sleep_until(replay_start +
+                                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+    }
+    sink(record.value());
+    ++replayed;
+  }
+  return replayed;
+}
+
+SlaveReplayResult ReplayIntoSlave(CaptureReader &reader, RtuSlave &slave, double speed) {
+  SlaveReplayResult result;
+  CaptureFraming const framing = reader.GetFraming();
+  std::unordered_map<uint8_t, std::deque<std::vector<uint8_t>>> replayed_responses;
+  std::vector<uint8_t> response_frame;
+  Replay(reader, speed, [&](CaptureRecord const &record) {
+    auto &port_responses = replayed_responses[record.port];
+    if (record.direction == CaptureDirection::kSent) {
+      if (port_responses.empty()) {
+        return;
+      }
+      auto const adu = record.GetAdu();
+      if (!std::ranges::equal(port_responses.front(), adu)) {
+        ++result.mismatches;
+      }
+      port_responses.pop_front();
+      return;
+    }
+
+    response_frame.clear();
+    if (framing == CaptureFraming::kRtu) {
+      auto const request = DecodeRtuRequestFrame(record.GetAdu());
+      if (!request.has_value()) {
+        ++result.undecodable;
+        return;
+      }
+      // Requests to other slaves on the same bus
+      if (request->GetSlaveId() != slave.GetId()) {
+        return;
+      }
+      EncodeRtuFrame(slave.Process(request.value()), response_frame);
+    } else {
+      auto const request = DecodeMbapRequestFrame(record.GetAdu());
+      if (!request.has_value()) {
+        ++result.undecodable;
+        return;
+      }
+      EncodeMbapFrame(request->first.transaction_id, slave.Process(request->second), response_frame);
+    }
+    ++result.requests;
+    port_responses.push_back(response_frame);
+  });
+  return result;
+}
+
+}  // namespace supermb
@@ -0,0 +1,69 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "common/mapped_file.hpp"
+
+namespace supermb {
+
+std::optional<MappedFile> MappedFile::Open(std::string const &path) {
+  int const file_descriptor = open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (file_descriptor < 0) {
+    return {};
+  }
+
+  struct stat file_stat {};
+  if (fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(file_descriptor);
+    return {};
+  }
+
+  auto const size = static_cast<size_t>(file_stat.st_size);
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+  if (data == MAP_FAILED) {
+    close(file_descriptor);
+    return {};
+  }
+
+  return MappedFile{file_descriptor, static_cast<uint8_t *>(data), size};
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : file_descriptor_(std::exchange(other.file_descriptor_, -1)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    Reset();
+    file_descriptor_ = std::exchange(other.file_descriptor_, -1);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  Reset();
+}
+
+bool MappedFile::Sync() {
+  return data_ != nullptr && msync(data_, size_, MS_SYNC) == 0;
+}
+
+void MappedFile::Reset() noexcept {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  if (file_descriptor_ >= 0) {
+    close(file_descriptor_);
+    file_descriptor_ = -1;
+  }
+}
+
+}  // namespace supermb
@@ -0,0 +1,44 @@
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <array>
+#include "common/realtime.hpp"
+
+namespace supermb {
+
+// Touching one byte per page is enough to fault it in
+static constexpr size_t kPageStride{4096};
+
+// Not inlined, so the stack frame it faults in really is below the caller's
+[[gnu::noinline]] static void PrefaultStack() {
+  std::array<volatile unsigned char, kPrefaultStackSize> stack;
+  for (size_t i = 0; i < stack.size(); i += kPageStride) {
+    stack[i] = 0;
+  }
+}
+
+RealtimeStatus ApplyRealtimeConfig(RealtimeConfig const &config) {
+  RealtimeStatus status;
+  if (config.fifo_priority > 0) {
+    sched_param param{};
+    param.sched_priority = config.fifo_priority;
+    status.scheduling = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+  }
+  if (config.cpu >= CPU_SETSIZE) {
+    status.affinity = false;
+  } else if (config.cpu >= 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(config.cpu, &cpu_set);
+    status.affinity = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+  }
+  if (config.lock_memory) {
+    status.memory_locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+  }
+  if (config.prefault_stack) {
+    PrefaultStack();
+  }
+  return status;
+}
+
+}  // namespace supermb
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include "gateway/read_cache.hpp"
+
+namespace supermb {
+
+static bool Contains(AddressSpan outer, AddressSpan inner) {
+  return inner.start_address >= outer.start_address &&
+         inner.start_address + inner.reg_count <= outer.start_address + outer.reg_count;
+}
+
+std::optional<std::chrono::milliseconds> ReadCache::GetTtl(uint8_t unit_id, FunctionCode function_code,
+                                                           AddressSpan span) const noexcept {
+  if (span.reg_count == 0 || span.reg_count > kMaxRegisters) {
+    return {};
+  }
+
+  for (auto const &range : ranges_) {
+    if (range.unit_id == unit_id && range.function_code == function_code && Contains(range.span, span)) {
+      return range.ttl;
+    }
+  }
+
+  return {};
+}
+
+bool ReadCache::Lookup(uint8_t unit_id, FunctionCode function_code, AddressSpan span, Clock::time_point now,
+                       std::span<uint8_t> out) const noexcept {
+  for (auto const &entry : entries_) {
+    if (entry.valid && entry.expiry > now && entry.unit_id == unit_id && entry.function_code == function_code &&
+        Contains(entry.span, span)) {
+      size_t const offset = static_cast<size_t>(span.start_address - entry.span.start_address) * 2;
+      std::copy_n(entry.register_bytes.begin() + static_cast<std::ptrdiff_t>(offset), span.reg_count * 2, out.begin());
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ReadCache::Insert(uint8_t unit_id, FunctionCode function_code, AddressSpan span,
+                       std::span<uint8_t const> register_bytes, Clock::time_point now) noexcept {
+  auto const ttl = GetTtl(unit_id, function_code, span);
+  if (!ttl.has_value() || register_bytes.size() != static_cast<size_t>(span.reg_count) * 2) {
+    return;
+  }
+
+  // Replace the same key if present, otherwise a free or expired entry, otherwise the one closest to expiring
+  Entry *target = &entries_[0];
+  for (auto &entry : entries_) {
+    if (entry.valid && entry.unit_id == unit_id && entry.function_code == function_code &&
+        entry.span.start_address == span.start_address && entry.span.reg_count == span.reg_count) {
+      target = &entry;
+      break;
+    }
+    if (!entry.valid || entry.expiry <= now) {
+      target = &entry;
+    } else if (target->valid && target->expiry > now && entry.expiry < target->expiry) {
+      target = &entry;
+    }
+  }
+
+  target->valid = true;
+  target->unit_id = unit_id;
+  target->function_code = function_code;
+  target->span = span;
+  target->expiry = now + ttl.value();
+  std::ranges::copy(register_bytes, target->register_bytes.begin());
+}
+
+void ReadCache::Invalidate(uint8_t unit_id, FunctionCode function_code, AddressSpan span) noexcept {
+  for (auto &entry : entries_) {
+    if (entry.valid && entry.unit_id == unit_id && entry.function_code == function_code && Overlaps(entry.span, span)) {
+      entry.valid = false;
+    }
+  }
+}
+
+}  // namespace supermb
@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <utility>
+#include "common/byte_helpers.hpp"
+#include "common/function_code_info.hpp"
+#include "gateway/rtu_gateway.hpp"
+
+namespace supermb {
+
+static constexpr uint8_t kExceptionFunctionFlag{0x80};
+static constexpr uint8_t kFunctionCodeMask{0x7F};
+static constexpr size_t kMinMbapRequestSize{kMbapHeaderSize + 1};
+static constexpr size_t kExceptionFrameSize{kMbapHeaderSize + 2};
+static constexpr size_t kExceptionPduSize{2};
+// Unit id and exception PDU
+static constexpr uint16_t kExceptionLength{3};
+static constexpr size_t kCrcSize{2};
+static constexpr size_t kUnitIdIndex{6};
+static constexpr size_t kFunctionCodeIndex{7};
+static constexpr size_t kRequestDataIndex{8};
+// Function code and byte count ahead of the register bytes of a read response
+static constexpr size_t kReadResponseHeaderSize{2};
+
+RtuGateway::RtuGateway(RtuGatewayConfig config, ResponseHandler response_handler)
+    : config_(std::move(config)),
+      response_handler_(std::move(response_handler)) {
+  routes_.fill(kNoRoute);
+}
+
+RtuGateway::~RtuGateway() {
+  Stop();
+}
+
+size_t RtuGateway::AddSerialLine(std::unique_ptr<SerialLine> serial_line) {
+  auto line = std::make_unique<Line>();
+  line->serial_line = std::move(serial_line);
+  for (uint16_t i = 0; i < kLineQueueDepth; ++i) {
+    line->free_transactions.TryPush(i);
+  }
+  if (!config_.read_cache_ranges.empty()) {
+    line->read_cache.emplace(config_.read_cache_ranges);
+  }
+
+  lines_.emplace_back(std::move(line));
+  return lines_.size() - 1;
+}
+
+void RtuGateway::RouteUnit(uint8_t unit_id, size_t line_index) {
+  routes_[unit_id] = static_cast<int16_t>(line_index);
+}
+
+void RtuGateway::Start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+
+  for (auto &line : lines_) {
+    line->worker = std::thread{[this, &line = *line] { RunLine(line); }};
+  }
+  expiry_worker_ = std::thread{[this] { RunExpiry(); }};
+}
+
+void RtuGateway::Stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+
+  {
+    // Taken so the timer cannot miss the notification between checking running_ and waiting
+    std::lock_guard const lock{expiry_mutex_};
+  }
+  expiry_cv_.notify_all();
+  expiry_worker_.join();
+  for (auto &line : lines_) {
+    line->pending_signal.fetch_add(1, std::memory_order_release);
+    line->pending_signal.notify_one();
+    line->worker.join();
+  }
+}
+
+bool RtuGateway::Submit(ConnectionId connection, std::span<uint8_t const> mbap_frame) {
+  auto const header = DecodeMbapHeader(mbap_frame);
+  if (!header.has_value() || mbap_frame.size() < kMinMbapRequestSize || mbap_frame.size() > kMaxMbapFrameSize ||
+      header->protocol_id != 0 || header->length + kMbapHeaderSize - 1 != mbap_frame.size()) {
+    return false;
+  }
+
+  int16_t const line_index = routes_[header->unit_id];
+  if (line_index == kNoRoute) {
+    SendException(connection, mbap_frame, ExceptionCode::kGatewayPathUnavailable);
+    return true;
+  }
+
+  Line &line = *lines_[line_index];
+  auto const register_access = line.read_cache.has_value() ? GetRegisterAccess(mbap_frame) : std::nullopt;
+  if (register_access.has_value()) {
+    if (register_access->is_write) {
+      std::lock_guard const lock{line.cache_mutex};
+      line.read_cache->Invalidate(header->unit_id, register_access->function_code, register_access->span);
+      DetachInFlightReads(line, header->unit_id, register_access.value());
+    } else if (TryServeFromCache(line, connection, mbap_frame, register_access.value())) {
+      return true;
+    }
+  }
+
+  auto const transaction_index = line.free_transactions.TryPop();
+  if (!transaction_index.has_value()) {
+    SendException(connection, mbap_frame, ExceptionCode::kGatewayPathUnavailable);
+    return true;
+  }
+
+  Transaction &transaction = line.transactions[transaction_index.value()];
+  transaction.connection = connection;
+  transaction.queue_deadline.store((Clock::now() + config_.queue_timeout).time_since_epoch().count(),
+                                   std::memory_order_relaxed);
+  transaction.register_access = register_access;
+  transaction.cacheable_read =
+      register_access.has_value() && !register_access->is_write &&
+      line.read_cache->GetTtl(header->unit_id, register_access->function_code, register_access->span).has_value();
+  transaction.next_waiter = kNoTransaction;
+  transaction.size = mbap_frame.size();
+  std::ranges::copy(mbap_frame, transaction.frame.begin());
+
+  if (transaction.cacheable_read) {
+    std::lock_guard const lock{line.cache_mutex};
+    int16_t waiter = FindInFlightRead(line, transaction);
+    if (waiter != kNoTransaction) {
+      while (line.transactions[waiter].next_waiter != kNoTransaction) {
+        waiter = line.transactions[waiter].next_waiter;
+      }
+      line.transactions[waiter].next_waiter = static_cast<int16_t>(transaction_index.value());
+      transaction.state.store(TransactionState::kWaiting, std::memory_order_relaxed);
+      return true;
+    }
+    transaction.in_flight_read = true;
+    transaction.overtaken_by_write = false;
+  }
+
+  transaction.state.store(TransactionState::kQueued, std::memory_order_release);
+  line.pending_transactions.TryPush(transaction_index.value());
+  line.pending_signal.fetch_add(1, std::memory_order_release);
+  line.pending_signal.notify_one();
+  return true;
+}
+
+std::optional<RtuGateway::RegisterAccess> RtuGateway::GetRegisterAccess(std::span<uint8_t const> mbap_frame) {
+  auto const function_code = static_cast<FunctionCode>(mbap_frame[kFunctionCodeIndex]);
+  auto const data = mbap_frame.subspan(kRequestDataIndex);
+  // Spans are trusted from here on, by the cache lookup and by in-flight read matching; a malformed request goes to
+  // the bus untouched and the slave answers it
+  if (!IsRequestDataValid(function_code, data)) {
+    return {};
+  }
+  auto const read_word = [&data](size_t index) {
+    return static_cast<uint16_t>(MakeInt16(data[index + 1], data[index]));
+  };
+
+  RegisterAccess register_access;
+  register_access.function_code = FunctionCode::kReadHR;
+  register_access.is_write = true;
+  switch (function_code) {
+    case FunctionCode::kReadHR:
+    case FunctionCode::kReadIR:
+      register_access.function_code = function_code;
+      register_access.span = {read_word(0), read_word(2)};
+      register_access.is_write = false;
+      return register_access;
+    case FunctionCode::kWriteSingleReg:
+    case FunctionCode::kMaskWriteReg:
+      register_access.span = {read_word(0), 1};
+      return register_access;
+    case FunctionCode::kWriteMultRegs:
+      register_access.span = {read_word(0), read_word(2)};
+      return register_access;
+    case FunctionCode::kReadWriteMultRegs:
+      register_access.span = {read_word(4), read_word(6)};
+      return register_access;
+    default:
+      return {};
+  }
+}
+
+bool RtuGateway::TryServeFromCache(Line &line, ConnectionId connection, std::span<uint8_t const> mbap_frame,
+                                   RegisterAccess const &register_access) {
+  std::array<uint8_t, kMaxMbapFrameSize> frame{};
+  size_t const byte_count = static_cast<size_t>(register_access.span.reg_count) * 2;
+  {
+    std::lock_guard const lock{line.cache_mutex};
+    if (!line.read_cache->Lookup(mbap_frame[kUnitIdIndex], register_access.function_code, register_access.span,
+                                 Clock::now(), std::span{frame}.subspan(kMbapHeaderSize + 2, byte_count))) {
+      return false;
+    }
+  }
+
+  auto const length = static_cast<uint16_t>(1 + kReadResponseHeaderSize + byte_count);
+  std::copy_n(mbap_frame.begin(), kMbapHeaderSize, frame.begin());
+  frame[4] = GetHighByte(length);
+  frame[5] = GetLowByte(length);
+  frame[kFunctionCodeIndex] = mbap_frame[kFunctionCodeIndex];
+  frame[kFunctionCodeIndex + 1] = static_cast<uint8_t>(byte_count);
+  response_handler_(connection, std::span{frame}.first(kMbapHeaderSize + kReadResponseHeaderSize + byte_count));
+  return true;
+}
+
+int16_t RtuGateway::FindInFlightRead(Line const &line, Transaction const &transaction) {
+  for (size_t i = 0; i < kLineQueueDepth; ++i) {
+    Transaction const &other = line.transactions[i];
+    if (other.in_flight_read && other.frame[kUnitIdIndex] == transaction.frame[kUnitIdIndex] &&
+        other.register_access->function_code == transaction.register_access->function_code &&
+        other.register_access->span.start_address == transaction.register_access->span.start_address &&
+        other.register_access->span.reg_count == transaction.register_access->span.reg_count) {
+      return static_cast<int16_t>(i);
+    }
+  }
+
+  return kNoTransaction;
+}
+
+// A read queued before this write returns the old values, so later reads must not join it and its response must not
+// be cached. Its waiters stay.
+void RtuGateway::DetachInFlightReads(Line &line, uint8_t unit_id, RegisterAccess const &write) {
+  for (Transaction &transaction : line.transactions) {
+    if (transaction.in_flight_read && transaction.frame[kUnitIdIndex] == unit_id &&
+        transaction.register_access->function_code == write.function_code &&
+        Overlaps(transaction.register_access->span, write.span)) {
+      transaction.in_flight_read = false;
+      transaction.overtaken_by_write = true;
+    }
+  }
+}
+
+void RtuGateway::RunLine(Line &line) {
+  std::array<uint8_t, kMaxRtuFrameSize> request_adu{};
+  std::array<uint8_t, kMaxRtuFrameSize> response_adu{};
+
+  while (running_.load(std::memory_order_acquire)) {
+    uint32_t const signal = line.pending_signal.load(std::memory_order_acquire);
+    auto const transaction_index = line.pending_transactions.TryPop();
+    if (!transaction_index.has_value()) {
+      line.pending_signal.wait(signal, std::memory_order_acquire);
+      continue;
+    }
+
+    if (!TakeQueued(line, transaction_index.value())) {
+      continue;
+    }
+
+    Transaction &transaction = line.transactions[transaction_index.value()];
+    uint8_t const function_code = transaction.frame[kFunctionCodeIndex];
+    std::array<uint8_t, kExceptionPduSize> const failure_pdu{
+        static_cast<uint8_t>(function_code | kExceptionFunctionFlag),
+        static_cast<uint8_t>(ExceptionCode::kGatewayTargetDeviceFailedToRespond)};
+    // The timer may not have caught it yet
+    if (Clock::now().time_since_epoch().count() > transaction.queue_deadline.load(std::memory_order_relaxed)) {
+      Finish(line, transaction_index.value(), failure_pdu);
+      continue;
+    }
+
+    // The RTU request is the unit id and PDU of the MBAP frame plus a CRC
+    size_t const request_size = transaction.size - kUnitIdIndex;
+    std::copy_n(transaction.frame.begin() + kUnitIdIndex, request_size, request_adu.begin());
+    uint16_t const crc = ComputeCrc16({request_adu.data(), request_size});
+    request_adu[request_size] = GetLowByte(crc);
+    request_adu[request_size + 1] = GetHighByte(crc);
+
+    size_t const response_size = line.serial_line->Transact({request_adu.data(), request_size + kCrcSize},
+                                                            response_adu, config_.response_timeout);
+    std::span<uint8_t const> const response{response_adu.data(), response_size};
+    if (!CheckRtuFrameCrc(response) || response[0] != request_adu[0] ||
+        (response[1] & kFunctionCodeMask) != function_code) {
+      Finish(line, transaction_index.value(), failure_pdu);
+      continue;
+    }
+
+    Finish(line, transaction_index.value(), response.subspan(1, response_size - 1 - kCrcSize));
+  }
+}
+
+// Moves a dequeued transaction to kSending. One the timer expired has been answered already, together with its
+// waiters; it is recycled instead and false is returned.
+bool RtuGateway::TakeQueued(Line &line, uint16_t transaction_index) {
+  Transaction &transaction = line.transactions[transaction_index];
+  while (true) {
+    auto state = TransactionState::kQueued;
+    if (transaction.state.compare_exchange_weak(state, TransactionState::kSending, std::memory_order_acquire)) {
+      return true;
+    }
+    if (state == TransactionState::kExpired) {
+      break;
+    }
+    // kExpiring: the timer is checking or answering it right now
+    std::this_thread::yield();
+  }
+
+  int16_t waiter = transaction.next_waiter;
+  transaction.state.store(TransactionState::kFree, std::memory_order_relaxed);
+  line.free_transactions.TryPush(transaction_index);
+  while (waiter != kNoTransaction) {
+    auto const waiter_index = static_cast<uint16_t>(waiter);
+    waiter = line.transactions[waiter_index].next_waiter;
+    line.transactions[waiter_index].state.store(TransactionState::kFree, std::memory_order_relaxed);
+    line.free_transactions.TryPush(waiter_index);
+  }
+  return false;
+}
+
+void RtuGateway::RunExpiry() {
+  std::unique_lock lock{expiry_mutex_};
+  while (!expiry_cv_.wait_for(lock, kExpiryInterval, [this] { return !running_.load(std::memory_order_acquire); })) {
+    lock.unlock();
+    for (auto &line : lines_) {
+      ExpireQueued(*line, Clock::now());
+    }
+    lock.lock();
+  }
+}
+
+// Answers queued transactions past their deadline, and the reads waiting on them, with
+// kGatewayTargetDeviceFailedToRespond. The worker recycles them when it reaches them in the queue.
+void RtuGateway::ExpireQueued(Line &line, Clock::time_point now) {
+  Clock::rep const now_ticks = now.time_since_epoch().count();
+  for (Transaction &transaction : line.transactions) {
+    if (transaction.state.load(std::memory_order_relaxed) != TransactionState::kQueued ||
+        now_ticks <= transaction.queue_deadline.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    auto state = TransactionState::kQueued;
+    if (!transaction.state.compare_exchange_strong(state, TransactionState::kExpiring, std::memory_order_acquire)) {
+      continue;
+    }
+    // Checked again now that the worker cannot recycle it: the deadline read above may belong to an earlier use
+    if (now_ticks <= transaction.queue_deadline.load(std::memory_order_relaxed)) {
+      transaction.state.store(TransactionState::kQueued, std::memory_order_release);
+      continue;
+    }
+
+    int16_t waiter = kNoTransaction;
+    if (transaction.cacheable_read) {
+      std::lock_guard const lock{line.cache_mutex};
+      transaction.in_flight_read = false;
+      waiter = transaction.next_waiter;
+    }
+    SendException(transaction.connection, {transaction.frame.data(), transaction.size},
+                  ExceptionCode::kGatewayTargetDeviceFailedToRespond);
+    while (waiter != kNoTransaction) {
+      Transaction const &waiting = line.transactions[waiter];
+      SendException(waiting.connection, {waiting.frame.data(), waiting.size},
+                    ExceptionCode::kGatewayTargetDeviceFailedToRespond);
+      waiter = waiting.next_waiter;
+    }
+    transaction.state.store(TransactionState::kExpired, std::memory_order_release);
+  }
+}
+
+void RtuGateway::Finish(Line &line, uint16_t transaction_index, std::span<uint8_t const> response_pdu) {
+  Transaction &transaction = line.transactions[transaction_index];
+  int16_t waiter = kNoTransaction;
+  if (transaction.register_access.has_value()) {
+    RegisterAccess const &register_access = transaction.register_access.value();
+    uint8_t const unit_id = transaction.frame[kUnitIdIndex];
+    std::lock_guard const lock{line.cache_mutex};
+    if (register_access.is_write) {
+      // Again on completion, so nothing cached while this write was queued outlives it
+      line.read_cache->Invalidate(unit_id, register_access.function_code, register_access.span);
+    } else if (transaction.cacheable_read) {
+      size_t const byte_count = static_cast<size_t>(register_access.span.reg_count) * 2;
+      if (!transaction.overtaken_by_write && response_pdu.size() == kReadResponseHeaderSize + byte_count &&
+          response_pdu[1] == byte_count && (response_pdu[0] & kExceptionFunctionFlag) == 0) {
+        line.read_cache->Insert(unit_id, register_access.function_code, register_access.span,
+                                response_pdu.subspan(kReadResponseHeaderSize), Clock::now());
+      }
+      waiter = transaction.next_waiter;
+      transaction.in_flight_read = false;
+    }
+  }
+
+  Respond(line, transaction_index, response_pdu);
+  while (waiter != kNoTransaction) {
+    auto const waiter_index = static_cast<uint16_t>(waiter);
+    waiter = line.transactions[waiter_index].next_waiter;
+    Respond(line, waiter_index, response_pdu);
+  }
+}
+
+void RtuGateway::Respond(Line &line, uint16_t transaction_index, std::span<uint8_t const> response_pdu) {
+  // Reuse the MBAP header of the request; only the length changes
+  Transaction &transaction = line.transactions[transaction_index];
+  auto const length = static_cast<uint16_t>(response_pdu.size() + 1);
+  transaction.frame[4] = GetHighByte(length);
+  transaction.frame[5] = GetLowByte(length);
+  std::ranges::copy(response_pdu, transaction.frame.begin() + kMbapHeaderSize);
+  transaction.size = kMbapHeaderSize + response_pdu.size();
+  response_handler_(transaction.connection, {transaction.frame.data(), transaction.size});
+  transaction.state.store(TransactionState::kFree, std::memory_order_relaxed);
+  line.free_transactions.TryPush(transaction_index);
+}
+
+void RtuGateway::SendException(ConnectionId connection, std::span<uint8_t const> request_frame,
+                               ExceptionCode exception_code) {
+  std::array<uint8_t, kExceptionFrameSize> frame{};
+  std::copy_n(request_frame.begin(), kMbapHeaderSize, frame.begin());
+  frame[4] = GetHighByte(kExceptionLength);
+  frame[5] = GetLowByte(kExceptionLength);
+  frame[kMbapHeaderSize] = request_frame[kMbapHeaderSize] | kExceptionFunctionFlag;
+  frame[kMbapHeaderSize + 1] = static_cast<uint8_t>(exception_code);
+  response_handler_(connection, frame);
+}
+
+}  // namespace supermb
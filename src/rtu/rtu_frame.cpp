@@ -0,0 +1,181 @@
+#include <array>
+#include <utility>
+#include "common/byte_helpers.hpp"
+#include "common/function_code.hpp"
+#include "common/function_code_info.hpp"
+#include "rtu/rtu_frame.hpp"
+#include "rtu/rtu_pdu.hpp"
+
+namespace supermb {
+
+static constexpr uint16_t kCrcPolynomial{0xA001};
+static constexpr uint16_t kCrcInitialValue{0xFFFF};
+static constexpr size_t kCrcSize{2};
+static constexpr uint8_t kExceptionFunctionFlag{0x80};
+// Slave id and function code
+static constexpr size_t kFrameHeaderSize{2};
+
+static constexpr std::array<uint16_t, 256> kCrcTable{[] {
+  std::array<uint16_t, 256> table{};
+  for (size_t i = 0; i < table.size(); ++i) {
+    auto crc = static_cast<uint16_t>(i);
+    for (int bit = 0; bit < kBitsPerByte; ++bit) {
+      crc = (crc & 1) != 0 ? static_cast<uint16_t>((crc >> 1) ^ kCrcPolynomial) : static_cast<uint16_t>(crc >> 1);
+    }
+    table[i] = crc;
+  }
+  return table;
+}()};
+
+uint16_t ComputeCrc16(std::span<uint8_t const> bytes) noexcept {
+  uint16_t crc = kCrcInitialValue;
+  for (uint8_t const byte : bytes) {
+    crc = static_cast<uint16_t>((crc >> kBitsPerByte) ^ kCrcTable[(crc ^ byte) & kMaxByte]);
+  }
+  return crc;
+}
+
+bool CheckRtuFrameCrc(std::span<uint8_t const> frame) noexcept {
+  if (frame.size() < kMinRtuFrameSize) {
+    return false;
+  }
+
+  uint16_t const crc = ComputeCrc16(frame.first(frame.size() - kCrcSize));
+  return frame[frame.size() - 2] == GetLowByte(crc) && frame[frame.size() - 1] == GetHighByte(crc);
+}
+
+static void AppendCrc(std::vector<uint8_t> &out, size_t frame_start) {
+  uint16_t const crc = ComputeCrc16(std::span{out}.subspan(frame_start));
+  out.emplace_back(GetLowByte(crc));
+  out.emplace_back(GetHighByte(crc));
+}
+
+std::optional<size_t> GetRtuResponseFrameSize(std::span<uint8_t const> bytes) noexcept {
+  if (bytes.size() < kFrameHeaderSize) {
+    return {};
+  }
+  // Exception code
+  if ((bytes[1] & kExceptionFunctionFlag) != 0) {
+    return kFrameHeaderSize + 1 + kCrcSize;
+  }
+
+  switch (static_cast<FunctionCode>(bytes[1])) {
+    case FunctionCode::kReadCoils:
+    case FunctionCode::kReadDI:
+    case FunctionCode::kReadHR:
+    case FunctionCode::kReadIR:
+    case FunctionCode::kGetComEventLog:
+    case FunctionCode::kReportSlaveID:
+    case FunctionCode::kReadFileRecord:
+    case FunctionCode::kWriteFileRecord:
+    case FunctionCode::kReadWriteMultRegs:
+      // One byte count
+      if (bytes.size() < kFrameHeaderSize + 1) {
+        return {};
+      }
+      return kFrameHeaderSize + 1 + bytes[2] + kCrcSize;
+    case FunctionCode::kReadFIFOQueue:
+      // Two byte count
+      if (bytes.size() < kFrameHeaderSize + 2) {
+        return {};
+      }
+      return kFrameHeaderSize + 2 + static_cast<uint16_t>(MakeInt16(bytes[3], bytes[2])) + kCrcSize;
+    case FunctionCode::kReadExceptionStatus:
+      return kFrameHeaderSize + 1 + kCrcSize;
+    case FunctionCode::kWriteSingleCoil:
+    case FunctionCode::kWriteSingleReg:
+    case FunctionCode::kGetComEventCounter:
+    case FunctionCode::kWriteMultCoils:
+    case FunctionCode::kWriteMultRegs:
+      return kFrameHeaderSize + 4 + kCrcSize;
+    case FunctionCode::kMaskWriteReg:
+      return kFrameHeaderSize + 6 + kCrcSize;
+    default:
+      return {};
+  }
+}
+
+std::optional<size_t> GetRtuRequestFrameSize(std::span<uint8_t const> bytes) noexcept {
+  if (bytes.size() < kFrameHeaderSize) {
+    return {};
+  }
+  FunctionCodeInfo const &info = GetFunctionCodeInfo(static_cast<FunctionCode>(bytes[1]));
+  if (info.fixed_size) {
+    return kFrameHeaderSize + info.min_size + kCrcSize;
+  }
+  // Diagnostics and unknown function codes have no byte count to go by
+  size_t const byte_count_offset = kFrameHeaderSize + info.byte_count_index;
+  if (info.byte_count_index == kNoFieldIndex || bytes.size() <= byte_count_offset) {
+    return {};
+  }
+  return byte_count_offset + 1 + bytes[byte_count_offset] + kCrcSize;
+}
+
+void EncodeRtuFrame(RtuRequest const &request, std::vector<uint8_t> &out) {
+  size_t const frame_start = out.size();
+  out.emplace_back(request.GetSlaveId());
+  EncodeRequestPdu(request, out);
+  AppendCrc(out, frame_start);
+}
+
+void EncodeRtuFrame(RtuResponse const &response, std::vector<uint8_t> &out) {
+  size_t const frame_start = out.size();
+  out.emplace_back(response.GetSlaveId());
+  EncodeResponsePdu(response, out);
+  AppendCrc(out, frame_start);
+}
+
+// Checks size and CRC, returns the PDU
+static ModbusResult<std::span<uint8_t const>> GetRtuFramePdu(std::span<uint8_t const> frame) {
+  if (frame.size() < kMinRtuFrameSize) {
+    return Unexpected{ModbusError{ModbusErrorKind::kFrameLength}};
+  }
+  if (!CheckRtuFrameCrc(frame)) {
+    return Unexpected{ModbusError{ModbusErrorKind::kCrc, static_cast<FunctionCode>(frame[1])}};
+  }
+  return frame.subspan(1, frame.size() - 1 - kCrcSize);
+}
+
+ModbusResult<RtuRequest> ParseRtuRequestFrame(std::span<uint8_t const> frame, RtuRequest::allocator_type allocator) {
+  auto const pdu = GetRtuFramePdu(frame);
+  if (!pdu.has_value()) {
+    return Unexpected{pdu.error()};
+  }
+  auto request = DecodeRequestPdu(frame[0], pdu.value(), allocator);
+  if (!request.has_value()) {
+    return Unexpected{ModbusError{ModbusErrorKind::kMalformedPdu, static_cast<FunctionCode>(frame[1])}};
+  }
+  return std::move(request).value();
+}
+
+ModbusResult<RtuResponse> ParseRtuResponseFrame(std::span<uint8_t const> frame,
+                                                RtuResponse::allocator_type allocator) {
+  auto const pdu = GetRtuFramePdu(frame);
+  if (!pdu.has_value()) {
+    return Unexpected{pdu.error()};
+  }
+  auto response = DecodeResponsePdu(frame[0], pdu.value(), allocator);
+  if (!response.has_value()) {
+    return Unexpected{ModbusError{ModbusErrorKind::kMalformedPdu, static_cast<FunctionCode>(frame[1])}};
+  }
+  return std::move(response).value();
+}
+
+std::optional<RtuRequest> DecodeRtuRequestFrame(std::span<uint8_t const> frame, RtuRequest::allocator_type allocator) {
+  auto request = ParseRtuRequestFrame(frame, allocator);
+  if (!request.has_value()) {
+    return {};
+  }
+  return std::move(request).value();
+}
+
+std::optional<RtuResponse> DecodeRtuResponseFrame(std::span<uint8_t const> frame,
+                                                  RtuResponse::allocator_type allocator) {
+  auto response = ParseRtuResponseFrame(frame, allocator);
+  if (!response.has_value()) {
+    return {};
+  }
+  return std::move(response).value();
+}
+
+}  // namespace supermb
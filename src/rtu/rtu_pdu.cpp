@@ -0,0 +1,108 @@
+#include "rtu/rtu_pdu.hpp"
+#include "common/byte_helpers.hpp"
+#include "common/exception_code.hpp"
+#include "common/function_code.hpp"
+
+namespace supermb {
+
+static constexpr uint8_t kExceptionFunctionFlag{0x80};
+static constexpr size_t kExceptionPduSize{2};
+
+// Size of the byte count that precedes the data of a normal response
+static constexpr size_t GetByteCountSize(FunctionCode function_code) {
+  switch (function_code) {
+    case FunctionCode::kReadCoils:
+    case FunctionCode::kReadDI:
+    case FunctionCode::kReadHR:
+    case FunctionCode::kReadIR:
+    case FunctionCode::kReadFileRecord:
+    case FunctionCode::kReadWriteMultRegs:
+      return 1;
+    case FunctionCode::kReadFIFOQueue:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+static bool IsExceptionResponse(ExceptionCode exception_code) {
+  return exception_code != ExceptionCode::kAcknowledge && exception_code != ExceptionCode::kInvalidExceptionCode;
+}
+
+void EncodeRequestPdu(RtuRequest const &request, std::vector<uint8_t> &out) {
+  auto const &data = request.GetData();
+  out.emplace_back(static_cast<uint8_t>(request.GetFunctionCode()));
+  out.insert(out.end(), data.begin(), data.end());
+}
+
+void EncodeResponsePdu(RtuResponse const &response, std::vector<uint8_t> &out) {
+  auto const function_code = static_cast<uint8_t>(response.GetFunctionCode());
+  if (IsExceptionResponse(response.GetExceptionCode())) {
+    out.emplace_back(function_code | kExceptionFunctionFlag);
+    out.emplace_back(static_cast<uint8_t>(response.GetExceptionCode()));
+    return;
+  }
+
+  auto const &data = response.GetData();
+  out.emplace_back(function_code);
+  switch (GetByteCountSize(response.GetFunctionCode())) {
+    case 1:
+      out.emplace_back(static_cast<uint8_t>(data.size()));
+      break;
+    case 2:
+      out.emplace_back(GetHighByte(static_cast<uint16_t>(data.size())));
+      out.emplace_back(GetLowByte(static_cast<uint16_t>(data.size())));
+      break;
+    default:
+      break;
+  }
+  out.insert(out.end(), data.begin(), data.end());
+}
+
+std::optional<RtuRequest> DecodeRequestPdu(uint8_t slave_id, std::span<uint8_t const> pdu,
+                                           RtuRequest::allocator_type allocator) {
+  if (pdu.empty() || (pdu[0] & kExceptionFunctionFlag) != 0) {
+    return {};
+  }
+
+  RtuRequest request{{slave_id, static_cast<FunctionCode>(pdu[0])}, allocator};
+  request.SetRawData(pdu.subspan(1));
+  return request;
+}
+
+std::optional<RtuResponse> DecodeResponsePdu(uint8_t slave_id, std::span<uint8_t const> pdu,
+                                             RtuResponse::allocator_type allocator) {
+  if (pdu.empty()) {
+    return {};
+  }
+
+  if ((pdu[0] & kExceptionFunctionFlag) != 0) {
+    if (pdu.size() != kExceptionPduSize) {
+      return {};
+    }
+    RtuResponse response{slave_id, static_cast<FunctionCode>(pdu[0] & ~kExceptionFunctionFlag), allocator};
+    response.SetExceptionCode(static_cast<ExceptionCode>(pdu[1]));
+    return response;
+  }
+
+  auto const function_code = static_cast<FunctionCode>(pdu[0]);
+  auto data = pdu.subspan(1);
+  size_t const byte_count_size = GetByteCountSize(function_code);
+  if (data.size() < byte_count_size) {
+    return {};
+  }
+  if (byte_count_size > 0) {
+    size_t const byte_count = byte_count_size == 1 ? data[0] : static_cast<uint16_t>(MakeInt16(data[1], data[0]));
+    data = data.subspan(byte_count_size);
+    if (byte_count != data.size()) {
+      return {};
+    }
+  }
+
+  RtuResponse response{slave_id, function_code, allocator};
+  response.Append(data);
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+  return response;
+}
+
+}  // namespace supermb
@@ -5,24 +5,23 @@
 #include "common/address_span.hpp"
 #include "common/byte_helpers.hpp"
 #include "common/function_code.hpp"
+#include "common/function_code_info.hpp"
 #include "rtu/rtu_request.hpp"
 
 namespace supermb {
 
-static constexpr std::array<FunctionCode, 10> kAddressSpanValidFunctions{
-    FunctionCode::kReadCoils,        FunctionCode::kReadDI,          FunctionCode::kReadHR,
-    FunctionCode::kReadIR,           FunctionCode::kWriteSingleCoil, FunctionCode::kWriteSingleReg,
-    FunctionCode::kWriteMultCoils,   FunctionCode::kWriteMultRegs,   FunctionCode::kMaskWriteReg,
-    FunctionCode::kReadWriteMultRegs};
-
 static constexpr uint8_t kAddressSpanStartAddressIndex{0};
 static constexpr uint8_t kAddressSpanRegCountIndex{2};
 static constexpr uint8_t kAddressSpanMinDataSize{4};
 
+static constexpr uint8_t kWriteSpanStartAddressIndex{4};
+static constexpr uint8_t kWriteSpanRegCountIndex{6};
+static constexpr uint8_t kWriteSpanMinDataSize{8};
+
+static constexpr uint8_t kFileSubRequestHeaderSize{7};
+
 std::optional<AddressSpan> RtuRequest::GetAddressSpan() const {
-  if ((data_.size() < kAddressSpanMinDataSize) ||
-      (std::find(kAddressSpanValidFunctions.begin(), kAddressSpanValidFunctions.end(), header_.function_code) ==
-       kAddressSpanValidFunctions.end())) {
+  if ((data_.size() < kAddressSpanMinDataSize) || !GetFunctionCodeInfo(header_.function_code).has_address_span) {
     return {};
   }
 
@@ -34,9 +33,19 @@ std::optional<AddressSpan> RtuRequest::GetAddressSpan() const {
   return address_span;
 }
 
+std::optional<AddressSpan> RtuRequest::GetWriteAddressSpan() const {
+  if ((data_.size() < kWriteSpanMinDataSize) || (header_.function_code != FunctionCode::kReadWriteMultRegs)) {
+    return {};
+  }
+
+  AddressSpan address_span;
+  address_span.start_address = MakeInt16(data_[kWriteSpanStartAddressIndex + 1], data_[kWriteSpanStartAddressIndex]);
+  address_span.reg_count = MakeInt16(data_[kWriteSpanRegCountIndex + 1], data_[kWriteSpanRegCountIndex]);
+  return address_span;
+}
+
 bool RtuRequest::SetAddressSpan(AddressSpan address_span) {
-  if (std::find(kAddressSpanValidFunctions.begin(), kAddressSpanValidFunctions.end(), header_.function_code) ==
-      kAddressSpanValidFunctions.end()) {
+  if (!GetFunctionCodeInfo(header_.function_code).has_address_span) {
     assert(false);  // likely a library defect if hit - create ticket in github
     return false;
   }
@@ -63,4 +72,125 @@ bool RtuRequest::SetWriteSingleRegisterData(uint16_t register_address, int16_t r
   return true;
 }
 
+bool RtuRequest::SetWriteMultipleRegistersData(uint16_t start_address, std::vector<int16_t> const &values) {
+  if (header_.function_code != FunctionCode::kWriteMultRegs) {
+    assert(false);  // likely a library defect if hit - create ticket in github
+    return false;
+  }
+
+  auto const count = static_cast<uint16_t>(values.size());
+  data_.clear();
+  data_.reserve(kAddressSpanMinDataSize + 1 + values.size() * 2);
+  data_.emplace_back(GetHighByte(start_address));
+  data_.emplace_back(GetLowByte(start_address));
+  data_.emplace_back(GetHighByte(count));
+  data_.emplace_back(GetLowByte(count));
+  data_.emplace_back(static_cast<uint8_t>(count * 2));
+  for (int16_t const value : values) {
+    data_.emplace_back(GetHighByte(value));
+    data_.emplace_back(GetLowByte(value));
+  }
+  return true;
+}
+
+bool RtuRequest::SetMaskWriteRegisterData(uint16_t register_address, uint16_t and_mask, uint16_t or_mask) {
+  if (header_.function_code != FunctionCode::kMaskWriteReg) {
+    assert(false);  // likely a library defect if hit - create ticket in github
+    return false;
+  }
+
+  data_.clear();
+  data_.emplace_back(GetHighByte(register_address));
+  data_.emplace_back(GetLowByte(register_address));
+  data_.emplace_back(GetHighByte(and_mask));
+  data_.emplace_back(GetLowByte(and_mask));
+  data_.emplace_back(GetHighByte(or_mask));
+  data_.emplace_back(GetLowByte(or_mask));
+  return true;
+}
+
+bool RtuRequest::SetReadWriteMultipleRegistersData(AddressSpan read_span, uint16_t write_start_address,
+                                                   std::vector<int16_t> const &write_values) {
+  if (header_.function_code != FunctionCode::kReadWriteMultRegs) {
+    assert(false);  // likely a library defect if hit - create ticket in github
+    return false;
+  }
+
+  auto const write_count = static_cast<uint16_t>(write_values.size());
+  data_.clear();
+  data_.reserve(kWriteSpanMinDataSize + 1 + write_values.size() * 2);
+  data_.emplace_back(GetHighByte(read_span.start_address));
+  data_.emplace_back(GetLowByte(read_span.start_address));
+  data_.emplace_back(GetHighByte(read_span.reg_count));
+  data_.emplace_back(GetLowByte(read_span.reg_count));
+  data_.emplace_back(GetHighByte(write_start_address));
+  data_.emplace_back(GetLowByte(write_start_address));
+  data_.emplace_back(GetHighByte(write_count));
+  data_.emplace_back(GetLowByte(write_count));
+  data_.emplace_back(static_cast<uint8_t>(write_count * 2));
+  for (int16_t const value : write_values) {
+    data_.emplace_back(GetHighByte(value));
+    data_.emplace_back(GetLowByte(value));
+  }
+  return true;
+}
+
+bool RtuRequest::SetReadFifoQueueData(uint16_t fifo_address) {
+  if (header_.function_code != FunctionCode::kReadFIFOQueue) {
+    assert(false);  // likely a library defect if hit - create ticket in github
+    return false;
+  }
+
+  data_.clear();
+  data_.emplace_back(GetHighByte(fifo_address));
+  data_.emplace_back(GetLowByte(fifo_address));
+  return true;
+}
+
+bool RtuRequest::SetReadFileRecordData(std::vector<FileRecordSpan> const &sub_requests) {
+  if (header_.function_code != FunctionCode::kReadFileRecord) {
+    assert(false);  // likely a library defect if hit - create ticket in github
+    return false;
+  }
+
+  data_.clear();
+  data_.emplace_back(static_cast<uint8_t>(sub_requests.size() * kFileSubRequestHeaderSize));
+  for (auto const &sub_request : sub_requests) {
+    data_.emplace_back(kFileRecordReferenceType);
+    data_.emplace_back(GetHighByte(sub_request.file_number));
+    data_.emplace_back(GetLowByte(sub_request.file_number));
+    data_.emplace_back(GetHighByte(sub_request.record_number));
+    data_.emplace_back(GetLowByte(sub_request.record_number));
+    data_.emplace_back(GetHighByte(sub_request.record_length));
+    data_.emplace_back(GetLowByte(sub_request.record_length));
+  }
+  return true;
+}
+
+bool RtuRequest::SetWriteFileRecordData(std::vector<FileRecord> const &sub_requests) {
+  if (header_.function_code != FunctionCode::kWriteFileRecord) {
+    assert(false);  // likely a library defect if hit - create ticket in github
+    return false;
+  }
+
+  data_.clear();
+  data_.emplace_back(0);
+  for (auto const &sub_request : sub_requests) {
+    auto const record_length = static_cast<uint16_t>(sub_request.record_data.size());
+    data_.emplace_back(kFileRecordReferenceType);
+    data_.emplace_back(GetHighByte(sub_request.file_number));
+    data_.emplace_back(GetLowByte(sub_request.file_number));
+    data_.emplace_back(GetHighByte(sub_request.record_number));
+    data_.emplace_back(GetLowByte(sub_request.record_number));
+    data_.emplace_back(GetHighByte(record_length));
+    data_.emplace_back(GetLowByte(record_length));
+    for (int16_t const value : sub_request.record_data) {
+      data_.emplace_back(GetHighByte(value));
+      data_.emplace_back(GetLowByte(value));
+    }
+  }
+  data_[0] = static_cast<uint8_t>(data_.size() - 1);
+  return true;
+}
+
 }  // namespace supermb
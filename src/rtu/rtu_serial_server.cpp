@@ -0,0 +1,157 @@
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <latch>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <utility>
+#include "rtu/rtu_frame.hpp"
+#include "rtu/rtu_request.hpp"
+#include "rtu/rtu_response.hpp"
+#include "rtu/rtu_serial_server.hpp"
+
+namespace supermb {
+
+// Bus silence that ends a partial frame, and the longest a port thread waits before checking for Stop
+static constexpr int kSilenceMs{20};
+
+static bool WriteAll(int fd, std::span<uint8_t const> bytes) {
+  while (!bytes.empty()) {
+    ssize_t const written = write(fd, bytes.data(), bytes.size());
+    if (written < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return false;
+    }
+    bytes = bytes.subspan(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+RtuSerialServer::RtuSerialServer(RtuSerialServerConfig config)
+    : config_(config) {}
+
+RtuSerialServer::~RtuSerialServer() {
+  Stop();
+}
+
+size_t RtuSerialServer::AddPort(int fd) {
+  auto port = std::make_unique<Port>();
+  port->fd = fd;
+  port->transmit_buffer.reserve(kMaxRtuFrameSize);
+  ports_.emplace_back(std::move(port));
+  return ports_.size() - 1;
+}
+
+void RtuSerialServer::AddSlave(size_t port, RtuSlave &slave) {
+  ports_[port]->slaves[slave.GetId()] = &slave;
+}
+
+void RtuSerialServer::Start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+
+  std::latch started{static_cast<std::ptrdiff_t>(ports_.size())};
+  for (size_t i = 0; i < ports_.size(); ++i) {
+    ports_[i]->worker = std::thread{[this, i, &started] {
+      RealtimeConfig realtime = config_.realtime;
+      if (realtime.cpu >= 0) {
+        realtime.cpu += static_cast<int>(i);
+      }
+      ports_[i]->realtime_status = ApplyRealtimeConfig(realtime);
+      started.count_down();
+      RunPort(*ports_[i]);
+    }};
+  }
+  started.wait();
+}
+
+void RtuSerialServer::Stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+
+  for (auto &port : ports_) {
+    port->worker.join();
+  }
+}
+
+void RtuSerialServer::RunPort(Port &port) {
+  pollfd fds{port.fd, POLLIN, 0};
+  while (running_.load(std::memory_order_relaxed)) {
+    int const ready = poll(&fds, 1, kSilenceMs);
+    if (ready == 0) {
+      port.received = 0;
+      continue;
+    }
+    if (ready < 0 || (fds.revents & POLLIN) == 0) {
+      // A pty reports POLLHUP until the other side is opened
+      if (ready > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{kSilenceMs});
+      }
+      continue;
+    }
+
+    ssize_t const received =
+        read(port.fd, port.receive_buffer.data() + port.received, port.receive_buffer.size() - port.received);
+    if (received <= 0) {
+      continue;
+    }
+    auto const request_end = std::chrono::steady_clock::now();
+    port.received += static_cast<size_t>(received);
+    ProcessFrames(port, request_end);
+  }
+}
+
+void RtuSerialServer::ProcessFrames(Port &port, std::chrono::steady_clock::time_point request_end) {
+  size_t offset = 0;
+  while (true) {
+    std::span<uint8_t const> const bytes = std::span{port.receive_buffer}.subspan(offset, port.received - offset);
+    auto const frame_size = GetRtuRequestFrameSize(bytes);
+    if (!frame_size.has_value() || frame_size.value() > bytes.size()) {
+      break;
+    }
+    offset += frame_size.value();
+
+    std::pmr::monotonic_buffer_resource arena{port.arena.data(), port.arena.size()};
+    auto const request = DecodeRtuRequestFrame(bytes.first(frame_size.value()), &arena);
+    if (!request.has_value()) {
+      continue;
+    }
+    if (request->GetSlaveId() == 0) {
+      for (RtuSlave *slave : port.slaves) {
+        if (slave != nullptr) {
+          slave->Process(request.value(), &arena);
+        }
+      }
+      continue;
+    }
+    RtuSlave *const slave = port.slaves[request->GetSlaveId()];
+    if (slave == nullptr) {
+      continue;
+    }
+
+    port.transmit_buffer.clear();
+    EncodeRtuFrame(slave->Process(request.value(), &arena), port.transmit_buffer);
+    auto const turnaround = std::chrono::steady_clock::now() - request_end;
+    port.turnaround.Record(
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(turnaround).count()));
+    WriteAll(port.fd, port.transmit_buffer);
+  }
+
+  // Keep the partial frame, or drop everything once the buffer is full of bytes that never made one
+  size_t const remaining = port.received - offset;
+  if (remaining == port.receive_buffer.size()) {
+    port.received = 0;
+  } else if (offset > 0) {
+    std::memmove(port.receive_buffer.data(), port.receive_buffer.data() + offset, remaining);
+    port.received = remaining;
+  }
+}
+
+}  // namespace supermb
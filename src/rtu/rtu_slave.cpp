@@ -1,10 +1,16 @@
-#include <cassert>
+#include <algorithm>
+#include <array>
 #include <limits>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include "common/address_map.hpp"
 #include "common/byte_helpers.hpp"
 #include "common/function_code.hpp"
+#include "common/function_code_info.hpp"
 #include "rtu/rtu_request.hpp"
 #include "rtu/rtu_response.hpp"
 #include "rtu/rtu_slave.hpp"
@@ -12,19 +18,146 @@
 
 namespace supermb {
 
-RtuResponse RtuSlave::Process(RtuRequest const &request) {
-  RtuResponse response{request.GetSlaveId(), request.GetFunctionCode()};
+static constexpr uint16_t kMaxReadRegisters{GetFunctionCodeInfo(FunctionCode::kReadHR).quantity.max};
+static constexpr uint16_t kMaxWriteRegisters{GetFunctionCodeInfo(FunctionCode::kWriteMultRegs).quantity.max};
+// Start address and quantity, echoed by the FC 16 response
+static constexpr uint8_t kWriteMultipleEchoSize{4};
+static constexpr uint8_t kWriteMultipleValuesIndex{5};
+static constexpr uint8_t kFileSubRequestHeaderSize{7};
+static constexpr uint8_t kMaxReadFileResponseLength{0xF5};
+static constexpr uint8_t kReadWriteValuesIndex{9};
+
+static void AppendRegisters(std::span<int16_t const> values, RtuResponse &response) {
+  for (int16_t const value : values) {
+    response.EmplaceBack(GetHighByte(value));
+    response.EmplaceBack(GetLowByte(value));
+  }
+}
+
+static void AppendRegisters(std::span<int16_t const> values, std::pmr::vector<uint8_t> &arena) {
+  for (int16_t const value : values) {
+    arena.emplace_back(GetHighByte(value));
+    arena.emplace_back(GetLowByte(value));
+  }
+}
+
+static std::span<int16_t const> DecodeRegisters(std::span<uint8_t const> bytes, std::span<int16_t> out) {
+  size_t const count = std::min(bytes.size() / 2, out.size());
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = MakeInt16(bytes[i * 2 + 1], bytes[i * 2]);
+  }
+  return out.first(count);
+}
+
+static constexpr bool IsHandled(FunctionCode function_code) {
+  switch (function_code) {
+    case FunctionCode::kReadHR:
+    case FunctionCode::kReadIR:
+    case FunctionCode::kWriteSingleReg:
+    case FunctionCode::kWriteMultRegs:
+    case FunctionCode::kMaskWriteReg:
+    case FunctionCode::kReadWriteMultRegs:
+    case FunctionCode::kReadFIFOQueue:
+    case FunctionCode::kReadFileRecord:
+    case FunctionCode::kWriteFileRecord:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static constexpr bool IsRegisterWrite(FunctionCode function_code) {
+  return function_code == FunctionCode::kWriteSingleReg || function_code == FunctionCode::kWriteMultRegs ||
+         function_code == FunctionCode::kMaskWriteReg;
+}
+
+// Registers a rejected request asked for: its span, narrowed to the one register FC 6 and 22 address
+static AddressSpan GetRequestedSpan(RtuRequest const &request) {
+  auto span = request.GetAddressSpan();
+  if (!span.has_value()) {
+    return {};
+  }
+  if (GetFunctionCodeInfo(request.GetFunctionCode()).quantity.index == kNoFieldIndex) {
+    span->reg_count = 1;
+  }
+  return span.value();
+}
+
+RtuResponse RtuSlave::Process(RtuRequest const &request, RtuResponse::allocator_type allocator) {
+  auto result = TryProcess(request, allocator);
+  if (result.has_value()) {
+    return std::move(result).value();
+  }
+
+  RtuResponse response{request.GetSlaveId(), request.GetFunctionCode(), allocator};
+  response.SetExceptionCode(result.error().GetExceptionCode());
+  return response;
+}
+
+// Lengths, byte counts and quantities are checked once against the function code table before dispatch, so the
+// handlers below only check what depends on the slave's own state. Handlers report a failure through the response's
+// exception code and never append data before they fail, so the response built here is dropped without having
+// allocated.
+ModbusResult<RtuResponse> RtuSlave::TryProcess(RtuRequest const &request, RtuResponse::allocator_type allocator) {
+  FunctionCode const function_code = request.GetFunctionCode();
+  if (!IsHandled(function_code)) {
+    return Unexpected{ModbusError{ModbusErrorKind::kFunction, function_code}};
+  }
+  if (!IsRequestDataValid(function_code, request.GetData())) {
+    return Unexpected{ModbusError{ModbusErrorKind::kLength, function_code}};
+  }
+
+  // FC 23 holds the write gate alone and the other register writes share it. With a journal every register write runs
+  // alone, so the journal's order is the order values were stored in and FC 22 stores the value it journaled.
+  std::unique_lock exclusive_write{holding_write_gate_, std::defer_lock};
+  std::shared_lock shared_write{holding_write_gate_, std::defer_lock};
+  if (function_code == FunctionCode::kReadWriteMultRegs ||
+      (write_journal_ != nullptr && IsRegisterWrite(function_code))) {
+    exclusive_write.lock();
+  } else if (IsRegisterWrite(function_code)) {
+    shared_write.lock();
+  }
+
+  if (write_journal_ != nullptr && !JournalRegisterWrite(request)) {
+    return Unexpected{ModbusError{ModbusErrorKind::kBusy, function_code}};
+  }
+
+  RtuResponse response{request.GetSlaveId(), function_code, allocator};
   switch (request.GetFunctionCode()) {
     case FunctionCode::kReadHR: {
-      ProcessReadRegisters(holding_registers_, request, response);
+      ProcessReadRegisters(holding_registers_, holding_hooks_, request, response);
       break;
     }
     case FunctionCode::kReadIR: {
-      ProcessReadRegisters(input_registers_, request, response);
+      ProcessReadRegisters(input_registers_, input_hooks_, request, response);
       break;
     }
     case FunctionCode::kWriteSingleReg: {
-      ProcessWriteSingleRegister(holding_registers_, request, response);
+      ProcessWriteSingleRegister(holding_registers_, holding_hooks_, request, response);
+      break;
+    }
+    case FunctionCode::kWriteMultRegs: {
+      ProcessWriteMultipleRegisters(holding_registers_, holding_hooks_, request, response);
+      break;
+    }
+    case FunctionCode::kMaskWriteReg: {
+      ProcessMaskWriteRegister(holding_registers_, holding_hooks_, request, response);
+      break;
+    }
+    case FunctionCode::kReadWriteMultRegs: {
+      ProcessReadWriteMultipleRegisters(holding_registers_, holding_hooks_, request, response);
+      break;
+    }
+    case FunctionCode::kReadFIFOQueue: {
+      ProcessReadFifoQueue(request, response);
+      break;
+    }
+    case FunctionCode::kReadFileRecord: {
+      ProcessReadFileRecord(request, response);
+      break;
+    }
+    case FunctionCode::kWriteFileRecord: {
+      ProcessWriteFileRecord(request, response);
       break;
     }
     default: {
@@ -33,7 +166,134 @@ RtuResponse RtuSlave::Process(RtuRequest const &request) {
     }
   }
 
-  return response;
+  switch (response.GetExceptionCode()) {
+    case ExceptionCode::kAcknowledge:
+      return response;
+    case ExceptionCode::kIllegalFunction:
+      return Unexpected{ModbusError{ModbusErrorKind::kFunction, function_code}};
+    case ExceptionCode::kIllegalDataAddress:
+      return Unexpected{ModbusError{ModbusErrorKind::kAddress, function_code, GetRequestedSpan(request)}};
+    default:
+      return Unexpected{ModbusError{ModbusErrorKind::kLength, function_code}};
+  }
+}
+
+static bool IsRegisterRead(FunctionCode function_code) {
+  return function_code == FunctionCode::kReadHR || function_code == FunctionCode::kReadIR;
+}
+
+size_t RtuSlave::ProcessBatch(std::span<RtuRequest const> requests, std::span<BatchResponse> responses,
+                              std::pmr::vector<uint8_t> &arena) {
+  size_t const count = std::min(requests.size(), responses.size());
+
+  size_t reserve_size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    auto const address_span = requests[i].GetAddressSpan();
+    // Clamped, since the quantity has not been validated yet and an oversized one is answered with an exception
+    reserve_size += IsRegisterRead(requests[i].GetFunctionCode()) && address_span.has_value()
+                        ? static_cast<size_t>(std::min(address_span->reg_count, kMaxReadRegisters)) * 2
+                        : requests[i].GetData().size();
+  }
+  arena.reserve(arena.size() + reserve_size);
+
+  batch_reads_.clear();
+  for (size_t i = 0; i <= count; ++i) {
+    auto const address_span = i < count ? requests[i].GetAddressSpan() : std::nullopt;
+    if (address_span.has_value() && IsRegisterRead(requests[i].GetFunctionCode()) &&
+        IsRequestDataValid(requests[i].GetFunctionCode(), requests[i].GetData())) {
+      batch_reads_.push_back({requests[i].GetFunctionCode(), address_span->start_address, static_cast<uint32_t>(i)});
+      continue;
+    }
+
+    // Reads cannot observe each other, so a run of them may be served in any order
+    std::ranges::sort(batch_reads_, {}, [](BatchRead const &read) {
+      return std::tuple{read.function_code, read.start_address, read.index};
+    });
+    for (BatchRead const &read : batch_reads_) {
+      ProcessBatchRead(requests[read.index], responses[read.index], arena);
+    }
+    batch_reads_.clear();
+
+    if (i < count) {
+      RtuResponse const response = Process(requests[i], arena.get_allocator());
+      auto const &data = response.GetData();
+      responses[i] = {response.GetSlaveId(), response.GetFunctionCode(), response.GetExceptionCode(),
+                      static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(data.size())};
+      arena.insert(arena.end(), data.begin(), data.end());
+    }
+  }
+
+  return count;
+}
+
+void RtuSlave::ProcessBatchRead(RtuRequest const &request, BatchResponse &response,
+                                std::pmr::vector<uint8_t> &arena) const {
+  bool const holding = request.GetFunctionCode() == FunctionCode::kReadHR;
+  AddressMap<int16_t> const &address_map = holding ? holding_registers_ : input_registers_;
+  AddressSpan const address_span = request.GetAddressSpan().value();
+  size_t const data_offset = arena.size();
+  response = {request.GetSlaveId(), request.GetFunctionCode(), ExceptionCode::kAcknowledge,
+              static_cast<uint32_t>(data_offset), 0};
+
+  std::array<int16_t, kMaxReadRegisters> values{};
+  if (!ReadRegisters(address_map, holding ? holding_hooks_ : input_hooks_, address_span, values)) {
+    response.exception_code = ExceptionCode::kIllegalDataAddress;
+    return;
+  }
+  AppendRegisters(std::span{values}.first(address_span.reg_count), arena);
+  response.data_size = static_cast<uint32_t>(arena.size() - data_offset);
+}
+
+// Journals the values a register write is about to store, before the handler stores them, so a full journal can
+// still reject the request untouched. Writes the handler will reject are not journaled. Returns false only if the
+// journal is full.
+bool RtuSlave::JournalRegisterWrite(RtuRequest const &request) {
+  auto const &data = request.GetData();
+  std::array<int16_t, kMaxReadRegisters> values{};
+  AddressSpan span{};
+  switch (request.GetFunctionCode()) {
+    case FunctionCode::kWriteSingleReg: {
+      span = {static_cast<uint16_t>(MakeInt16(data[1], data[0])), 1};
+      values[0] = MakeInt16(data[3], data[2]);
+      break;
+    }
+    case FunctionCode::kWriteMultRegs: {
+      span = request.GetAddressSpan().value();
+      DecodeRegisters(std::span{data}.subspan(kWriteMultipleValuesIndex), values);
+      break;
+    }
+    case FunctionCode::kMaskWriteReg: {
+      // The value MaskWrite will store, since journaled writes hold the write gate alone
+      span = {static_cast<uint16_t>(MakeInt16(data[1], data[0])), 1};
+      auto const current = holding_registers_[span.start_address];
+      if (!current.has_value()) {
+        return true;
+      }
+      int16_t const and_mask = MakeInt16(data[3], data[2]);
+      int16_t const or_mask = MakeInt16(data[5], data[4]);
+      values[0] = static_cast<int16_t>((current.value() & and_mask) | (or_mask & ~and_mask));
+      break;
+    }
+    case FunctionCode::kReadWriteMultRegs: {
+      if (!holding_registers_.Contains(request.GetAddressSpan().value())) {
+        return true;
+      }
+      span = request.GetWriteAddressSpan().value();
+      DecodeRegisters(std::span{data}.subspan(kReadWriteValuesIndex), values);
+      break;
+    }
+    default:
+      return true;
+  }
+
+  if (!holding_registers_.Contains(span)) {
+    return true;
+  }
+  return write_journal_->TryAppend(id_, span.start_address, std::span{values}.first(span.reg_count));
+}
+
+RtuSlave::RegisterSnapshot RtuSlave::SnapshotRegisters() const {
+  return {holding_registers_.Snapshot(), input_registers_.Snapshot()};
 }
 
 void RtuSlave::AddHoldingRegisters(AddressSpan span) {
@@ -44,48 +304,256 @@ void RtuSlave::AddInputRegisters(AddressSpan span) {
   input_registers_.AddAddressSpan(span);
 }
 
-void RtuSlave::ProcessReadRegisters(AddressMap<int16_t> const &address_map, RtuRequest const &request,
+void RtuSlave::AddHoldingRegisterHooks(AddressSpan span, RegisterReadHook read_hook, RegisterWriteHook write_hook) {
+  holding_hooks_.AddHook(span, std::move(read_hook), std::move(write_hook));
+}
+
+void RtuSlave::AddInputRegisterHook(AddressSpan span, RegisterReadHook read_hook) {
+  input_hooks_.AddHook(span, std::move(read_hook), {});
+}
+
+FifoQueue &RtuSlave::AddFifoQueue(uint16_t fifo_address) {
+  auto &fifo_queue = fifo_queues_[fifo_address];
+  if (!fifo_queue) {
+    fifo_queue = std::make_unique<FifoQueue>();
+  }
+
+  return *fifo_queue;
+}
+
+bool RtuSlave::AddFileRecord(uint16_t file_number, std::string const &path) {
+  auto mapped_file = MappedFile::Open(path);
+  if (!mapped_file.has_value()) {
+    return false;
+  }
+
+  file_records_.insert_or_assign(file_number, std::move(mapped_file.value()));
+  return true;
+}
+
+void RtuSlave::ProcessReadRegisters(AddressMap<int16_t> const &address_map,
+                                    RegisterHookTable<int16_t> const &hooks, RtuRequest const &request,
                                     RtuResponse &response) {
-  bool exception_hit = false;
-  auto const maybe_address_span = request.GetAddressSpan();
-  if (!maybe_address_span.has_value()) {
-    assert(false);  // likely a library defect if hit - create ticket in github
-    response.SetExceptionCode(ExceptionCode::kIllegalFunction);
+  // The whole span is checked once, before any data is produced
+  AddressSpan const address_span = request.GetAddressSpan().value();
+  std::array<int16_t, kMaxReadRegisters> values{};
+  if (!ReadRegisters(address_map, hooks, address_span, values)) {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
     return;
   }
 
-  AddressSpan const &address_span = maybe_address_span.value();
-  for (int i = 0; i < address_span.reg_count; ++i) {
-    auto const reg_value = address_map[address_span.start_address + i];
-    if (reg_value.has_value()) {
-      response.EmplaceBack(GetLowByte(reg_value.value()));
-      response.EmplaceBack(GetHighByte(reg_value.value()));
-    } else {
-      response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
-      exception_hit = true;
+  AppendRegisters(std::span{values}.first(address_span.reg_count), response);
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+}
+
+void RtuSlave::ProcessWriteSingleRegister(AddressMap<int16_t> &address_map,
+                                          RegisterHookTable<int16_t> const &hooks, RtuRequest const &request,
+                                          RtuResponse &response) {
+  uint16_t const address = MakeInt16(request.GetData()[1], request.GetData()[0]);
+  int16_t new_value = MakeInt16(request.GetData()[3], request.GetData()[2]);
+  if (address_map.Set(address, new_value)) {
+    if (hooks.IsHooked({address, 1})) {
+      hooks.OnWrite(address, new_value);
     }
+    // Normal response is an echo of the request
+    response.SetData(request.GetData());
+    response.SetExceptionCode(ExceptionCode::kAcknowledge);
+  } else {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
   }
+}
 
-  if (!exception_hit) {
-    response.SetExceptionCode(ExceptionCode::kAcknowledge);
+// Validated in full before the first register is written, like FC 23
+void RtuSlave::ProcessWriteMultipleRegisters(AddressMap<int16_t> &address_map,
+                                             RegisterHookTable<int16_t> const &hooks, RtuRequest const &request,
+                                             RtuResponse &response) {
+  AddressSpan const write_span = request.GetAddressSpan().value();
+  auto const &data = request.GetData();
+  std::array<int16_t, kMaxWriteRegisters> values{};
+  if (!WriteRegisters(address_map, hooks, write_span,
+                      DecodeRegisters(std::span{data}.subspan(kWriteMultipleValuesIndex), values))) {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+    return;
   }
+
+  // Normal response echoes the start address and quantity
+  response.SetData(std::span{data}.first(kWriteMultipleEchoSize));
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
 }
 
-void RtuSlave::ProcessWriteSingleRegister(AddressMap<int16_t> &address_map, RtuRequest const &request,
-                                          RtuResponse &response) {
-  if (request.GetData().size() < 2) {
-    response.SetExceptionCode(ExceptionCode::kIllegalFunction);
+// Without a write journal this takes no lock: FC 22 requests on several threads apply their masks as compare-and-swaps
+// and never lose each other's bits. The write hook sees the value this request stored, even if another writer has
+// changed it since.
+void RtuSlave::ProcessMaskWriteRegister(AddressMap<int16_t> &address_map,
+                                        RegisterHookTable<int16_t> const &hooks, RtuRequest const &request,
+                                        RtuResponse &response) {
+  auto const &data = request.GetData();
+  uint16_t const address = MakeInt16(data[1], data[0]);
+  int16_t const and_mask = MakeInt16(data[3], data[2]);
+  int16_t const or_mask = MakeInt16(data[5], data[4]);
+  auto const stored = address_map.MaskWrite(address, and_mask, or_mask);
+  if (!stored.has_value()) {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
     return;
   }
+  if (hooks.IsHooked({address, 1})) {
+    hooks.OnWrite(address, stored.value());
+  }
 
-  uint16_t const address = MakeInt16(request.GetData()[0], request.GetData()[1]);
-  int16_t new_value = MakeInt16(request.GetData()[2], request.GetData()[3]);
-  if (address_map[address].has_value()) {
-    address_map.Set(address, new_value);
-    response.SetExceptionCode(ExceptionCode::kAcknowledge);
-  } else {
+  // Normal response is an echo of the request
+  response.SetData(data);
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+}
+
+// The write and the read are validated together before any register is touched, so a request either applies in
+// full or fails without side effects. TryProcess holds the write gate alone around it, so no other register write
+// lands between the write and the following read.
+void RtuSlave::ProcessReadWriteMultipleRegisters(AddressMap<int16_t> &address_map,
+                                                 RegisterHookTable<int16_t> const &hooks, RtuRequest const &request,
+                                                 RtuResponse &response) {
+  AddressSpan const read_span = request.GetAddressSpan().value();
+  AddressSpan const write_span = request.GetWriteAddressSpan().value();
+  auto const &data = request.GetData();
+  if (!address_map.Contains(read_span)) {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+    return;
+  }
+
+  std::array<int16_t, kMaxReadRegisters> values{};
+  if (!WriteRegisters(address_map, hooks, write_span,
+                      DecodeRegisters(std::span{data}.subspan(kReadWriteValuesIndex), values))) {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+    return;
+  }
+
+  ReadRegisters(address_map, hooks, read_span, values);
+  AppendRegisters(std::span{values}.first(read_span.reg_count), response);
+
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+}
+
+// Response data is the FIFO count followed by the queued values; like the register reads, the byte count is left
+// to the transport.
+void RtuSlave::ProcessReadFifoQueue(RtuRequest const &request, RtuResponse &response) {
+  auto const &data = request.GetData();
+  auto const fifo_iter = fifo_queues_.find(MakeInt16(data[1], data[0]));
+  if (fifo_iter == fifo_queues_.end()) {
     response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+    return;
+  }
+
+  // The queue never holds more than one response may carry, so the spec's illegal data value case cannot arise
+  FifoQueue &fifo_queue = *fifo_iter->second;
+
+  std::array<int16_t, kMaxFifoCount> values{};
+  uint16_t fifo_count = 0;
+  while (fifo_count < kMaxFifoCount) {
+    auto const value = fifo_queue.TryPop();
+    if (!value.has_value()) {
+      break;
+    }
+    values[fifo_count++] = value.value();
+  }
+
+  response.EmplaceBack(GetHighByte(fifo_count));
+  response.EmplaceBack(GetLowByte(fifo_count));
+  for (uint16_t i = 0; i < fifo_count; ++i) {
+    response.EmplaceBack(GetHighByte(values[i]));
+    response.EmplaceBack(GetLowByte(values[i]));
+  }
+
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+}
+
+static FileRecordSpan ParseFileRecordSpan(std::span<uint8_t const> data, size_t offset) {
+  FileRecordSpan span;
+  span.file_number = MakeInt16(data[offset + 2], data[offset + 1]);
+  span.record_number = MakeInt16(data[offset + 4], data[offset + 3]);
+  span.record_length = MakeInt16(data[offset + 6], data[offset + 5]);
+  return span;
+}
+
+// Every sub-request is validated before any record is copied. Response data is the sub-responses (length,
+// reference type, record data); the leading response data length is left to the transport like the other reads.
+void RtuSlave::ProcessReadFileRecord(RtuRequest const &request, RtuResponse &response) {
+  auto const &data = request.GetData();
+  if (data[0] % kFileSubRequestHeaderSize != 0) {
+    response.SetExceptionCode(ExceptionCode::kIllegalDataValue);
+    return;
+  }
+
+  size_t response_length = 0;
+  for (size_t offset = 1; offset < data.size(); offset += kFileSubRequestHeaderSize) {
+    FileRecordSpan const span = ParseFileRecordSpan(data, offset);
+    response_length += 2 + static_cast<size_t>(span.record_length) * 2;
+    if (data[offset] != kFileRecordReferenceType || response_length > kMaxReadFileResponseLength) {
+      response.SetExceptionCode(ExceptionCode::kIllegalDataValue);
+      return;
+    }
+    if (!GetFileRecordBytes(span).has_value()) {
+      response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+      return;
+    }
   }
+
+  for (size_t offset = 1; offset < data.size(); offset += kFileSubRequestHeaderSize) {
+    auto const record_bytes = GetFileRecordBytes(ParseFileRecordSpan(data, offset)).value();
+    response.EmplaceBack(static_cast<uint8_t>(record_bytes.size() + 1));
+    response.EmplaceBack(kFileRecordReferenceType);
+    response.Append(record_bytes);
+  }
+
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+}
+
+void RtuSlave::ProcessWriteFileRecord(RtuRequest const &request, RtuResponse &response) {
+  auto const &data = request.GetData();
+  size_t offset = 1;
+  while (offset < data.size()) {
+    if (data.size() - offset < kFileSubRequestHeaderSize || data[offset] != kFileRecordReferenceType) {
+      response.SetExceptionCode(ExceptionCode::kIllegalDataValue);
+      return;
+    }
+
+    FileRecordSpan const span = ParseFileRecordSpan(data, offset);
+    offset += kFileSubRequestHeaderSize + static_cast<size_t>(span.record_length) * 2;
+    if (offset > data.size()) {
+      response.SetExceptionCode(ExceptionCode::kIllegalDataValue);
+      return;
+    }
+    if (!GetFileRecordBytes(span).has_value()) {
+      response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+      return;
+    }
+  }
+
+  offset = 1;
+  while (offset < data.size()) {
+    auto const record_bytes = GetFileRecordBytes(ParseFileRecordSpan(data, offset)).value();
+    offset += kFileSubRequestHeaderSize;
+    std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(offset), record_bytes.size(), record_bytes.begin());
+    offset += record_bytes.size();
+  }
+
+  // Normal response is an echo of the request
+  response.SetData(data);
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+}
+
+std::optional<std::span<uint8_t>> RtuSlave::GetFileRecordBytes(FileRecordSpan span) {
+  auto const file_iter = file_records_.find(span.file_number);
+  if (file_iter == file_records_.end() || span.record_number > kMaxFileRecordNumber || span.record_length == 0) {
+    return {};
+  }
+
+  auto const file_bytes = file_iter->second.GetBytes();
+  size_t const byte_offset = static_cast<size_t>(span.record_number) * 2;
+  size_t const byte_count = static_cast<size_t>(span.record_length) * 2;
+  if (byte_offset + byte_count > file_bytes.size()) {
+    return {};
+  }
+
+  return file_bytes.subspan(byte_offset, byte_count);
 }
 
 }  // namespace supermb
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include "simulator/device_config.hpp"
+
+namespace supermb {
+
+static constexpr std::array<uint8_t, 6> kDeviceConfigMagic{'S', 'M', 'B', 'D', 'E', 'V'};
+static constexpr int kBitsPerByte{8};
+
+template <typename Integer>
+static void AppendInteger(Integer value, std::vector<uint8_t> &out) {
+  auto const bits = static_cast<std::make_unsigned_t<Integer>>(value);
+  for (size_t i = 0; i < sizeof(Integer); ++i) {
+    out.emplace_back(static_cast<uint8_t>(bits >> (kBitsPerByte * i)));
+  }
+}
+
+static void AppendSpans(std::vector<AddressSpan> const &spans, std::vector<uint8_t> &out) {
+  AppendInteger(static_cast<uint16_t>(spans.size()), out);
+  for (AddressSpan const &span : spans) {
+    AppendInteger(span.start_address, out);
+    AppendInteger(span.reg_count, out);
+  }
+}
+
+static void AppendValues(std::vector<InitialRegisterValue> const &values, std::vector<uint8_t> &out) {
+  AppendInteger(static_cast<uint16_t>(values.size()), out);
+  for (InitialRegisterValue const &value : values) {
+    AppendInteger(value.address, out);
+    AppendInteger(value.value, out);
+  }
+}
+
+namespace {
+
+// Bounds-checked little-endian reads; once a read runs past the end every later one fails too
+class ByteReader {
+ public:
+  explicit ByteReader(std::span<uint8_t const> bytes)
+      : bytes_(bytes) {}
+
+  template <typename Integer>
+  bool Read(Integer &value) {
+    if (bytes_.size() - offset_ < sizeof(Integer)) {
+      offset_ = bytes_.size();
+      return false;
+    }
+    std::make_unsigned_t<Integer> bits = 0;
+    for (size_t i = 0; i < sizeof(Integer); ++i) {
+      bits |= static_cast<std::make_unsigned_t<Integer>>(bytes_[offset_ + i]) << (kBitsPerByte * i);
+    }
+    value = static_cast<Integer>(bits);
+    offset_ += sizeof(Integer);
+    return true;
+  }
+
+  [[nodiscard]] size_t GetRemaining() const noexcept { return bytes_.size() - offset_; }
+
+ private:
+  std::span<uint8_t const> bytes_;
+  size_t offset_{0};
+};
+
+bool ReadSpans(ByteReader &reader, std::vector<AddressSpan> &spans) {
+  uint16_t count = 0;
+  if (!reader.Read(count)) {
+    return false;
+  }
+  spans.resize(count);
+  return std::ranges::all_of(
+      spans, [&reader](AddressSpan &span) { return reader.Read(span.start_address) && reader.Read(span.reg_count); });
+}
+
+bool ReadValues(ByteReader &reader, std::vector<InitialRegisterValue> &values) {
+  uint16_t count = 0;
+  if (!reader.Read(count)) {
+    return false;
+  }
+  values.resize(count);
+  return std::ranges::all_of(
+      values, [&reader](InitialRegisterValue &value) { return reader.Read(value.address) && reader.Read(value.value); });
+}
+
+// Calls work(i) for every i below count, spreading the indices over up to thread_count threads
+template <typename Work>
+void ParallelFor(size_t count, size_t thread_count, Work const &work) {
+  thread_count = std::min(thread_count, count);
+  if (thread_count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      work(i);
+    }
+    return;
+  }
+
+  // Contiguous chunks keep each thread's writes to the output on its own cache lines
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  size_t const chunk_size = (count + thread_count - 1) / thread_count;
+  for (size_t begin = 0; begin < count; begin += chunk_size) {
+    threads.emplace_back([&work, begin, end = std::min(count, begin + chunk_size)] {
+      for (size_t i = begin; i < end; ++i) {
+        work(i);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+RtuSlave::RegisterSnapshot BuildRegisters(DeviceProfile const &profile) {
+  RtuSlave::RegisterSnapshot registers;
+  for (AddressSpan const &span : profile.holding_registers) {
+    registers.holding_registers.AddAddressSpan(span);
+  }
+  for (AddressSpan const &span : profile.input_registers) {
+    registers.input_registers.AddAddressSpan(span);
+  }
+  for (InitialRegisterValue const &value : profile.holding_values) {
+    registers.holding_registers.Set(value.address, value.value);
+  }
+  for (InitialRegisterValue const &value : profile.input_values) {
+    registers.input_registers.Set(value.address, value.value);
+  }
+  return registers;
+}
+
+}  // namespace
+
+void EncodeDeviceConfig(DeviceConfig const &config, std::vector<uint8_t> &out) {
+  out.insert(out.end(), kDeviceConfigMagic.begin(), kDeviceConfigMagic.end());
+  out.emplace_back(kDeviceConfigVersion);
+  AppendInteger(static_cast<uint16_t>(config.profiles.size()), out);
+  AppendInteger(static_cast<uint32_t>(config.devices.size()), out);
+  for (DeviceProfile const &profile : config.profiles) {
+    AppendSpans(profile.holding_registers, out);
+    AppendSpans(profile.input_registers, out);
+    AppendValues(profile.holding_values, out);
+    AppendValues(profile.input_values, out);
+  }
+  for (DeviceEntry const &device : config.devices) {
+    out.emplace_back(device.slave_id);
+    AppendInteger(device.profile, out);
+  }
+}
+
+std::optional<DeviceConfig> DecodeDeviceConfig(std::span<uint8_t const> bytes) {
+  if (bytes.size() < kDeviceConfigMagic.size() + 1 ||
+      !std::equal(kDeviceConfigMagic.begin(), kDeviceConfigMagic.end(), bytes.begin()) ||
+      bytes[kDeviceConfigMagic.size()] != kDeviceConfigVersion) {
+    return {};
+  }
+
+  ByteReader reader{bytes.subspan(kDeviceConfigMagic.size() + 1)};
+  uint16_t profile_count = 0;
+  uint32_t device_count = 0;
+  if (!reader.Read(profile_count) || !reader.Read(device_count)) {
+    return {};
+  }
+
+  DeviceConfig config;
+  config.profiles.resize(profile_count);
+  for (DeviceProfile &profile : config.profiles) {
+    if (!ReadSpans(reader, profile.holding_registers) || !ReadSpans(reader, profile.input_registers) ||
+        !ReadValues(reader, profile.holding_values) || !ReadValues(reader, profile.input_values)) {
+      return {};
+    }
+  }
+
+  // Checked up front so a corrupt count cannot trigger a huge allocation
+  static constexpr size_t kDeviceEntrySize{3};
+  if (reader.GetRemaining() != static_cast<size_t>(device_count) * kDeviceEntrySize) {
+    return {};
+  }
+  config.devices.resize(device_count);
+  for (DeviceEntry &device : config.devices) {
+    reader.Read(device.slave_id);
+    reader.Read(device.profile);
+    if (device.profile >= profile_count) {
+      return {};
+    }
+  }
+  return config;
+}
+
+std::optional<DeviceConfig> LoadDeviceConfig(std::string const &path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    return {};
+  }
+  std::vector<uint8_t> const bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  return DecodeDeviceConfig(bytes);
+}
+
+std::optional<std::vector<std::unique_ptr<RtuSlave>>> BuildSlaves(DeviceConfig const &config, size_t thread_count) {
+  if (std::ranges::any_of(config.devices,
+                          [&config](DeviceEntry const &device) { return device.profile >= config.profiles.size(); })) {
+    return {};
+  }
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  std::vector<RtuSlave::RegisterSnapshot> registers(config.profiles.size());
+  ParallelFor(config.profiles.size(), thread_count,
+              [&config, &registers](size_t i) { registers[i] = BuildRegisters(config.profiles[i]); });
+
+  // Copying a snapshot only bumps reference counts, so devices cost their RtuSlave object and nothing more. Reading
+  // the shared pages never locks; a device's first write to one copies it for that device alone.
+  std::vector<std::unique_ptr<RtuSlave>> slaves(config.devices.size());
+  ParallelFor(config.devices.size(), thread_count, [&config, &registers, &slaves](size_t i) {
+    DeviceEntry const &device = config.devices[i];
+    slaves[i] = std::make_unique<RtuSlave>(device.slave_id, registers[device.profile]);
+  });
+  return slaves;
+}
+
+}  // namespace supermb
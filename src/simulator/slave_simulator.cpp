@@ -0,0 +1,136 @@
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include "common/exception_code.hpp"
+#include "simulator/slave_simulator.hpp"
+
+namespace supermb {
+
+// Empty passes over all channels before a shard yields its core
+static constexpr int kIdleSpins{64};
+
+SlaveSimulator::SlaveSimulator(size_t shard_count, bool pin_threads)
+    : pin_threads_(pin_threads) {
+  for (size_t i = 0; i < std::max<size_t>(shard_count, 1); ++i) {
+    shards_.emplace_back(std::make_unique<Shard>());
+  }
+}
+
+SlaveSimulator::~SlaveSimulator() {
+  Stop();
+}
+
+RtuSlave &SlaveSimulator::AddSlave(uint8_t slave_id) {
+  auto &slave = shards_[GetShard(slave_id)]->slaves[slave_id];
+  if (!slave) {
+    slave = std::make_unique<RtuSlave>(slave_id);
+  }
+
+  return *slave;
+}
+
+RtuSlave &SlaveSimulator::AddSlave(std::unique_ptr<RtuSlave> slave) {
+  uint8_t const slave_id = slave->GetId();
+  auto &slot = shards_[GetShard(slave_id)]->slaves[slave_id];
+  slot = std::move(slave);
+  return *slot;
+}
+
+SlaveSimulator::ClientId SlaveSimulator::AddClient() {
+  assert(!running_.load(std::memory_order_relaxed));  // clients must be added before Start
+  for (size_t shard = 0; shard < shards_.size(); ++shard) {
+    channels_.emplace_back(std::make_unique<Channel>());
+  }
+
+  return client_count_++;
+}
+
+void SlaveSimulator::Start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+
+  unsigned const core_count = std::max(std::thread::hardware_concurrency(), 1U);
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->worker = std::thread{[this, i] { RunShard(i); }};
+    if (pin_threads_) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(i % core_count, &cpu_set);
+      // Best effort: an unpinned shard still works, it just may migrate
+      pthread_setaffinity_np(shards_[i]->worker.native_handle(), sizeof(cpu_set), &cpu_set);
+    }
+  }
+}
+
+void SlaveSimulator::Stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+
+  for (auto &shard : shards_) {
+    shard->worker.join();
+  }
+}
+
+bool SlaveSimulator::Submit(ClientId client, Tag tag, RtuRequest const &request) {
+  auto const &data = request.GetData();
+  if (data.size() > kMaxPduDataSize) {
+    return false;
+  }
+
+  RequestEnvelope envelope{tag, {request.GetSlaveId(), request.GetFunctionCode()}, static_cast<uint16_t>(data.size())};
+  std::ranges::copy(data, envelope.data.begin());
+  return GetChannel(client, GetShard(request.GetSlaveId())).requests.TryPush(envelope);
+}
+
+void SlaveSimulator::Respond(Channel &channel, Tag tag, RtuResponse const &response) {
+  auto const &data = response.GetData();
+  // Responses come from RtuSlave, which never builds one larger than a frame
+  assert(data.size() <= kMaxPduDataSize);
+  ResponseEnvelope envelope{tag, response.GetSlaveId(), response.GetFunctionCode(), response.GetExceptionCode(),
+                            static_cast<uint16_t>(data.size())};
+  std::ranges::copy(data, envelope.data.begin());
+  channel.responses.TryPush(envelope);
+}
+
+void SlaveSimulator::RunShard(size_t shard_index) {
+  Shard &shard = *shards_[shard_index];
+  int idle_passes = 0;
+  while (running_.load(std::memory_order_relaxed)) {
+    bool busy = false;
+    for (size_t client = 0; client < client_count_; ++client) {
+      Channel &channel = GetChannel(client, shard_index);
+      // Only take a request when its response is sure to fit
+      while (!channel.responses.Full()) {
+        auto envelope = channel.requests.TryPop();
+        if (!envelope.has_value()) {
+          break;
+        }
+
+        RtuRequest request{envelope->header, &shard.memory};
+        request.SetRawData(envelope->GetData());
+        auto &slave = shard.slaves[request.GetSlaveId()];
+        if (slave) {
+          Respond(channel, envelope->tag, slave->Process(request, &shard.memory));
+        } else {
+          RtuResponse response{request.GetSlaveId(), request.GetFunctionCode(), &shard.memory};
+          response.SetExceptionCode(ExceptionCode::kGatewayTargetDeviceFailedToRespond);
+          Respond(channel, envelope->tag, response);
+        }
+        busy = true;
+      }
+    }
+
+    if (busy) {
+      idle_passes = 0;
+    } else if (++idle_passes >= kIdleSpins) {
+      std::this_thread::yield();
+      idle_passes = 0;
+    }
+  }
+}
+
+}  // namespace supermb
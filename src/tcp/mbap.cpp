@@ -0,0 +1,102 @@
+#include "common/byte_helpers.hpp"
+#include "rtu/rtu_pdu.hpp"
+#include "tcp/mbap.hpp"
+
+namespace supermb {
+
+static constexpr size_t kLengthFieldEnd{6};
+
+std::optional<MbapHeader> DecodeMbapHeader(std::span<uint8_t const> bytes) noexcept {
+  if (bytes.size() < kMbapHeaderSize) {
+    return {};
+  }
+
+  MbapHeader header;
+  header.transaction_id = MakeInt16(bytes[1], bytes[0]);
+  header.protocol_id = MakeInt16(bytes[3], bytes[2]);
+  header.length = MakeInt16(bytes[5], bytes[4]);
+  header.unit_id = bytes[6];
+  return header;
+}
+
+void EncodeMbapHeader(MbapHeader const &header, std::span<uint8_t, kMbapHeaderSize> out) noexcept {
+  out[0] = GetHighByte(header.transaction_id);
+  out[1] = GetLowByte(header.transaction_id);
+  out[2] = GetHighByte(header.protocol_id);
+  out[3] = GetLowByte(header.protocol_id);
+  out[4] = GetHighByte(header.length);
+  out[5] = GetLowByte(header.length);
+  out[6] = header.unit_id;
+}
+
+std::optional<size_t> GetMbapFrameSize(std::span<uint8_t const> bytes) noexcept {
+  if (bytes.size() < kLengthFieldEnd) {
+    return {};
+  }
+
+  return kLengthFieldEnd + static_cast<uint16_t>(MakeInt16(bytes[5], bytes[4]));
+}
+
+template <typename Message, typename EncodePdu>
+static void EncodeFrame(uint16_t transaction_id, Message const &message, std::vector<uint8_t> &out,
+                        EncodePdu encode_pdu) {
+  size_t const frame_start = out.size();
+  out.resize(frame_start + kMbapHeaderSize);
+  encode_pdu(message, out);
+
+  MbapHeader header;
+  header.transaction_id = transaction_id;
+  header.length = static_cast<uint16_t>(out.size() - frame_start - kLengthFieldEnd);
+  header.unit_id = message.GetSlaveId();
+  EncodeMbapHeader(header, std::span{out}.subspan(frame_start).first<kMbapHeaderSize>());
+}
+
+void EncodeMbapFrame(uint16_t transaction_id, RtuRequest const &request, std::vector<uint8_t> &out) {
+  EncodeFrame(transaction_id, request, out, EncodeRequestPdu);
+}
+
+void EncodeMbapFrame(uint16_t transaction_id, RtuResponse const &response, std::vector<uint8_t> &out) {
+  EncodeFrame(transaction_id, response, out, EncodeResponsePdu);
+}
+
+static std::optional<MbapHeader> CheckFrame(std::span<uint8_t const> frame) {
+  auto const header = DecodeMbapHeader(frame);
+  if (!header.has_value() || header->protocol_id != 0 || header->length + kLengthFieldEnd != frame.size() ||
+      frame.size() > kMaxMbapFrameSize) {
+    return {};
+  }
+
+  return header;
+}
+
+std::optional<std::pair<MbapHeader, RtuRequest>> DecodeMbapRequestFrame(std::span<uint8_t const> frame,
+                                                                        RtuRequest::allocator_type allocator) {
+  auto const header = CheckFrame(frame);
+  if (!header.has_value()) {
+    return {};
+  }
+
+  auto request = DecodeRequestPdu(header->unit_id, frame.subspan(kMbapHeaderSize), allocator);
+  if (!request.has_value()) {
+    return {};
+  }
+
+  return std::pair{header.value(), std::move(request.value())};
+}
+
+std::optional<std::pair<MbapHeader, RtuResponse>> DecodeMbapResponseFrame(std::span<uint8_t const> frame,
+                                                                          RtuResponse::allocator_type allocator) {
+  auto const header = CheckFrame(frame);
+  if (!header.has_value()) {
+    return {};
+  }
+
+  auto response = DecodeResponsePdu(header->unit_id, frame.subspan(kMbapHeaderSize), allocator);
+  if (!response.has_value()) {
+    return {};
+  }
+
+  return std::pair{header.value(), std::move(response.value())};
+}
+
+}  // namespace supermb
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "super_modbus/ascii/ascii_codec.hpp"
+#include "super_modbus/common/address_span.hpp"
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_response.hpp"
+
+TEST(AsciiCodec, EncodeRequest) {
+  using supermb::EncodeAsciiRequest;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+
+  RtuRequest request{{0x11, FunctionCode::kReadHR}};
+  request.SetAddressSpan({0x006B, 3});
+  EXPECT_EQ(EncodeAsciiRequest(request), ":1103006B00037E\r\n");
+}
+
+TEST(AsciiCodec, DecodeRequest) {
+  using supermb::DecodeAsciiRequest;
+  using supermb::FunctionCode;
+
+  auto const request = DecodeAsciiRequest(":1103006b00037e\r\n");
+  ASSERT_TRUE(request.has_value());
+  EXPECT_EQ(request->GetSlaveId(), 0x11);
+  EXPECT_EQ(request->GetFunctionCode(), FunctionCode::kReadHR);
+  ASSERT_TRUE(request->GetAddressSpan().has_value());
+  EXPECT_EQ(request->GetAddressSpan()->start_address, 0x006B);
+  EXPECT_EQ(request->GetAddressSpan()->reg_count, 3);
+
+  EXPECT_FALSE(DecodeAsciiRequest(":1103006B00037F\r\n").has_value());
+  EXPECT_FALSE(DecodeAsciiRequest(":1103006B00037E\n").has_value());
+  EXPECT_FALSE(DecodeAsciiRequest("1103006B00037E\r\n").has_value());
+  EXPECT_FALSE(DecodeAsciiRequest(":1103006G00037E\r\n").has_value());
+  EXPECT_FALSE(DecodeAsciiRequest(":1103006B0003E\r\n").has_value());
+}
+
+TEST(AsciiCodec, ResponseRoundTrip) {
+  using supermb::DecodeAsciiResponse;
+  using supermb::EncodeAsciiResponse;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuResponse;
+
+  std::pmr::vector<uint8_t> const data{0x02, 0x2B, 0x00, 0x00, 0x00, 0x64};
+  RtuResponse response{0x11, FunctionCode::kReadHR};
+  response.SetData(data);
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+
+  std::string const frame = EncodeAsciiResponse(response);
+  EXPECT_EQ(frame, ":110306022B0000006455\r\n");
+  auto const decoded = DecodeAsciiResponse(frame);
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(decoded->GetFunctionCode(), FunctionCode::kReadHR);
+  EXPECT_EQ(decoded->GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(decoded->GetData(), data);
+
+  RtuResponse exception_response{0x0A, FunctionCode::kReadHR};
+  exception_response.SetExceptionCode(ExceptionCode::kIllegalDataAddress);
+  auto const decoded_exception = DecodeAsciiResponse(EncodeAsciiResponse(exception_response));
+  ASSERT_TRUE(decoded_exception.has_value());
+  EXPECT_EQ(decoded_exception->GetFunctionCode(), FunctionCode::kReadHR);
+  EXPECT_EQ(decoded_exception->GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+}
+
+TEST(AsciiCodec, LongHexRoundTrip) {
+  using supermb::DecodeAsciiHex;
+  using supermb::EncodeAsciiHex;
+
+  // Long enough to cover the vector loop and the scalar tail
+  std::vector<uint8_t> bytes(253);
+  uint8_t expected_sum = 0;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<uint8_t>(i * 97 + 5);
+    expected_sum += bytes[i];
+  }
+
+  std::string hex(bytes.size() * 2, '\0');
+  EXPECT_EQ(EncodeAsciiHex(bytes, hex.data()), expected_sum);
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    EXPECT_EQ(hex.substr(i * 2, 2),
+              std::string({"0123456789ABCDEF"[bytes[i] >> 4], "0123456789ABCDEF"[bytes[i] & 0xF]}));
+  }
+
+  std::vector<uint8_t> decoded(bytes.size());
+  EXPECT_EQ(DecodeAsciiHex(hex, decoded.data()), expected_sum);
+  EXPECT_EQ(decoded, bytes);
+
+  for (char const bad_char : {'G', 'g', '/', ':', '@', '`', '\x80'}) {
+    std::string bad_hex = hex;
+    bad_hex[7] = bad_char;
+    EXPECT_FALSE(DecodeAsciiHex(bad_hex, decoded.data()).has_value()) << bad_char;
+  }
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <array>
+#include <chrono>
+#include <stop_token>
+#include <vector>
+#include "super_modbus/async/async_rtu_master.hpp"
+#include "super_modbus/async/event_loop.hpp"
+#include "super_modbus/async/task.hpp"
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_response.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Both ends of a non-blocking stream standing in for the serial line
+struct Line {
+  Line() { EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds.data()), 0); }
+  Line(Line const &) = delete;
+  Line &operator=(Line const &) = delete;
+  ~Line() {
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  [[nodiscard]] int Master() const { return fds[0]; }
+  [[nodiscard]] int Slave() const { return fds[1]; }
+
+  std::array<int, 2> fds{-1, -1};
+};
+
+// Answers request_count requests on the slave end, all from the same loop as the master
+supermb::Task<void> ServeSlave(supermb::EventLoop &loop, int fd, supermb::RtuSlave &slave, int request_count) {
+  for (int served = 0; served < request_count; ++served) {
+    if (co_await loop.Readable(fd, 1s) != supermb::WaitResult::kReady) {
+      co_return;
+    }
+    std::array<uint8_t, supermb::kMaxRtuFrameSize> request_frame{};
+    ssize_t const size = read(fd, request_frame.data(), request_frame.size());
+    auto const request = supermb::DecodeRtuRequestFrame({request_frame.data(), static_cast<size_t>(size)});
+    if (!request.has_value()) {
+      co_return;
+    }
+
+    std::vector<uint8_t> response_frame;
+    supermb::EncodeRtuFrame(slave.Process(request.value()), response_frame);
+    // Split in two to exercise reassembly
+    [[maybe_unused]] auto written = write(fd, response_frame.data(), 3);
+    co_await loop.Sleep(1ms);
+    written = write(fd, response_frame.data() + 3, response_frame.size() - 3);
+  }
+}
+
+supermb::RtuRequest MakeReadRequest(uint8_t slave_id, supermb::AddressSpan span) {
+  supermb::RtuRequest request{{slave_id, supermb::FunctionCode::kReadHR}};
+  request.SetAddressSpan(span);
+  return request;
+}
+
+}  // namespace
+
+TEST(AsyncRtuMaster, TransactsWithSlave) {
+  using supermb::AsyncRtuMaster;
+  using supermb::EventLoop;
+  using supermb::TransactionResult;
+  using supermb::TransactionStatus;
+
+  EventLoop loop;
+  ASSERT_TRUE(loop.IsValid());
+  Line const line;
+  supermb::RtuSlave slave{7};
+  slave.AddHoldingRegisters({0, 10});
+  AsyncRtuMaster master{loop, line.Master()};
+
+  std::vector<TransactionResult> results;
+  loop.Spawn(ServeSlave(loop, line.Slave(), slave, 2));
+  loop.Spawn([](AsyncRtuMaster &master, std::vector<TransactionResult> &results) -> supermb::Task<void> {
+    results.push_back(co_await master.Transact(MakeReadRequest(7, {0, 4}), 500ms));
+    results.push_back(co_await master.Transact(MakeReadRequest(7, {8, 4}), 500ms));
+  }(master, results));
+  loop.Run();
+
+  ASSERT_EQ(results.size(), 2U);
+  EXPECT_EQ(results[0].status, TransactionStatus::kOk);
+  ASSERT_TRUE(results[0].response.has_value());
+  EXPECT_EQ(results[0].response->GetData().size(), 8U);
+  // Out of range, answered with an exception
+  EXPECT_EQ(results[1].status, TransactionStatus::kOk);
+  ASSERT_TRUE(results[1].response.has_value());
+  EXPECT_EQ(results[1].response->GetExceptionCode(), supermb::ExceptionCode::kIllegalDataAddress);
+}
+
+TEST(AsyncRtuMaster, QueuesConcurrentTransactionsInOrder) {
+  using supermb::AsyncRtuMaster;
+  using supermb::EventLoop;
+  using supermb::TransactionStatus;
+
+  EventLoop loop;
+  Line const line;
+  supermb::RtuSlave slave{7};
+  slave.AddHoldingRegisters({0, 10});
+  AsyncRtuMaster master{loop, line.Master()};
+
+  std::vector<uint16_t> completed;
+  loop.Spawn(ServeSlave(loop, line.Slave(), slave, 3));
+  for (uint16_t count = 1; count <= 3; ++count) {
+    loop.Spawn([](AsyncRtuMaster &master, uint16_t count, std::vector<uint16_t> &completed) -> supermb::Task<void> {
+      auto const result = co_await master.Transact(MakeReadRequest(7, {0, count}), 500ms);
+      if (result.status == TransactionStatus::kOk) {
+        completed.push_back(static_cast<uint16_t>(result.response->GetData().size() / 2));
+      }
+    }(master, count, completed));
+  }
+  loop.Run();
+
+  EXPECT_EQ(completed, (std::vector<uint16_t>{1, 2, 3}));
+}
+
+TEST(AsyncRtuMaster, TimesOutAndCancels) {
+  using supermb::AsyncRtuMaster;
+  using supermb::EventLoop;
+  using supermb::TransactionResult;
+  using supermb::TransactionStatus;
+
+  EventLoop loop;
+  Line const line;
+  AsyncRtuMaster master{loop, line.Master()};
+
+  // Nobody answers on the slave end
+  std::stop_source stop;
+  std::vector<TransactionResult> results(3);
+  loop.Spawn([](AsyncRtuMaster &master, TransactionResult &result) -> supermb::Task<void> {
+    result = co_await master.Transact(MakeReadRequest(7, {0, 1}), 20ms);
+  }(master, results[0]));
+  loop.Spawn([](AsyncRtuMaster &master, std::stop_token stop, TransactionResult &result) -> supermb::Task<void> {
+    result = co_await master.Transact(MakeReadRequest(7, {0, 1}), 10s, stop);
+  }(master, stop.get_token(), results[1]));
+  loop.Spawn([](EventLoop &loop, std::stop_source &stop) -> supermb::Task<void> {
+    co_await loop.Sleep(50ms);
+    stop.request_stop();
+  }(loop, stop));
+  // Broadcasts complete once sent
+  loop.Spawn([](AsyncRtuMaster &master, TransactionResult &result) -> supermb::Task<void> {
+    result = co_await master.Transact(MakeReadRequest(0, {0, 1}), 10s);
+  }(master, results[2]));
+
+  auto const start = EventLoop::Clock::now();
+  loop.Run();
+
+  EXPECT_EQ(results[0].status, TransactionStatus::kTimeout);
+  EXPECT_EQ(results[1].status, TransactionStatus::kCancelled);
+  EXPECT_EQ(results[2].status, TransactionStatus::kOk);
+  EXPECT_FALSE(results[2].response.has_value());
+  EXPECT_LT(EventLoop::Clock::now() - start, 5s);
+}
+
+TEST(AsyncRtuMaster, RejectsCorruptResponse) {
+  using supermb::AsyncRtuMaster;
+  using supermb::EventLoop;
+  using supermb::TransactionResult;
+  using supermb::TransactionStatus;
+
+  EventLoop loop;
+  Line const line;
+  AsyncRtuMaster master{loop, line.Master()};
+
+  // Bytes already waiting are stale and dropped before the request goes out
+  std::array<uint8_t, 3> const stale{0x07, 0x03, 0x02};
+  ASSERT_EQ(write(line.Slave(), stale.data(), stale.size()), static_cast<ssize_t>(stale.size()));
+
+  supermb::RtuResponse response{7, supermb::FunctionCode::kReadHR};
+  std::array<uint8_t, 2> const data{0x12, 0x34};
+  response.SetData(data);
+  std::vector<uint8_t> frame;
+  supermb::EncodeRtuFrame(response, frame);
+  frame.back() ^= 1;
+
+  loop.Spawn([](EventLoop &loop, int fd, std::vector<uint8_t> const &frame) -> supermb::Task<void> {
+    if (co_await loop.Readable(fd, 1s) == supermb::WaitResult::kReady) {
+      std::array<uint8_t, supermb::kMaxRtuFrameSize> request_frame{};
+      [[maybe_unused]] auto const received = read(fd, request_frame.data(), request_frame.size());
+      [[maybe_unused]] auto const written = write(fd, frame.data(), frame.size());
+    }
+  }(loop, line.Slave(), frame));
+  TransactionResult result;
+  loop.Spawn([](AsyncRtuMaster &master, TransactionResult &result) -> supermb::Task<void> {
+    result = co_await master.Transact(MakeReadRequest(7, {0, 1}), 500ms);
+  }(master, result));
+  loop.Run();
+
+  EXPECT_EQ(result.status, TransactionStatus::kInvalidResponse);
+}
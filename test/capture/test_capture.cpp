@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "super_modbus/capture/capture.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+
+namespace {
+
+std::string GetTempPath(std::string const &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Serves a few RTU requests from slave and captures both directions like a serial I/O thread would
+void CaptureSession(std::string const &path, supermb::RtuSlave &slave) {
+  using supermb::CaptureDirection;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+
+  supermb::CaptureWriter writer{path, supermb::CaptureFraming::kRtu};
+  ASSERT_TRUE(writer.IsOpen());
+
+  RtuRequest write_request{{slave.GetId(), FunctionCode::kWriteSingleReg}};
+  write_request.SetWriteSingleRegisterData(1, 42);
+  RtuRequest read_request{{slave.GetId(), FunctionCode::kReadHR}};
+  read_request.SetAddressSpan({0, 4});
+
+  for (RtuRequest const *request : {&write_request, &read_request}) {
+    std::vector<uint8_t> request_frame;
+    supermb::EncodeRtuFrame(*request, request_frame);
+    EXPECT_TRUE(writer.Record(CaptureDirection::kReceived, 0, request_frame));
+
+    std::vector<uint8_t> response_frame;
+    supermb::EncodeRtuFrame(slave.Process(*request), response_frame);
+    EXPECT_TRUE(writer.Record(CaptureDirection::kSent, 0, response_frame));
+  }
+  writer.Close();
+  EXPECT_EQ(writer.GetDroppedCount(), 0U);
+}
+
+}  // namespace
+
+TEST(Capture, WriteAndRead) {
+  using supermb::CaptureDirection;
+  using supermb::CaptureFraming;
+  using supermb::CaptureReader;
+  using supermb::CaptureWriter;
+
+  std::string const path = GetTempPath("super_modbus_capture_roundtrip.smbcap");
+  std::vector<uint8_t> const first_adu{0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  std::vector<uint8_t> const second_adu(supermb::kMaxCaptureAduSize, 0x5A);
+  {
+    CaptureWriter writer{path, CaptureFraming::kMbap};
+    EXPECT_TRUE(writer.Record(CaptureDirection::kReceived, 3, first_adu));
+    EXPECT_TRUE(writer.Record(CaptureDirection::kSent, 4, second_adu));
+    EXPECT_FALSE(writer.Record(CaptureDirection::kSent, 4, std::vector<uint8_t>(supermb::kMaxCaptureAduSize + 1)));
+    EXPECT_EQ(writer.GetDroppedCount(), 1U);
+  }
+
+  auto reader = CaptureReader::Open(path);
+  ASSERT_TRUE(reader.has_value());
+  EXPECT_EQ(reader->GetFraming(), CaptureFraming::kMbap);
+
+  auto const first = reader->Next();
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(first->direction, CaptureDirection::kReceived);
+  EXPECT_EQ(first->port, 3);
+  EXPECT_TRUE(std::ranges::equal(first->GetAdu(), first_adu));
+
+  auto const second = reader->Next();
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(second->direction, CaptureDirection::kSent);
+  EXPECT_EQ(second->port, 4);
+  EXPECT_GE(second->timestamp, first->timestamp);
+  EXPECT_TRUE(std::ranges::equal(second->GetAdu(), second_adu));
+
+  EXPECT_FALSE(reader->Next().has_value());
+  EXPECT_FALSE(CaptureReader::Open(GetTempPath("super_modbus_capture_missing.smbcap")).has_value());
+}
+
+TEST(Capture, ReplayIntoSlave) {
+  using supermb::CaptureReader;
+  using supermb::ReplayIntoSlave;
+  using supermb::RtuSlave;
+
+  std::string const path = GetTempPath("super_modbus_capture_replay.smbcap");
+  RtuSlave captured_slave{7};
+  captured_slave.AddHoldingRegisters({0, 4});
+  CaptureSession(path, captured_slave);
+
+  // Same configuration: identical responses
+  RtuSlave slave{7};
+  slave.AddHoldingRegisters({0, 4});
+  auto reader = CaptureReader::Open(path);
+  ASSERT_TRUE(reader.has_value());
+  auto const result = ReplayIntoSlave(reader.value(), slave, 0.0);
+  EXPECT_EQ(result.requests, 2U);
+  EXPECT_EQ(result.mismatches, 0U);
+  EXPECT_EQ(result.undecodable, 0U);
+
+  // Fewer registers: the read now fails, which replay reports
+  RtuSlave smaller_slave{7};
+  smaller_slave.AddHoldingRegisters({0, 2});
+  reader = CaptureReader::Open(path);
+  ASSERT_TRUE(reader.has_value());
+  EXPECT_EQ(ReplayIntoSlave(reader.value(), smaller_slave, 0.0).mismatches, 1U);
+}
+
+TEST(Capture, ReplayKeepsOriginalTiming) {
+  using supermb::CaptureDirection;
+  using supermb::CaptureFraming;
+  using supermb::CaptureReader;
+  using supermb::CaptureRecord;
+  using supermb::CaptureWriter;
+
+  static constexpr std::chrono::milliseconds kGap{40};
+
+  std::string const path = GetTempPath("super_modbus_capture_timing.smbcap");
+  std::vector<uint8_t> const adu{0x01, 0x02};
+  {
+    CaptureWriter writer{path, CaptureFraming::kRtu};
+    writer.Record(CaptureDirection::kReceived, 0, adu);
+    std::this_thread::sleep_for(kGap);
+    writer.Record(CaptureDirection::kReceived, 0, adu);
+  }
+
+  auto reader = CaptureReader::Open(path);
+  ASSERT_TRUE(reader.has_value());
+  std::vector<std::chrono::steady_clock::time_point> replay_times;
+  size_t const replayed = supermb::Replay(reader.value(), 2.0, [&replay_times](CaptureRecord const & /*record*/) {
+    replay_times.push_back(std::chrono::steady_clock::now());
+  });
+  ASSERT_EQ(replayed, 2U);
+  EXPECT_GE(replay_times[1] - replay_times[0], kGap / 2 - std::chrono::milliseconds{1});
+}
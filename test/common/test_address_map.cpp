@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "super_modbus/common/address_map.hpp"
+#include "super_modbus/common/address_span.hpp"
+
+TEST(AddressMap, MaskWrite) {
+  using supermb::AddressMap;
+
+  static constexpr uint16_t kValue{0x12};
+  static constexpr uint16_t kAndMask{0xF2};
+  static constexpr uint16_t kOrMask{0x25};
+
+  AddressMap<uint16_t> address_map;
+  address_map.AddAddressSpan({4, 1});
+  address_map.Set(4, kValue);
+
+  // Example from the Modbus application protocol specification
+  EXPECT_EQ(address_map.MaskWrite(4, kAndMask, kOrMask), 0x17);
+  EXPECT_EQ(address_map[4], 0x17);
+
+  EXPECT_FALSE(address_map.MaskWrite(5, kAndMask, kOrMask));
+}
+
+TEST(AddressMap, ConcurrentMaskWritesKeepAllBits) {
+  using supermb::AddressMap;
+
+  static constexpr int kThreadCount{8};
+  static constexpr int kIterations{2000};
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, 1});
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&address_map, t] {
+      auto const bit = static_cast<int16_t>(1 << t);
+      for (int i = 0; i < kIterations; ++i) {
+        // Clear our bit, then set it again, leaving every other bit untouched
+        address_map.MaskWrite(0, static_cast<int16_t>(~bit), 0);
+        address_map.MaskWrite(0, static_cast<int16_t>(~bit), bit);
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(address_map[0], static_cast<int16_t>((1 << kThreadCount) - 1));
+}
+
+TEST(AddressMap, ReadAndWriteRanges) {
+  using supermb::AddressMap;
+
+  AddressMap<int16_t> address_map;
+  // Crosses a page boundary
+  address_map.AddAddressSpan({250, 10});
+
+  std::vector<int16_t> const values{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  EXPECT_TRUE(address_map.WriteRange({250, 10}, values));
+  std::vector<int16_t> read(10);
+  EXPECT_TRUE(address_map.ReadRange({250, 10}, read));
+  EXPECT_EQ(read, values);
+  EXPECT_EQ(address_map[255], 6);
+  EXPECT_EQ(address_map[256], 7);
+
+  // One missing address fails the whole span without touching anything
+  std::vector<int16_t> untouched(11, -1);
+  EXPECT_FALSE(address_map.ReadRange({250, 11}, untouched));
+  EXPECT_EQ(untouched, std::vector<int16_t>(11, -1));
+  EXPECT_FALSE(address_map.WriteRange({249, 2}, values));
+  EXPECT_EQ(address_map[250], 1);
+
+  // Output too small
+  std::vector<int16_t> small(2);
+  EXPECT_FALSE(address_map.ReadRange({250, 3}, small));
+
+  EXPECT_TRUE(address_map.Contains({250, 10}));
+  EXPECT_TRUE(address_map.Contains({0, 0}));
+  EXPECT_FALSE(address_map.Contains({0xFFFF, 2}));
+
+  address_map.RemoveAddressSpan({255, 1});
+  EXPECT_FALSE(address_map.Contains({250, 10}));
+  EXPECT_FALSE(address_map[255].has_value());
+  EXPECT_FALSE(address_map[-1].has_value());
+  EXPECT_FALSE(address_map[0x10000].has_value());
+}
+
+TEST(AddressMap, ContainsMatchesPerAddressLookup) {
+  using supermb::AddressMap;
+  using supermb::AddressSpan;
+
+  // Holes at word and page edges and in the middle of words, over three pages
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, 768});
+  for (uint16_t const hole : {0, 63, 64, 127, 200, 255, 256, 319, 383, 500, 511, 767}) {
+    address_map.RemoveAddressSpan({hole, 1});
+  }
+
+  std::mt19937 generator{7};
+  std::uniform_int_distribution<uint16_t> start_distribution{0, 800};
+  std::uniform_int_distribution<uint16_t> count_distribution{0, 300};
+  for (int i = 0; i < 20000; ++i) {
+    AddressSpan const span{start_distribution(generator), count_distribution(generator)};
+    bool expected = true;
+    for (int address = span.start_address; address < span.start_address + span.reg_count; ++address) {
+      expected = expected && address_map[address].has_value();
+    }
+    ASSERT_EQ(address_map.Contains(span), expected) << span.start_address << " " << span.reg_count;
+  }
+}
+
+TEST(AddressMap, ContiguousView) {
+  using supermb::AddressMap;
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({250, 10});
+  address_map.Set(251, 42);
+
+  auto const view = address_map.GetContiguousView({250, 6});
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(view->size(), 6U);
+  EXPECT_EQ((*view)[1], 42);
+
+  // Crosses a page boundary, or has a missing address
+  EXPECT_FALSE(address_map.GetContiguousView({250, 10}).has_value());
+  EXPECT_FALSE(address_map.GetContiguousView({240, 12}).has_value());
+}
+
+TEST(AddressMap, AddressSpaceEnd) {
+  using supermb::AddressMap;
+
+  AddressMap<uint16_t> address_map;
+  // Clamped to the last address instead of wrapping around
+  address_map.AddAddressSpan({0xFFFE, 10});
+  EXPECT_TRUE(address_map.Contains({0xFFFE, 2}));
+  EXPECT_FALSE(address_map[0].has_value());
+  EXPECT_TRUE(address_map.Set(0xFFFF, 7));
+  EXPECT_EQ(address_map[0xFFFF], 7);
+}
+
+TEST(AddressMap, SnapshotIsCopyOnWrite) {
+  using supermb::AddressMap;
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, 600});
+  address_map.Set(10, 1);
+  address_map.Set(500, 2);
+
+  auto const snapshot = address_map.Snapshot();
+  address_map.Set(10, 3);
+  std::vector<int16_t> const values{4, 5};
+  address_map.WriteRange({499, 2}, values);
+  address_map.MaskWrite(11, 0, 0x7F);
+  address_map.AddAddressSpan({1000, 1});
+  address_map.RemoveAddressSpan({0, 5});
+
+  // The snapshot keeps the values from when it was taken
+  EXPECT_EQ(snapshot[10], 1);
+  EXPECT_EQ(snapshot[500], 2);
+  EXPECT_EQ(snapshot[11], 0);
+  EXPECT_TRUE(snapshot.Contains({0, 600}));
+  EXPECT_FALSE(snapshot[1000].has_value());
+
+  EXPECT_EQ(address_map[10], 3);
+  EXPECT_EQ(address_map[500], 5);
+  EXPECT_EQ(address_map[11], 0x7F);
+  EXPECT_TRUE(address_map[1000].has_value());
+  EXPECT_FALSE(address_map[0].has_value());
+}
+
+TEST(AddressMap, SnapshotReadWhileWriting) {
+  using supermb::AddressMap;
+
+  static constexpr int kSnapshotCount{200};
+  static constexpr uint16_t kCount{300};
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, kCount});
+
+  // Every write sets all registers to the same value, so a consistent snapshot never mixes two values
+  std::vector<int16_t> values(kCount);
+  std::atomic<bool> consistent{true};
+  std::vector<std::thread> readers;
+  for (int i = 1; i <= kSnapshotCount; ++i) {
+    std::ranges::fill(values, static_cast<int16_t>(i));
+    address_map.WriteRange({0, kCount}, values);
+    readers.emplace_back([snapshot = address_map.Snapshot(), &consistent] {
+      std::vector<int16_t> read(kCount);
+      snapshot.ReadRange({0, kCount}, read);
+      if (std::ranges::count(read, read[0]) != kCount) {
+        consistent = false;
+      }
+    });
+  }
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_TRUE(consistent);
+}
+
+TEST(AddressMap, ConcurrentWritesAfterSnapshotKeepEveryBit) {
+  using supermb::AddressMap;
+
+  static constexpr int kRoundCount{200};
+  static constexpr int kBitCount{16};
+
+  AddressMap<uint16_t> address_map;
+  address_map.AddAddressSpan({0, 1});
+
+  // Every round, each thread sets its own bit right after a snapshot, so they all race to unshare the same page
+  for (int round = 0; round < kRoundCount; ++round) {
+    address_map.Set(0, 0);
+    auto const snapshot = address_map.Snapshot();
+    std::vector<std::thread> writers;
+    for (int bit = 0; bit < kBitCount; ++bit) {
+      writers.emplace_back([&address_map, bit] {
+        auto const mask = static_cast<uint16_t>(1U << bit);
+        address_map.MaskWrite(0, static_cast<uint16_t>(~mask), mask);
+      });
+    }
+    for (auto &writer : writers) {
+      writer.join();
+    }
+
+    ASSERT_EQ(address_map[0], 0xFFFF);
+    ASSERT_EQ(snapshot[0], 0);
+  }
+}
+
+TEST(AddressMap, ReadWhileUnsharingAndDroppingSnapshot) {
+  using supermb::AddressMap;
+
+  static constexpr int kRoundCount{500};
+  static constexpr uint16_t kCount{256};
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, kCount});
+
+  // A reader of the map may still be on a page a writer has just unshared while the snapshot holding the old copy is
+  // dropped; the old copy must outlive that read
+  for (int round = 0; round < kRoundCount; ++round) {
+    auto snapshot = std::make_unique<AddressMap<int16_t>>(address_map.Snapshot());
+    std::atomic<bool> done{false};
+    std::thread reader{[&address_map, &done] {
+      std::vector<int16_t> read(kCount);
+      while (!done.load()) {
+        address_map.ReadRange({0, kCount}, read);
+      }
+    }};
+    address_map.Set(0, static_cast<int16_t>(round));
+    snapshot.reset();
+    done = true;
+    reader.join();
+    ASSERT_EQ(address_map[0], round);
+  }
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/common/function_code_info.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+
+TEST(FunctionCodeInfo, Lookup) {
+  using supermb::FunctionCode;
+  using supermb::GetFunctionCodeInfo;
+
+  static_assert(GetFunctionCodeInfo(FunctionCode::kReadHR).has_address_span);
+  static_assert(GetFunctionCodeInfo(FunctionCode::kReadHR).quantity.max == 125);
+  static_assert(!GetFunctionCodeInfo(FunctionCode::kReadFIFOQueue).has_address_span);
+  EXPECT_FALSE(GetFunctionCodeInfo(FunctionCode::kInvalid).known);
+  EXPECT_FALSE(GetFunctionCodeInfo(static_cast<FunctionCode>(0x2B)).known);
+  EXPECT_FALSE(GetFunctionCodeInfo(static_cast<FunctionCode>(0xFF)).known);
+}
+
+TEST(FunctionCodeInfo, ValidatesRequestData) {
+  using supermb::FunctionCode;
+  using supermb::IsRequestDataValid;
+
+  static_assert(IsRequestDataValid(FunctionCode::kReadHR, std::array<uint8_t, 4>{0x00, 0x00, 0x00, 0x7D}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kReadHR, std::vector<uint8_t>{0x00, 0x00, 0x00, 0x7E}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kReadHR, std::vector<uint8_t>{0x00, 0x00, 0x00, 0x00}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kReadHR, std::vector<uint8_t>{0x00, 0x00, 0x00}));
+  EXPECT_TRUE(IsRequestDataValid(FunctionCode::kReadCoils, std::vector<uint8_t>{0x00, 0x00, 0x07, 0xD0}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kReadCoils, std::vector<uint8_t>{0x00, 0x00, 0x07, 0xD1}));
+
+  // Write single register needs both address and value
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kWriteSingleReg, std::vector<uint8_t>{0x00, 0x01}));
+  EXPECT_TRUE(IsRequestDataValid(FunctionCode::kWriteSingleReg, std::vector<uint8_t>{0x00, 0x01, 0x12, 0x34}));
+
+  // Byte count must match both the data and the quantity
+  EXPECT_TRUE(IsRequestDataValid(FunctionCode::kWriteMultRegs, std::vector<uint8_t>{0, 1, 0, 1, 2, 0x12, 0x34}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kWriteMultRegs, std::vector<uint8_t>{0, 1, 0, 2, 2, 0x12, 0x34}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kWriteMultRegs, std::vector<uint8_t>{0, 1, 0, 1, 2, 0x12}));
+  EXPECT_TRUE(IsRequestDataValid(FunctionCode::kWriteMultCoils, std::vector<uint8_t>{0, 0, 0, 9, 2, 0xFF, 0x01}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kWriteMultCoils, std::vector<uint8_t>{0, 0, 0, 9, 1, 0xFF}));
+  EXPECT_TRUE(
+      IsRequestDataValid(FunctionCode::kReadWriteMultRegs, std::vector<uint8_t>{0, 0, 0, 2, 0, 4, 0, 1, 2, 0, 7}));
+  EXPECT_FALSE(
+      IsRequestDataValid(FunctionCode::kReadWriteMultRegs, std::vector<uint8_t>{0, 0, 0, 0, 0, 4, 0, 1, 2, 0, 7}));
+
+  EXPECT_TRUE(IsRequestDataValid(FunctionCode::kReportSlaveID, {}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kReadFileRecord, {}));
+  EXPECT_FALSE(IsRequestDataValid(FunctionCode::kInvalid, {}));
+}
+
+// Random request data must never be read out of bounds, whatever it claims about its own length
+TEST(FunctionCodeInfo, FuzzedRequests) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+
+  supermb::RtuSlave slave{1};
+  slave.AddHoldingRegisters({0, 100});
+  slave.AddInputRegisters({0, 100});
+  slave.AddFifoQueue(0);
+
+  std::mt19937 generator{12345};
+  std::uniform_int_distribution<int> byte_distribution{0, 0xFF};
+  std::uniform_int_distribution<int> size_distribution{0, 24};
+  std::vector<uint8_t> data;
+  for (int iteration = 0; iteration < 20000; ++iteration) {
+    auto const function_code = static_cast<FunctionCode>(byte_distribution(generator) % 26);
+    data.resize(static_cast<size_t>(size_distribution(generator)));
+    for (uint8_t &byte : data) {
+      // Small values make plausible quantities and byte counts more likely
+      byte = static_cast<uint8_t>(byte_distribution(generator) % (iteration % 2 == 0 ? 0x100 : 0x10));
+    }
+
+    RtuRequest request{{1, function_code}};
+    request.SetRawData(data);
+    auto const response = slave.Process(request);
+    if (!supermb::IsRequestDataValid(function_code, data)) {
+      EXPECT_NE(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+    }
+  }
+}
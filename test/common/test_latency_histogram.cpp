@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "super_modbus/common/latency_histogram.hpp"
+
+TEST(LatencyHistogram, Percentiles) {
+  using supermb::LatencyHistogram;
+
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.GetValueAtPercentile(50.0), 0U);
+
+  for (uint64_t value = 1; value <= 100; ++value) {
+    histogram.Record(value * 1000);
+  }
+  EXPECT_EQ(histogram.GetCount(), 100U);
+  EXPECT_EQ(histogram.GetMin(), 1000U);
+  EXPECT_EQ(histogram.GetMax(), 100000U);
+  EXPECT_DOUBLE_EQ(histogram.GetMean(), 50500.0);
+
+  // Reported values are bucket upper bounds, within 1/64 of the recorded ones
+  EXPECT_NEAR(static_cast<double>(histogram.GetValueAtPercentile(50.0)), 50000.0, 50000.0 / 64);
+  EXPECT_NEAR(static_cast<double>(histogram.GetValueAtPercentile(99.0)), 99000.0, 99000.0 / 64);
+  EXPECT_EQ(histogram.GetValueAtPercentile(100.0), 100000U);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+  using supermb::LatencyHistogram;
+
+  LatencyHistogram histogram;
+  histogram.Record(5, 3);
+  histogram.Record(127);
+  EXPECT_EQ(histogram.GetValueAtPercentile(75.0), 5U);
+  EXPECT_EQ(histogram.GetValueAtPercentile(99.9), 127U);
+}
+
+TEST(LatencyHistogram, MergeAndClamp) {
+  using supermb::LatencyHistogram;
+
+  LatencyHistogram first;
+  LatencyHistogram second;
+  first.Record(10);
+  second.Record(LatencyHistogram::kMaxValue + 1);
+  first.Merge(second);
+
+  EXPECT_EQ(first.GetCount(), 2U);
+  EXPECT_EQ(first.GetMin(), 10U);
+  EXPECT_EQ(first.GetMax(), LatencyHistogram::kMaxValue);
+  EXPECT_EQ(first.GetValueAtPercentile(100.0), LatencyHistogram::kMaxValue);
+
+  first.Reset();
+  EXPECT_EQ(first.GetCount(), 0U);
+}
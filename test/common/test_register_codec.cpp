@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "super_modbus/common/address_map.hpp"
+#include "super_modbus/common/register_codec.hpp"
+
+TEST(RegisterCodec, WordOrders) {
+  using supermb::RegisterCodec;
+  using supermb::WordOrder;
+
+  static constexpr uint32_t kValue{0xAABBCCDD};
+
+  EXPECT_EQ((RegisterCodec<uint32_t, WordOrder::kAbcd>::Encode(kValue)), (std::array<uint16_t, 2>{0xAABB, 0xCCDD}));
+  EXPECT_EQ((RegisterCodec<uint32_t, WordOrder::kCdab>::Encode(kValue)), (std::array<uint16_t, 2>{0xCCDD, 0xAABB}));
+  EXPECT_EQ((RegisterCodec<uint32_t, WordOrder::kBadc>::Encode(kValue)), (std::array<uint16_t, 2>{0xBBAA, 0xDDCC}));
+  EXPECT_EQ((RegisterCodec<uint32_t, WordOrder::kDcba>::Encode(kValue)), (std::array<uint16_t, 2>{0xDDCC, 0xBBAA}));
+
+  static constexpr std::array<uint16_t, 2> kRegisters{0xCCDD, 0xAABB};
+  static_assert(RegisterCodec<uint32_t, WordOrder::kCdab>::Decode(kRegisters) == kValue);
+
+  static constexpr double kDouble{-1234.5678};
+  static constexpr auto kEncoded = RegisterCodec<double, WordOrder::kBadc>::Encode(kDouble);
+  static_assert(RegisterCodec<double, WordOrder::kBadc>::Decode(kEncoded) == kDouble);
+}
+
+template <supermb::WordOrder Order>
+static void ExpectBulkDecodeMatchesScalar() {
+  using supermb::RegisterCodec;
+
+  // 125 registers, as in a full FC 3 read
+  std::vector<uint8_t> bytes(250);
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<uint8_t>(i * 37 + 11);
+  }
+
+  std::vector<float> floats(70);
+  ASSERT_EQ((RegisterCodec<float, Order>::DecodeBytes(bytes, floats)), 62U);
+  for (size_t i = 0; i < 62; ++i) {
+    std::array<uint16_t, 2> const registers{static_cast<uint16_t>(bytes[i * 4] << 8 | bytes[i * 4 + 1]),
+                                            static_cast<uint16_t>(bytes[i * 4 + 2] << 8 | bytes[i * 4 + 3])};
+    EXPECT_EQ(std::bit_cast<uint32_t>(floats[i]),
+              std::bit_cast<uint32_t>((RegisterCodec<float, Order>::Decode(registers))));
+  }
+
+  std::vector<int64_t> integers(31);
+  ASSERT_EQ((RegisterCodec<int64_t, Order>::DecodeBytes(bytes, integers)), 31U);
+  for (size_t i = 0; i < 31; ++i) {
+    std::array<uint16_t, 4> registers{};
+    for (size_t j = 0; j < 4; ++j) {
+      registers[j] = static_cast<uint16_t>(bytes[i * 8 + j * 2] << 8 | bytes[i * 8 + j * 2 + 1]);
+    }
+    EXPECT_EQ(integers[i], (RegisterCodec<int64_t, Order>::Decode(registers)));
+  }
+}
+
+TEST(RegisterCodec, BulkDecodeMatchesScalar) {
+  using supermb::WordOrder;
+
+  ExpectBulkDecodeMatchesScalar<WordOrder::kAbcd>();
+  ExpectBulkDecodeMatchesScalar<WordOrder::kCdab>();
+  ExpectBulkDecodeMatchesScalar<WordOrder::kBadc>();
+  ExpectBulkDecodeMatchesScalar<WordOrder::kDcba>();
+}
+
+TEST(RegisterCodec, AddressMapValues) {
+  using supermb::AddressMap;
+  using supermb::ReadValue;
+  using supermb::WordOrder;
+  using supermb::WriteValue;
+
+  static constexpr float kValue{3.25F};
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, 3});
+
+  EXPECT_TRUE((WriteValue<float, WordOrder::kCdab>(address_map, 1, kValue)));
+  EXPECT_EQ((ReadValue<float, WordOrder::kCdab>(address_map, 1)), kValue);
+  EXPECT_EQ(address_map[1], 0);
+  EXPECT_EQ(address_map[2], 0x4050);
+
+  EXPECT_FALSE((WriteValue<float, WordOrder::kCdab>(address_map, 2, kValue)));
+  EXPECT_EQ(address_map[2], 0x4050);
+  EXPECT_FALSE((ReadValue<float, WordOrder::kCdab>(address_map, 2)).has_value());
+}
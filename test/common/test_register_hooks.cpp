@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "super_modbus/common/address_map.hpp"
+#include "super_modbus/common/register_hooks.hpp"
+
+namespace {
+
+// Hooks known at compile time: reads of address 0 report a counter, writes are recorded
+struct CountingHooks {
+  [[nodiscard]] static bool IsHooked(supermb::AddressSpan span) { return span.start_address == 0; }
+  [[nodiscard]] int16_t OnRead(uint16_t address, int16_t value) const {
+    return address == 0 ? static_cast<int16_t>(++*read_count) : value;
+  }
+  void OnWrite(uint16_t address, int16_t value) const { writes->emplace_back(address, value); }
+
+  int *read_count;
+  std::vector<std::pair<uint16_t, int16_t>> *writes;
+};
+
+static_assert(supermb::RegisterHooks<CountingHooks, int16_t>);
+static_assert(supermb::RegisterHooks<supermb::NoRegisterHooks, int16_t>);
+static_assert(supermb::RegisterHooks<supermb::RegisterHookTable<int16_t>, int16_t>);
+
+}  // namespace
+
+TEST(RegisterHooks, HookTable) {
+  using supermb::RegisterHookTable;
+
+  RegisterHookTable<int16_t> hooks;
+  EXPECT_FALSE(hooks.IsHooked({0, 0xFFFF}));
+
+  std::vector<std::pair<uint16_t, int16_t>> writes;
+  hooks.AddHook({100, 2}, [](uint16_t address, int16_t value) { return static_cast<int16_t>(value + address); },
+                [&writes](uint16_t address, int16_t value) { writes.emplace_back(address, value); });
+  // Overrides the read hook of address 101 only, and has no write hook
+  hooks.AddHook({101, 1}, [](uint16_t /*address*/, int16_t /*value*/) { return int16_t{-1}; }, {});
+
+  EXPECT_TRUE(hooks.IsHooked({0, 101}));
+  EXPECT_TRUE(hooks.IsHooked({101, 200}));
+  EXPECT_FALSE(hooks.IsHooked({0, 100}));
+  EXPECT_FALSE(hooks.IsHooked({102, 1000}));
+
+  EXPECT_EQ(hooks.OnRead(100, 5), 105);
+  EXPECT_EQ(hooks.OnRead(101, 5), -1);
+  EXPECT_EQ(hooks.OnRead(200, 5), 5);
+  hooks.OnWrite(100, 7);
+  hooks.OnWrite(101, 8);
+  EXPECT_EQ(writes, (std::vector<std::pair<uint16_t, int16_t>>{{100, 7}}));
+}
+
+TEST(RegisterHooks, ReadAndWriteRegisters) {
+  using supermb::AddressMap;
+  using supermb::NoRegisterHooks;
+  using supermb::ReadRegisters;
+  using supermb::WriteRegisters;
+
+  AddressMap<int16_t> address_map;
+  address_map.AddAddressSpan({0, 4});
+
+  int read_count = 0;
+  std::vector<std::pair<uint16_t, int16_t>> writes;
+  CountingHooks const hooks{&read_count, &writes};
+
+  std::array<int16_t, 2> const values{3, 4};
+  EXPECT_TRUE(WriteRegisters(address_map, hooks, {0, 2}, values));
+  EXPECT_TRUE(WriteRegisters(address_map, hooks, {2, 2}, values));
+  // Only the hooked span was reported
+  EXPECT_EQ(writes, (std::vector<std::pair<uint16_t, int16_t>>{{0, 3}, {1, 4}}));
+
+  std::array<int16_t, 4> read{};
+  EXPECT_TRUE(ReadRegisters(address_map, hooks, {0, 4}, read));
+  EXPECT_EQ(read, (std::array<int16_t, 4>{1, 4, 3, 4}));
+  EXPECT_TRUE(ReadRegisters(address_map, NoRegisterHooks{}, {0, 4}, read));
+  EXPECT_EQ(read, (std::array<int16_t, 4>{3, 4, 3, 4}));
+
+  // Hooks never run for spans that fail
+  std::array<int16_t, 5> too_long{};
+  EXPECT_FALSE(WriteRegisters(address_map, hooks, {0, 5}, too_long));
+  EXPECT_FALSE(ReadRegisters(address_map, hooks, {0, 5}, too_long));
+  EXPECT_EQ(writes.size(), 2U);
+  EXPECT_EQ(read_count, 1);
+}
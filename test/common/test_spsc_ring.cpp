@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "super_modbus/common/spsc_ring.hpp"
+
+TEST(SpscRing, PushPopUntilFull) {
+  using supermb::SpscRing;
+
+  SpscRing<int, 4> ring;
+  EXPECT_TRUE(ring.Empty());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.TryPush(i));
+  }
+  EXPECT_FALSE(ring.TryPush(4));
+  EXPECT_EQ(ring.Size(), 4U);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(ring.TryPop(), i);
+  }
+  EXPECT_FALSE(ring.TryPop().has_value());
+}
+
+TEST(SpscRing, ProducerConsumerThreadsPreserveOrder) {
+  using supermb::SpscRing;
+
+  static constexpr int kValueCount{10000};
+
+  SpscRing<int, 64> ring;
+  std::thread producer{[&ring] {
+    for (int i = 0; i < kValueCount; ++i) {
+      while (!ring.TryPush(i)) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  int expected = 0;
+  while (expected < kValueCount) {
+    auto const value = ring.TryPop();
+    if (value.has_value()) {
+      ASSERT_EQ(value.value(), expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  producer.join();
+  EXPECT_TRUE(ring.Empty());
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <array>
+#include "super_modbus/common/static_register_map.hpp"
+
+namespace {
+
+using supermb::RegisterAccess;
+using supermb::RegisterDefinition;
+using supermb::RegisterType;
+using supermb::StaticRegisterMap;
+
+constexpr std::array kDenseProfile{
+    RegisterDefinition{"status", 100, RegisterType::kUInt16, RegisterAccess::kReadOnly},
+    RegisterDefinition{"setpoint", 101, RegisterType::kFloat32, RegisterAccess::kReadWrite},
+    RegisterDefinition{"command", 104, RegisterType::kInt16, RegisterAccess::kWriteOnly}};
+
+constexpr std::array kSparseProfile{
+    RegisterDefinition{"serial", 0, RegisterType::kUInt32, RegisterAccess::kReadOnly},
+    RegisterDefinition{"energy", 1000, RegisterType::kFloat64, RegisterAccess::kReadOnly},
+    RegisterDefinition{"mode", 20000, RegisterType::kUInt16, RegisterAccess::kReadWrite},
+    RegisterDefinition{"limit", 40000, RegisterType::kInt16, RegisterAccess::kReadWrite},
+    RegisterDefinition{"trip", 65535, RegisterType::kUInt16, RegisterAccess::kReadWrite}};
+
+using DenseMap = StaticRegisterMap<kDenseProfile>;
+using SparseMap = StaticRegisterMap<kSparseProfile>;
+
+static_assert(DenseMap::kIsDense);
+static_assert(DenseMap::kWordCount == 4);
+static_assert(DenseMap::kStorageSize == 5);
+static_assert(DenseMap::GetOffset("setpoint") == 1);
+static_assert(DenseMap::GetOffset("command") == 4);
+static_assert(!DenseMap::GetOffset(103).has_value());
+
+static_assert(!SparseMap::kIsDense);
+static_assert(SparseMap::kStorageSize == SparseMap::kWordCount);
+static_assert(SparseMap::GetOffset("energy") == 2);
+static_assert(SparseMap::GetOffset(1003) == 5);
+static_assert(SparseMap::GetDefinition("trip").address == 65535);
+
+}  // namespace
+
+TEST(StaticRegisterMap, DenseLookup) {
+  DenseMap registers;
+  EXPECT_TRUE(registers.Set(102, 7));
+  EXPECT_EQ(registers[102], 7);
+  EXPECT_EQ(registers.GetWords()[DenseMap::GetOffset("setpoint") + 1], 7);
+
+  EXPECT_FALSE(registers.Set(99, 1));
+  EXPECT_FALSE(registers.Set(103, 1));
+  EXPECT_FALSE(registers.Set(105, 1));
+  EXPECT_FALSE(registers[103].has_value());
+
+  EXPECT_TRUE(DenseMap::IsReadable(100));
+  EXPECT_FALSE(DenseMap::IsWritable(100));
+  EXPECT_FALSE(DenseMap::IsReadable(104));
+  EXPECT_TRUE(DenseMap::IsWritable(104));
+}
+
+TEST(StaticRegisterMap, SparseLookup) {
+  SparseMap registers;
+  for (int address = 0; address <= 0xFFFF; ++address) {
+    bool const defined = address <= 1 || (address >= 1000 && address <= 1003) || address == 20000 ||
+                         address == 40000 || address == 65535;
+    EXPECT_EQ(SparseMap::GetOffset(address).has_value(), defined) << address;
+  }
+  EXPECT_FALSE(SparseMap::GetOffset(-1).has_value());
+  EXPECT_FALSE(SparseMap::GetOffset(0x10000).has_value());
+
+  EXPECT_TRUE(registers.Set(40000, -3));
+  EXPECT_EQ(registers[40000], -3);
+  EXPECT_EQ(registers.GetWords()[SparseMap::GetOffset("limit")], -3);
+  EXPECT_FALSE(SparseMap::IsWritable(1000));
+  EXPECT_TRUE(SparseMap::IsWritable(20000));
+}
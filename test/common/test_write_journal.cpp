@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "super_modbus/common/write_journal.hpp"
+
+TEST(WriteJournal, AppendDrainUntilFull) {
+  using supermb::JournaledWrite;
+  using supermb::WriteJournal;
+
+  WriteJournal journal{6};
+  EXPECT_EQ(journal.GetCapacity(), 8U);
+
+  std::array<int16_t, 5> const values{1, 2, 3, 4, 5};
+  EXPECT_TRUE(journal.TryAppend(1, 10, values));
+  // All or nothing: 5 more do not fit in the 3 slots left
+  EXPECT_FALSE(journal.TryAppend(2, 20, values));
+  EXPECT_TRUE(journal.TryAppend(2, 20, std::span{values}.first(3)));
+  EXPECT_EQ(journal.Size(), 8U);
+
+  std::array<JournaledWrite, 16> out{};
+  ASSERT_EQ(journal.Drain(out), 8U);
+  for (uint64_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(out[i].sequence, i);
+  }
+  EXPECT_EQ(out[4].slave_id, 1);
+  EXPECT_EQ(out[4].address, 14);
+  EXPECT_EQ(out[4].value, 5);
+  EXPECT_EQ(out[5].slave_id, 2);
+  EXPECT_EQ(out[5].address, 20);
+  EXPECT_EQ(journal.Drain(out), 0U);
+
+  // Space is reusable once drained
+  EXPECT_TRUE(journal.TryAppend(1, 0, values));
+  EXPECT_EQ(journal.Drain(std::span{out}.first(2)), 2U);
+  EXPECT_EQ(out[0].sequence, 8U);
+  EXPECT_EQ(journal.Size(), 3U);
+}
+
+TEST(WriteJournal, DrainCoalescedKeepsLastWrite) {
+  using supermb::JournaledWrite;
+  using supermb::WriteJournal;
+
+  WriteJournal journal{16};
+  std::array<int16_t, 3> const first{1, 2, 3};
+  std::array<int16_t, 2> const second{20, 30};
+  std::array<int16_t, 1> const third{300};
+  EXPECT_TRUE(journal.TryAppend(1, 0, first));
+  EXPECT_TRUE(journal.TryAppend(1, 1, second));
+  EXPECT_TRUE(journal.TryAppend(2, 2, first));
+  EXPECT_TRUE(journal.TryAppend(1, 2, third));
+
+  std::array<JournaledWrite, 16> out{};
+  ASSERT_EQ(journal.DrainCoalesced(out), 6U);
+  std::vector<std::array<int, 3>> applied;
+  for (size_t i = 0; i < 6; ++i) {
+    applied.push_back({out[i].slave_id, out[i].address, out[i].value});
+  }
+  EXPECT_EQ(applied, (std::vector<std::array<int, 3>>{{1, 0, 1}, {1, 1, 20}, {1, 2, 300}, {2, 2, 1}, {2, 3, 2},
+                                                      {2, 4, 3}}));
+}
+
+TEST(WriteJournal, ProducerThreadsKeepRequestsContiguous) {
+  using supermb::JournaledWrite;
+  using supermb::WriteJournal;
+
+  static constexpr int kProducerCount{4};
+  static constexpr int kRequestCount{2000};
+  static constexpr size_t kRequestSize{3};
+
+  WriteJournal journal{64};
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducerCount; ++producer) {
+    producers.emplace_back([&journal, producer] {
+      for (int request = 0; request < kRequestCount; ++request) {
+        std::array<int16_t, kRequestSize> values{};
+        values.fill(static_cast<int16_t>(request));
+        while (!journal.TryAppend(static_cast<uint8_t>(producer), 0, values)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::array<int, kProducerCount> next_request{};
+  std::array<JournaledWrite, 32> out{};
+  std::vector<JournaledWrite> pending;
+  uint64_t expected_sequence = 0;
+  size_t received = 0;
+  while (received < kProducerCount * kRequestCount * kRequestSize) {
+    size_t const count = journal.Drain(out);
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_EQ(out[i].sequence, expected_sequence++);
+      pending.push_back(out[i]);
+    }
+    received += count;
+    // Each request arrives whole and in order, and each producer's requests in the order it made them
+    while (pending.size() >= kRequestSize) {
+      for (size_t i = 0; i < kRequestSize; ++i) {
+        ASSERT_EQ(pending[i].slave_id, pending[0].slave_id);
+        ASSERT_EQ(pending[i].address, i);
+        ASSERT_EQ(pending[i].value, next_request[pending[0].slave_id]);
+      }
+      ++next_request[pending[0].slave_id];
+      pending.erase(pending.begin(), pending.begin() + kRequestSize);
+    }
+    if (count == 0) {
+      std::this_thread::yield();
+    }
+  }
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(pending.empty());
+  EXPECT_EQ(journal.Size(), 0U);
+}
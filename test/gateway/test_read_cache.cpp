@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <vector>
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/gateway/read_cache.hpp"
+
+TEST(ReadCache, ServesSubRangesUntilExpiry) {
+  using supermb::FunctionCode;
+  using supermb::ReadCache;
+
+  ReadCache cache{{{1, FunctionCode::kReadHR, {100, 20}, std::chrono::milliseconds{500}},
+                   {1, FunctionCode::kReadIR, {0, 10}, std::chrono::milliseconds{50}}}};
+
+  EXPECT_EQ(cache.GetTtl(1, FunctionCode::kReadHR, {105, 5}), std::chrono::milliseconds{500});
+  EXPECT_FALSE(cache.GetTtl(1, FunctionCode::kReadHR, {115, 10}).has_value());
+  EXPECT_FALSE(cache.GetTtl(2, FunctionCode::kReadHR, {105, 5}).has_value());
+
+  auto const now = ReadCache::Clock::now();
+  std::vector<uint8_t> const register_bytes{0, 1, 0, 2, 0, 3, 0, 4};
+  cache.Insert(1, FunctionCode::kReadHR, {100, 4}, register_bytes, now);
+
+  std::array<uint8_t, 4> out{};
+  EXPECT_TRUE(cache.Lookup(1, FunctionCode::kReadHR, {101, 2}, now, out));
+  EXPECT_EQ(out, (std::array<uint8_t, 4>{0, 2, 0, 3}));
+  EXPECT_FALSE(cache.Lookup(1, FunctionCode::kReadIR, {101, 2}, now, out));
+  EXPECT_FALSE(cache.Lookup(1, FunctionCode::kReadHR, {103, 2}, now, out));
+  EXPECT_FALSE(cache.Lookup(1, FunctionCode::kReadHR, {101, 2}, now + std::chrono::milliseconds{500}, out));
+
+  cache.Invalidate(1, FunctionCode::kReadHR, {103, 1});
+  EXPECT_FALSE(cache.Lookup(1, FunctionCode::kReadHR, {101, 2}, now, out));
+}
@@ -0,0 +1,444 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/gateway/rtu_gateway.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+#include "super_modbus/tcp/mbap.hpp"
+
+namespace {
+
+// Serial bus with one simulated slave. While held, Transact blocks, which keeps requests queued in the gateway.
+class SlaveSerialLine : public supermb::SerialLine {
+ public:
+  explicit SlaveSerialLine(uint8_t slave_id)
+      : slave_(slave_id) {
+    slave_.AddHoldingRegisters({0, 10});
+  }
+
+  size_t Transact(std::span<uint8_t const> request, std::span<uint8_t, supermb::kMaxRtuFrameSize> response,
+                  std::chrono::milliseconds /*timeout*/) override {
+    std::unique_lock lock{mutex_};
+    ++entered_count_;
+    held_cv_.notify_all();
+    held_cv_.wait(lock, [this] { return !held_ || released_ > 0; });
+    if (held_) {
+      --released_;
+    }
+    ++transaction_count_;
+
+    auto const decoded = supermb::DecodeRtuRequestFrame(request);
+    if (!decoded.has_value() || decoded->GetSlaveId() != slave_.GetId() || silent_) {
+      return 0;
+    }
+
+    std::vector<uint8_t> frame;
+    supermb::EncodeRtuFrame(slave_.Process(decoded.value()), frame);
+    std::ranges::copy(frame, response.begin());
+    return frame.size();
+  }
+
+  void Hold(bool held) {
+    {
+      std::lock_guard lock{mutex_};
+      held_ = held;
+    }
+    held_cv_.notify_all();
+  }
+
+  // Lets count more requests through while held
+  void Release(int count) {
+    {
+      std::lock_guard lock{mutex_};
+      released_ += count;
+    }
+    held_cv_.notify_all();
+  }
+
+  // Waits until count requests have been put on the bus, held or not
+  void WaitForEntered(int count) {
+    std::unique_lock lock{mutex_};
+    held_cv_.wait(lock, [this, count] { return entered_count_ >= count; });
+  }
+
+  int GetTransactionCount() {
+    std::lock_guard lock{mutex_};
+    return transaction_count_;
+  }
+
+  void SetSilent(bool silent) {
+    std::lock_guard lock{mutex_};
+    silent_ = silent;
+  }
+
+ private:
+  supermb::RtuSlave slave_;
+  std::mutex mutex_;
+  std::condition_variable held_cv_;
+  bool held_{false};
+  bool silent_{false};
+  int released_{0};
+  int transaction_count_{0};
+  int entered_count_{0};
+};
+
+struct ResponseCollector {
+  void Add(std::span<uint8_t const> frame) {
+    {
+      std::lock_guard lock{mutex};
+      frames.emplace_back(frame.begin(), frame.end());
+    }
+    cv.notify_all();
+  }
+
+  std::vector<std::vector<uint8_t>> WaitFor(size_t count) {
+    std::unique_lock lock{mutex};
+    cv.wait_for(lock, std::chrono::seconds{5}, [this, count] { return frames.size() >= count; });
+    return frames;
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::vector<uint8_t>> frames;
+};
+
+std::vector<uint8_t> MakeReadFrame(uint16_t transaction_id, uint8_t unit_id, supermb::AddressSpan span = {0, 2}) {
+  supermb::RtuRequest request{{unit_id, supermb::FunctionCode::kReadHR}};
+  request.SetAddressSpan(span);
+  std::vector<uint8_t> frame;
+  supermb::EncodeMbapFrame(transaction_id, request, frame);
+  return frame;
+}
+
+std::vector<uint8_t> MakeWriteFrame(uint16_t transaction_id, uint8_t unit_id, uint16_t address, int16_t value) {
+  supermb::RtuRequest request{{unit_id, supermb::FunctionCode::kWriteSingleReg}};
+  request.SetWriteSingleRegisterData(address, value);
+  std::vector<uint8_t> frame;
+  supermb::EncodeMbapFrame(transaction_id, request, frame);
+  return frame;
+}
+
+}  // namespace
+
+TEST(RtuGateway, ForwardsRequestsToRoutedLine) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::ExceptionCode;
+  using supermb::RtuGateway;
+
+  ResponseCollector collector;
+  RtuGateway gateway{{}, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::make_unique<SlaveSerialLine>(7)));
+  gateway.Start();
+
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(0x1234, 7)));
+  auto const frames = collector.WaitFor(1);
+  ASSERT_EQ(frames.size(), 1U);
+
+  auto const response = DecodeMbapResponseFrame(frames[0]);
+  ASSERT_TRUE(response.has_value());
+  EXPECT_EQ(response->first.transaction_id, 0x1234);
+  EXPECT_EQ(response->first.unit_id, 7);
+  EXPECT_EQ(response->second.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(response->second.GetData().size(), 4U);
+
+  // Truncated frame is rejected outright
+  auto truncated = MakeReadFrame(1, 7);
+  truncated.pop_back();
+  EXPECT_FALSE(gateway.Submit(1, truncated));
+}
+
+TEST(RtuGateway, FailsFastWhenUnroutedOrQueueFull) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::ExceptionCode;
+  using supermb::RtuGateway;
+
+  ResponseCollector collector;
+  RtuGateway gateway{{}, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  SlaveSerialLine &line = *serial_line;
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(1, 8)));
+  auto frames = collector.WaitFor(1);
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(DecodeMbapResponseFrame(frames[0])->second.GetExceptionCode(), ExceptionCode::kGatewayPathUnavailable);
+
+  // With the bus held, the queue fills up and the next request is refused without waiting
+  line.Hold(true);
+  for (uint16_t i = 0; i < RtuGateway::kLineQueueDepth; ++i) {
+    EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(100 + i, 7)));
+  }
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(999, 7)));
+  frames = collector.WaitFor(2);
+  ASSERT_EQ(frames.size(), 2U);
+  auto const overflow = DecodeMbapResponseFrame(frames[1]);
+  EXPECT_EQ(overflow->first.transaction_id, 999);
+  EXPECT_EQ(overflow->second.GetExceptionCode(), ExceptionCode::kGatewayPathUnavailable);
+
+  line.Hold(false);
+  frames = collector.WaitFor(2 + RtuGateway::kLineQueueDepth);
+  EXPECT_EQ(frames.size(), 2 + RtuGateway::kLineQueueDepth);
+}
+
+TEST(RtuGateway, ReportsTargetFailureOnTimeout) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::ExceptionCode;
+  using supermb::RtuGateway;
+
+  ResponseCollector collector;
+  RtuGateway gateway{{}, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  serial_line->SetSilent(true);
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(5, 7)));
+  auto const frames = collector.WaitFor(1);
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(DecodeMbapResponseFrame(frames[0])->second.GetExceptionCode(),
+            ExceptionCode::kGatewayTargetDeviceFailedToRespond);
+}
+
+TEST(RtuGateway, ExpiresQueuedRequestsWhileBusIsBusy) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::ExceptionCode;
+  using supermb::RtuGateway;
+  using supermb::RtuGatewayConfig;
+
+  ResponseCollector collector;
+  RtuGatewayConfig config;
+  config.queue_timeout = std::chrono::milliseconds{20};
+  RtuGateway gateway{config, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  SlaveSerialLine &line = *serial_line;
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  // The first request occupies the bus until it is released; the next two expire in the queue meanwhile and are
+  // answered without waiting for the first
+  line.Hold(true);
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(1, 7)));
+  line.WaitForEntered(1);
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(2, 7)));
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(3, 7)));
+  auto frames = collector.WaitFor(2);
+  ASSERT_EQ(frames.size(), 2U);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    auto const expired = DecodeMbapResponseFrame(frames[i]);
+    EXPECT_EQ(expired->first.transaction_id, 2 + i);
+    EXPECT_EQ(expired->second.GetExceptionCode(), ExceptionCode::kGatewayTargetDeviceFailedToRespond);
+  }
+
+  line.Hold(false);
+  frames = collector.WaitFor(3);
+  ASSERT_EQ(frames.size(), 3U);
+  EXPECT_EQ(DecodeMbapResponseFrame(frames[2])->first.transaction_id, 1);
+
+  // The worker recycles the expired transactions when it dequeues them, before it takes this request
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(4, 7)));
+  frames = collector.WaitFor(4);
+  ASSERT_EQ(frames.size(), 4U);
+  EXPECT_EQ(line.GetTransactionCount(), 2);
+
+  // A transaction is freed just after its response is handed over, so the last one may still be taken; every other
+  // one is usable again, which would not be the case had the two expired transactions leaked
+  line.Hold(true);
+  for (uint16_t i = 0; static_cast<size_t>(i) + 1 < RtuGateway::kLineQueueDepth; ++i) {
+    EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(100 + i, 7)));
+  }
+  line.Hold(false);
+  frames = collector.WaitFor(4 + RtuGateway::kLineQueueDepth - 1);
+  EXPECT_EQ(frames.size(), 4 + RtuGateway::kLineQueueDepth - 1);
+  for (size_t i = 4; i < frames.size(); ++i) {
+    EXPECT_NE(DecodeMbapResponseFrame(frames[i])->second.GetExceptionCode(), ExceptionCode::kGatewayPathUnavailable);
+  }
+}
+
+TEST(RtuGateway, ServesCachedReadsAndInvalidatesOnWrite) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::FunctionCode;
+  using supermb::RtuGateway;
+  using supermb::RtuGatewayConfig;
+
+  ResponseCollector collector;
+  RtuGatewayConfig config;
+  config.read_cache_ranges.push_back({7, FunctionCode::kReadHR, {0, 10}, std::chrono::seconds{60}});
+  RtuGateway gateway{config, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  SlaveSerialLine &line = *serial_line;
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(1, 7, {0, 8})));
+  collector.WaitFor(1);
+  EXPECT_EQ(line.GetTransactionCount(), 1);
+
+  // Sub-range of the cached read, answered without touching the bus
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(2, 7, {2, 3})));
+  auto frames = collector.WaitFor(2);
+  ASSERT_EQ(frames.size(), 2U);
+  EXPECT_EQ(line.GetTransactionCount(), 1);
+  auto const cached = DecodeMbapResponseFrame(frames[1]);
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_EQ(cached->first.transaction_id, 2);
+  EXPECT_EQ(cached->second.GetData().size(), 6U);
+
+  // Write passes through and drops the cached registers
+  EXPECT_TRUE(gateway.Submit(1, MakeWriteFrame(3, 7, 3, 0x55)));
+  collector.WaitFor(3);
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(4, 7, {2, 3})));
+  frames = collector.WaitFor(4);
+  ASSERT_EQ(frames.size(), 4U);
+  EXPECT_EQ(line.GetTransactionCount(), 3);
+  auto const fresh = DecodeMbapResponseFrame(frames[3]);
+  ASSERT_TRUE(fresh.has_value());
+  EXPECT_EQ(fresh->second.GetData()[3], 0x55);
+
+  // Reads outside the configured ranges are never cached
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(5, 7, {9, 2})));
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(6, 7, {9, 2})));
+  collector.WaitFor(6);
+  EXPECT_EQ(line.GetTransactionCount(), 5);
+
+  // A read whose quantity is out of range is never looked up; the slave rejects it
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(7, 7, {0, 0x8000})));
+  frames = collector.WaitFor(7);
+  ASSERT_EQ(frames.size(), 7U);
+  EXPECT_EQ(line.GetTransactionCount(), 6);
+  EXPECT_EQ(DecodeMbapResponseFrame(frames[6])->second.GetExceptionCode(), supermb::ExceptionCode::kIllegalDataValue);
+}
+
+TEST(RtuGateway, CollapsesIdenticalInFlightReads) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuGateway;
+  using supermb::RtuGatewayConfig;
+
+  ResponseCollector collector;
+  RtuGatewayConfig config;
+  config.read_cache_ranges.push_back({7, FunctionCode::kReadHR, {0, 10}, std::chrono::milliseconds{0}});
+  RtuGateway gateway{config, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  SlaveSerialLine &line = *serial_line;
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  line.Hold(true);
+  for (uint16_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(gateway.Submit(i, MakeReadFrame(i, 7)));
+  }
+  line.Hold(false);
+
+  auto const frames = collector.WaitFor(4);
+  ASSERT_EQ(frames.size(), 4U);
+  EXPECT_EQ(line.GetTransactionCount(), 1);
+  std::vector<uint16_t> transaction_ids;
+  for (auto const &frame : frames) {
+    auto const response = DecodeMbapResponseFrame(frame);
+    ASSERT_TRUE(response.has_value());
+    EXPECT_EQ(response->second.GetExceptionCode(), ExceptionCode::kAcknowledge);
+    transaction_ids.push_back(response->first.transaction_id);
+  }
+  std::ranges::sort(transaction_ids);
+  EXPECT_EQ(transaction_ids, (std::vector<uint16_t>{0, 1, 2, 3}));
+}
+
+TEST(RtuGateway, DoesNotJoinReadsQueuedBeforeAWrite) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::FunctionCode;
+  using supermb::RtuGateway;
+  using supermb::RtuGatewayConfig;
+
+  ResponseCollector collector;
+  RtuGatewayConfig config;
+  config.read_cache_ranges.push_back({7, FunctionCode::kReadHR, {0, 10}, std::chrono::milliseconds{0}});
+  RtuGateway gateway{config, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  SlaveSerialLine &line = *serial_line;
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  // The second read was submitted after the write, so it must see the written value rather than share the first read
+  line.Hold(true);
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(1, 7)));
+  EXPECT_TRUE(gateway.Submit(1, MakeWriteFrame(2, 7, 0, 0x2A)));
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(3, 7)));
+  line.Hold(false);
+
+  auto const frames = collector.WaitFor(3);
+  ASSERT_EQ(frames.size(), 3U);
+  EXPECT_EQ(line.GetTransactionCount(), 3);
+  auto const before = DecodeMbapResponseFrame(frames[0]);
+  auto const after = DecodeMbapResponseFrame(frames[2]);
+  ASSERT_TRUE(before.has_value());
+  ASSERT_TRUE(after.has_value());
+  EXPECT_EQ(before->first.transaction_id, 1);
+  EXPECT_EQ(before->second.GetData()[1], 0);
+  EXPECT_EQ(after->first.transaction_id, 3);
+  EXPECT_EQ(after->second.GetData()[1], 0x2A);
+}
+
+TEST(RtuGateway, DoesNotCacheReadsQueuedBeforeAWrite) {
+  using supermb::DecodeMbapResponseFrame;
+  using supermb::FunctionCode;
+  using supermb::RtuGateway;
+  using supermb::RtuGatewayConfig;
+
+  ResponseCollector collector;
+  RtuGatewayConfig config;
+  config.read_cache_ranges.push_back({7, FunctionCode::kReadHR, {0, 10}, std::chrono::seconds{60}});
+  RtuGateway gateway{config, [&collector](RtuGateway::ConnectionId, std::span<uint8_t const> frame) {
+                       collector.Add(frame);
+                     }};
+  auto serial_line = std::make_unique<SlaveSerialLine>(7);
+  SlaveSerialLine &line = *serial_line;
+  gateway.RouteUnit(7, gateway.AddSerialLine(std::move(serial_line)));
+  gateway.Start();
+
+  // The first read completes while the write is still on the bus, with the values from before the write
+  line.Hold(true);
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(1, 7)));
+  line.WaitForEntered(1);
+  EXPECT_TRUE(gateway.Submit(1, MakeWriteFrame(2, 7, 0, 0x2A)));
+  line.Release(1);
+  line.WaitForEntered(2);
+  collector.WaitFor(1);
+
+  // Had the first read been cached, this one would be answered with the old value before the write completes
+  EXPECT_TRUE(gateway.Submit(1, MakeReadFrame(3, 7)));
+  line.Hold(false);
+
+  auto const frames = collector.WaitFor(3);
+  ASSERT_EQ(frames.size(), 3U);
+  EXPECT_EQ(line.GetTransactionCount(), 3);
+  auto const before = DecodeMbapResponseFrame(frames[0]);
+  auto const after = DecodeMbapResponseFrame(frames[2]);
+  ASSERT_TRUE(before.has_value());
+  ASSERT_TRUE(after.has_value());
+  EXPECT_EQ(before->second.GetData()[1], 0);
+  EXPECT_EQ(after->first.transaction_id, 3);
+  EXPECT_EQ(after->second.GetData()[1], 0x2A);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <memory_resource>
+#include <vector>
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/common/modbus_error.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_response.hpp"
+
+TEST(RtuFrame, Crc16) {
+  using supermb::CheckRtuFrameCrc;
+  using supermb::ComputeCrc16;
+
+  std::vector<uint8_t> const frame{0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD};
+  EXPECT_EQ(ComputeCrc16(std::span{frame}.first(6)), 0xCDC5);
+  EXPECT_TRUE(CheckRtuFrameCrc(frame));
+
+  std::vector<uint8_t> corrupted = frame;
+  corrupted[3] = 0x01;
+  EXPECT_FALSE(CheckRtuFrameCrc(corrupted));
+  EXPECT_FALSE(CheckRtuFrameCrc(std::span{frame}.first(3)));
+}
+
+TEST(RtuFrame, RoundTrip) {
+  using supermb::DecodeRtuRequestFrame;
+  using supermb::DecodeRtuResponseFrame;
+  using supermb::EncodeRtuFrame;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+
+  RtuRequest request{{1, FunctionCode::kReadHR}};
+  request.SetAddressSpan({0, 10});
+  std::vector<uint8_t> request_frame;
+  EncodeRtuFrame(request, request_frame);
+  EXPECT_EQ(request_frame, (std::vector<uint8_t>{0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD}));
+
+  auto const decoded_request = DecodeRtuRequestFrame(request_frame);
+  ASSERT_TRUE(decoded_request.has_value());
+  EXPECT_EQ(decoded_request->GetFunctionCode(), FunctionCode::kReadHR);
+  EXPECT_EQ(decoded_request->GetData(), request.GetData());
+
+  RtuResponse response{1, FunctionCode::kReadHR};
+  std::array<uint8_t, 2> const data{0x12, 0x34};
+  response.SetData(data);
+  response.SetExceptionCode(ExceptionCode::kAcknowledge);
+  std::vector<uint8_t> response_frame;
+  EncodeRtuFrame(response, response_frame);
+  ASSERT_EQ(response_frame.size(), 7U);
+  EXPECT_EQ(response_frame[2], 2);
+
+  auto const decoded_response = DecodeRtuResponseFrame(response_frame);
+  ASSERT_TRUE(decoded_response.has_value());
+  EXPECT_EQ(decoded_response->GetData(), response.GetData());
+
+  response_frame.back() ^= 1;
+  EXPECT_FALSE(DecodeRtuResponseFrame(response_frame).has_value());
+}
+
+TEST(RtuFrame, ResponseFrameSize) {
+  using supermb::GetRtuResponseFrameSize;
+
+  std::vector<uint8_t> const read_response{0x01, 0x03, 0x04, 0x00, 0x01, 0x00, 0x02, 0x00, 0x00};
+  EXPECT_FALSE(GetRtuResponseFrameSize(std::span{read_response}.first(2)).has_value());
+  EXPECT_EQ(GetRtuResponseFrameSize(std::span{read_response}.first(3)), 9U);
+
+  std::vector<uint8_t> const write_response{0x01, 0x06};
+  EXPECT_EQ(GetRtuResponseFrameSize(write_response), 8U);
+
+  std::vector<uint8_t> const exception_response{0x01, 0x83};
+  EXPECT_EQ(GetRtuResponseFrameSize(exception_response), 5U);
+
+  std::vector<uint8_t> const fifo_response{0x01, 0x18, 0x00, 0x06};
+  EXPECT_EQ(GetRtuResponseFrameSize(fifo_response), 12U);
+
+  // Diagnostics echo variable-length data
+  std::vector<uint8_t> const diagnostics_response{0x01, 0x08};
+  EXPECT_FALSE(GetRtuResponseFrameSize(diagnostics_response).has_value());
+}
+
+TEST(RtuFrame, RequestFrameSize) {
+  using supermb::GetRtuRequestFrameSize;
+
+  std::vector<uint8_t> const read_request{0x01, 0x03, 0x00, 0x00, 0x00, 0x02};
+  EXPECT_FALSE(GetRtuRequestFrameSize(std::span{read_request}.first(1)).has_value());
+  EXPECT_EQ(GetRtuRequestFrameSize(read_request), 8U);
+
+  std::vector<uint8_t> const write_request{0x01, 0x10, 0x00, 0x00, 0x00, 0x02, 0x04};
+  EXPECT_FALSE(GetRtuRequestFrameSize(std::span{write_request}.first(6)).has_value());
+  EXPECT_EQ(GetRtuRequestFrameSize(write_request), 13U);
+
+  std::vector<uint8_t> const read_write_request{0x01, 0x17, 0, 0, 0, 1, 0, 0, 0, 1, 0x02};
+  EXPECT_EQ(GetRtuRequestFrameSize(read_write_request), 15U);
+
+  std::vector<uint8_t> const diagnostics_request{0x01, 0x08, 0x00, 0x00};
+  EXPECT_FALSE(GetRtuRequestFrameSize(diagnostics_request).has_value());
+  std::vector<uint8_t> const unknown_request{0x01, 0x64, 0x00, 0x00};
+  EXPECT_FALSE(GetRtuRequestFrameSize(unknown_request).has_value());
+}
+
+TEST(RtuFrame, ParseErrors) {
+  using supermb::ComputeCrc16;
+  using supermb::FunctionCode;
+  using supermb::ModbusErrorKind;
+  using supermb::ParseRtuRequestFrame;
+  using supermb::ParseRtuResponseFrame;
+
+  // Rejected frames must not touch the allocator
+  std::pmr::memory_resource *const no_allocation = std::pmr::null_memory_resource();
+
+  std::vector<uint8_t> const frame{0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD};
+  auto const too_short = ParseRtuRequestFrame(std::span{frame}.first(3), no_allocation);
+  ASSERT_FALSE(too_short.has_value());
+  EXPECT_EQ(too_short.error().kind, ModbusErrorKind::kFrameLength);
+
+  std::vector<uint8_t> corrupted = frame;
+  corrupted[3] = 0x01;
+  auto const bad_crc = ParseRtuRequestFrame(corrupted, no_allocation);
+  ASSERT_FALSE(bad_crc.has_value());
+  EXPECT_EQ(bad_crc.error().kind, ModbusErrorKind::kCrc);
+  EXPECT_EQ(bad_crc.error().function_code, FunctionCode::kReadHR);
+
+  // Exception function codes never start a request, and an exception response is exactly one code long
+  std::vector<uint8_t> exception_frame{0x01, 0x83, 0x02, 0x00};
+  uint16_t const crc = ComputeCrc16(std::span{exception_frame}.first(3));
+  exception_frame.back() = static_cast<uint8_t>(crc & 0xFF);
+  exception_frame.push_back(static_cast<uint8_t>(crc >> 8));
+  auto const malformed_request = ParseRtuRequestFrame(exception_frame, no_allocation);
+  ASSERT_FALSE(malformed_request.has_value());
+  EXPECT_EQ(malformed_request.error().kind, ModbusErrorKind::kMalformedPdu);
+  auto const exception_response = ParseRtuResponseFrame(exception_frame, no_allocation);
+  ASSERT_TRUE(exception_response.has_value());
+  EXPECT_EQ(exception_response->GetFunctionCode(), FunctionCode::kReadHR);
+
+  auto const request = ParseRtuRequestFrame(frame);
+  ASSERT_TRUE(request.has_value());
+  EXPECT_EQ(request->GetAddressSpan()->reg_count, 10);
+}
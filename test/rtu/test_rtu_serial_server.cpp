@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/common/realtime.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_response.hpp"
+#include "super_modbus/rtu/rtu_serial_server.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+
+namespace {
+
+// Sends request, written in two parts to exercise reassembly, and waits for the response
+std::optional<supermb::RtuResponse> Transact(int fd, supermb::RtuRequest const &request, int timeout_ms = 1000) {
+  std::vector<uint8_t> frame;
+  supermb::EncodeRtuFrame(request, frame);
+  size_t const split = frame.size() / 2;
+  EXPECT_EQ(write(fd, frame.data(), split), static_cast<ssize_t>(split));
+  EXPECT_EQ(write(fd, frame.data() + split, frame.size() - split), static_cast<ssize_t>(frame.size() - split));
+
+  std::vector<uint8_t> response;
+  pollfd fds{fd, POLLIN, 0};
+  while (poll(&fds, 1, timeout_ms) > 0) {
+    std::array<uint8_t, supermb::kMaxRtuFrameSize> chunk{};
+    ssize_t const received = read(fd, chunk.data(), chunk.size());
+    if (received <= 0) {
+      break;
+    }
+    response.insert(response.end(), chunk.begin(), chunk.begin() + received);
+    auto const size = supermb::GetRtuResponseFrameSize(response);
+    if (size.has_value() && response.size() >= size.value()) {
+      return supermb::DecodeRtuResponseFrame(response);
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+TEST(RtuSerialServer, ServesSlavesAndMeasuresTurnaround) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuSerialServer;
+
+  std::array<int, 2> fds{};
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+  supermb::RtuSlave first{1};
+  first.AddHoldingRegisters({0, 10});
+  supermb::RtuSlave second{2};
+  second.AddHoldingRegisters({0, 10});
+
+  supermb::RtuSerialServerConfig config;
+  config.realtime.prefault_stack = true;
+  RtuSerialServer server{config};
+  size_t const port = server.AddPort(fds[1]);
+  server.AddSlave(port, first);
+  server.AddSlave(port, second);
+  server.Start();
+  EXPECT_TRUE(server.GetRealtimeStatus(port).AllApplied());
+
+  // Garbage ahead of the first request is dropped after the line goes quiet
+  std::array<uint8_t, 3> const garbage{0x01, 0x64, 0x00};
+  ASSERT_EQ(write(fds[0], garbage.data(), garbage.size()), static_cast<ssize_t>(garbage.size()));
+  usleep(100000);
+
+  RtuRequest write{{2, FunctionCode::kWriteSingleReg}};
+  write.SetWriteSingleRegisterData(3, 0x1234);
+  auto const write_response = Transact(fds[0], write);
+  ASSERT_TRUE(write_response.has_value());
+  EXPECT_EQ(write_response->GetExceptionCode(), ExceptionCode::kAcknowledge);
+
+  RtuRequest read{{2, FunctionCode::kReadHR}};
+  read.SetAddressSpan({3, 1});
+  auto const read_response = Transact(fds[0], read);
+  ASSERT_TRUE(read_response.has_value());
+  EXPECT_EQ(read_response->GetData(), (std::pmr::vector<uint8_t>{0x12, 0x34}));
+  EXPECT_EQ(first.SnapshotRegisters().holding_registers[3], 0);
+
+  // Nobody answers for a slave that is not on the port
+  RtuRequest absent{{3, FunctionCode::kReadHR}};
+  absent.SetAddressSpan({3, 1});
+  EXPECT_FALSE(Transact(fds[0], absent, 100).has_value());
+
+  server.Stop();
+  supermb::LatencyHistogram const &turnaround = server.GetTurnaround(port);
+  EXPECT_EQ(turnaround.GetCount(), 2U);
+  EXPECT_GT(turnaround.GetMax(), 0U);
+  close(fds[0]);
+  close(fds[1]);
+}
@@ -1,7 +1,20 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 #include "super_modbus/common/address_span.hpp"
 #include "super_modbus/common/byte_helpers.hpp"
 #include "super_modbus/common/function_code.hpp"
+#include "super_modbus/common/modbus_error.hpp"
+#include "super_modbus/common/write_journal.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
 #include "super_modbus/rtu/rtu_request.hpp"
 #include "super_modbus/rtu/rtu_response.hpp"
 #include "super_modbus/rtu/rtu_slave.hpp"
@@ -74,6 +87,7 @@ TEST(RTUSlave, WriteHoldingRegisters) {
   RtuResponse write_response = rtu_slave.Process(write_request);
 
   EXPECT_EQ(write_response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(write_response.GetData(), write_request.GetData());
 
   RtuRequest read_request{{kSlaveId, FunctionCode::kReadHR}};
   read_request.SetAddressSpan(kAddressSpan);
@@ -85,3 +99,674 @@ TEST(RTUSlave, WriteHoldingRegisters) {
   int16_t reg_value = MakeInt16(read_response.GetData()[1], read_response.GetData()[0]);
   EXPECT_EQ(reg_value, kRegisterValue);
 }
+
+TEST(RTUSlave, WriteMultipleRegisters) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr AddressSpan kAddressSpan{0, 4};
+  std::vector<int16_t> const write_values{7, -8, 9};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters(kAddressSpan);
+
+  RtuRequest write_request{{kSlaveId, FunctionCode::kWriteMultRegs}};
+  EXPECT_TRUE(write_request.SetWriteMultipleRegistersData(1, write_values));
+  RtuResponse write_response = rtu_slave.Process(write_request);
+  EXPECT_EQ(write_response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(write_response.GetData(), (std::pmr::vector<uint8_t>{0x00, 0x01, 0x00, 0x03}));
+
+  // Runs past the last register: rejected without writing anything
+  RtuRequest overflow_request{{kSlaveId, FunctionCode::kWriteMultRegs}};
+  EXPECT_TRUE(overflow_request.SetWriteMultipleRegistersData(2, {1, 2, 3}));
+  EXPECT_EQ(rtu_slave.Process(overflow_request).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+
+  RtuRequest read_request{{kSlaveId, FunctionCode::kReadHR}};
+  read_request.SetAddressSpan(kAddressSpan);
+  auto const data = rtu_slave.Process(read_request).GetData();
+  ASSERT_EQ(data.size(), 8U);
+  EXPECT_EQ(MakeInt16(data[1], data[0]), 0);
+  EXPECT_EQ(MakeInt16(data[3], data[2]), write_values[0]);
+  EXPECT_EQ(MakeInt16(data[5], data[4]), write_values[1]);
+  EXPECT_EQ(MakeInt16(data[7], data[6]), write_values[2]);
+}
+
+TEST(RTUSlave, ReadWriteMultipleRegisters) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr AddressSpan kAddressSpan{0, 10};
+  static constexpr AddressSpan kReadSpan{2, 4};
+  static constexpr uint16_t kWriteAddress{3};
+  std::vector<int16_t> const write_values{11, -22};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters(kAddressSpan);
+
+  RtuRequest request{{kSlaveId, FunctionCode::kReadWriteMultRegs}};
+  EXPECT_TRUE(request.SetReadWriteMultipleRegistersData(kReadSpan, kWriteAddress, write_values));
+  RtuResponse response = rtu_slave.Process(request);
+
+  EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  auto const data = response.GetData();
+  ASSERT_EQ(data.size(), static_cast<uint32_t>(kReadSpan.reg_count * 2));
+  EXPECT_EQ(MakeInt16(data[1], data[0]), 0);
+  EXPECT_EQ(MakeInt16(data[3], data[2]), write_values[0]);
+  EXPECT_EQ(MakeInt16(data[5], data[4]), write_values[1]);
+  EXPECT_EQ(MakeInt16(data[7], data[6]), 0);
+}
+
+TEST(RTUSlave, ReadWriteMultipleRegistersInvalidSpanWritesNothing) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr AddressSpan kAddressSpan{0, 4};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters(kAddressSpan);
+
+  // Write span is valid, read span runs past the end of the map
+  RtuRequest request{{kSlaveId, FunctionCode::kReadWriteMultRegs}};
+  EXPECT_TRUE(request.SetReadWriteMultipleRegistersData({2, 4}, 0, {7}));
+  RtuResponse response = rtu_slave.Process(request);
+  EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+  EXPECT_TRUE(response.GetData().empty());
+
+  RtuRequest read_request{{kSlaveId, FunctionCode::kReadHR}};
+  read_request.SetAddressSpan({0, 1});
+  RtuResponse read_response = rtu_slave.Process(read_request);
+  EXPECT_EQ(MakeInt16(read_response.GetData()[1], read_response.GetData()[0]), 0);
+
+  // Empty write is an illegal quantity
+  RtuRequest empty_write_request{{kSlaveId, FunctionCode::kReadWriteMultRegs}};
+  EXPECT_TRUE(empty_write_request.SetReadWriteMultipleRegistersData({0, 1}, 0, {}));
+  EXPECT_EQ(rtu_slave.Process(empty_write_request).GetExceptionCode(), ExceptionCode::kIllegalDataValue);
+}
+
+TEST(RTUSlave, ReadWriteMultipleRegistersIsAtomicUnderConcurrentWrites) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr AddressSpan kAddressSpan{0, 4};
+  static constexpr int kRoundCount{20000};
+  static constexpr int kWriterCount{3};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters(kAddressSpan);
+
+  // FC 16 writers keep overwriting the block FC 23 writes and reads back; the read must always see FC 23's own write
+  std::atomic<bool> done{false};
+  std::vector<std::thread> writers;
+  for (int writer = 0; writer < kWriterCount; ++writer) {
+    writers.emplace_back([&rtu_slave, &done, writer] {
+      RtuRequest request{{kSlaveId, FunctionCode::kWriteMultRegs}};
+      request.SetWriteMultipleRegistersData(0, std::vector<int16_t>(4, static_cast<int16_t>(writer)));
+      while (!done.load()) {
+        rtu_slave.Process(request);
+      }
+    });
+  }
+
+  bool atomic = true;
+  for (int round = 0; round < kRoundCount && atomic; ++round) {
+    auto const value = static_cast<int16_t>(round + kWriterCount);
+    RtuRequest request{{kSlaveId, FunctionCode::kReadWriteMultRegs}};
+    request.SetReadWriteMultipleRegistersData(kAddressSpan, 0, std::vector<int16_t>(4, value));
+    auto const response = rtu_slave.Process(request);
+    ASSERT_EQ(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+    auto const &data = response.GetData();
+    for (size_t i = 0; i < data.size(); i += 2) {
+      atomic = atomic && MakeInt16(data[i + 1], data[i]) == value;
+    }
+  }
+  done = true;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  EXPECT_TRUE(atomic);
+}
+
+TEST(RTUSlave, MaskWriteRegister) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr AddressSpan kAddressSpan{0, 1};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters(kAddressSpan);
+
+  RtuRequest write_request{{kSlaveId, FunctionCode::kWriteSingleReg}};
+  write_request.SetWriteSingleRegisterData(0, 0x12);
+  rtu_slave.Process(write_request);
+
+  RtuRequest mask_request{{kSlaveId, FunctionCode::kMaskWriteReg}};
+  EXPECT_TRUE(mask_request.SetMaskWriteRegisterData(0, 0xF2, 0x25));
+  RtuResponse mask_response = rtu_slave.Process(mask_request);
+  EXPECT_EQ(mask_response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(mask_response.GetData(), mask_request.GetData());
+
+  RtuRequest read_request{{kSlaveId, FunctionCode::kReadHR}};
+  read_request.SetAddressSpan(kAddressSpan);
+  RtuResponse read_response = rtu_slave.Process(read_request);
+  EXPECT_EQ(MakeInt16(read_response.GetData()[1], read_response.GetData()[0]), 0x17);
+
+  RtuRequest missing_request{{kSlaveId, FunctionCode::kMaskWriteReg}};
+  missing_request.SetMaskWriteRegisterData(1, 0xF2, 0x25);
+  EXPECT_EQ(rtu_slave.Process(missing_request).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+}
+
+TEST(RTUSlave, ConcurrentMaskWriteRegisterKeepsEveryBit) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr int kRoundCount{500};
+  static constexpr int kBitCount{16};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters({0, 1});
+
+  // Each thread toggles its own bit through FC 22 and ends by setting it; a lost update would leave some bit clear
+  std::vector<std::thread> masters;
+  for (int bit = 0; bit < kBitCount; ++bit) {
+    masters.emplace_back([&rtu_slave, bit] {
+      auto const mask = static_cast<uint16_t>(1U << bit);
+      RtuRequest set{{kSlaveId, FunctionCode::kMaskWriteReg}};
+      set.SetMaskWriteRegisterData(0, static_cast<uint16_t>(~mask), mask);
+      RtuRequest clear{{kSlaveId, FunctionCode::kMaskWriteReg}};
+      clear.SetMaskWriteRegisterData(0, static_cast<uint16_t>(~mask), 0);
+      for (int round = 0; round < kRoundCount; ++round) {
+        rtu_slave.Process(set);
+        rtu_slave.Process(clear);
+      }
+      EXPECT_EQ(rtu_slave.Process(set).GetExceptionCode(), ExceptionCode::kAcknowledge);
+    });
+  }
+  for (auto &master : masters) {
+    master.join();
+  }
+
+  RtuRequest read_request{{kSlaveId, FunctionCode::kReadHR}};
+  read_request.SetAddressSpan(AddressSpan{0, 1});
+  auto const read_response = rtu_slave.Process(read_request);
+  auto const &data = read_response.GetData();
+  ASSERT_EQ(data.size(), 2U);
+  EXPECT_EQ(static_cast<uint16_t>(MakeInt16(data[1], data[0])), 0xFFFF);
+}
+
+TEST(RTUSlave, ReadFifoQueue) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr uint16_t kFifoAddress{0x04DE};
+  static constexpr int kPushedCount{40};
+
+  RtuSlave rtu_slave{kSlaveId};
+  auto &fifo_queue = rtu_slave.AddFifoQueue(kFifoAddress);
+
+  // The producer cannot queue more than one read may return, so it can never wedge the queue
+  int accepted_count = 0;
+  for (int16_t i = 0; i < kPushedCount; ++i) {
+    accepted_count += fifo_queue.TryPush(i) ? 1 : 0;
+  }
+  EXPECT_EQ(accepted_count, RtuSlave::kMaxFifoCount);
+
+  RtuRequest request{{kSlaveId, FunctionCode::kReadFIFOQueue}};
+  EXPECT_TRUE(request.SetReadFifoQueueData(kFifoAddress));
+
+  RtuResponse const full_response = rtu_slave.Process(request);
+  EXPECT_EQ(full_response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  auto const &data = full_response.GetData();
+  ASSERT_EQ(data.size(), static_cast<size_t>(2 + RtuSlave::kMaxFifoCount * 2));
+  EXPECT_EQ(MakeInt16(data[1], data[0]), RtuSlave::kMaxFifoCount);
+  EXPECT_EQ(MakeInt16(data[3], data[2]), 0);
+  EXPECT_EQ(MakeInt16(data[63], data[62]), 30);
+
+  RtuResponse const empty_response = rtu_slave.Process(request);
+  EXPECT_EQ(empty_response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(empty_response.GetData().size(), 2U);
+
+  // A drained queue takes values again
+  EXPECT_TRUE(fifo_queue.TryPush(kPushedCount));
+  RtuResponse const refilled_response = rtu_slave.Process(request);
+  ASSERT_EQ(refilled_response.GetData().size(), 4U);
+  EXPECT_EQ(MakeInt16(refilled_response.GetData()[3], refilled_response.GetData()[2]), kPushedCount);
+
+  RtuRequest missing_request{{kSlaveId, FunctionCode::kReadFIFOQueue}};
+  missing_request.SetReadFifoQueueData(kFifoAddress + 1);
+  EXPECT_EQ(rtu_slave.Process(missing_request).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+}
+
+static std::string WriteTempFile(std::string const &name, std::vector<uint8_t> const &bytes) {
+  auto const path = std::filesystem::temp_directory_path() / name;
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  return path.string();
+}
+
+TEST(RTUSlave, ReadFileRecord) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr uint16_t kFileNumber{4};
+
+  // Ten records, record N holds the value 0x0N0N
+  std::vector<uint8_t> file_bytes;
+  for (uint8_t i = 0; i < 10; ++i) {
+    file_bytes.push_back(i);
+    file_bytes.push_back(i);
+  }
+  std::string const path = WriteTempFile("super_modbus_read_file_record.bin", file_bytes);
+
+  RtuSlave rtu_slave{kSlaveId};
+  EXPECT_FALSE(rtu_slave.AddFileRecord(kFileNumber, path + ".missing"));
+  ASSERT_TRUE(rtu_slave.AddFileRecord(kFileNumber, path));
+
+  RtuRequest request{{kSlaveId, FunctionCode::kReadFileRecord}};
+  EXPECT_TRUE(request.SetReadFileRecordData({{kFileNumber, 1, 2}, {kFileNumber, 9, 1}}));
+  RtuResponse response = rtu_slave.Process(request);
+
+  EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  std::pmr::vector<uint8_t> const expected{5, 6, 1, 1, 2, 2, 3, 6, 9, 9};
+  EXPECT_EQ(response.GetData(), expected);
+
+  RtuRequest out_of_range_request{{kSlaveId, FunctionCode::kReadFileRecord}};
+  out_of_range_request.SetReadFileRecordData({{kFileNumber, 1, 2}, {kFileNumber, 9, 2}});
+  RtuResponse out_of_range_response = rtu_slave.Process(out_of_range_request);
+  EXPECT_EQ(out_of_range_response.GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+  EXPECT_TRUE(out_of_range_response.GetData().empty());
+
+  RtuRequest missing_file_request{{kSlaveId, FunctionCode::kReadFileRecord}};
+  missing_file_request.SetReadFileRecordData({{kFileNumber + 1, 0, 1}});
+  EXPECT_EQ(rtu_slave.Process(missing_file_request).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+
+  std::filesystem::remove(path);
+}
+
+TEST(RTUSlave, WriteFileRecord) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+  static constexpr uint16_t kFileNumber{4};
+
+  std::string const path = WriteTempFile("super_modbus_write_file_record.bin", std::vector<uint8_t>(20, 0));
+
+  {
+    RtuSlave rtu_slave{kSlaveId};
+    ASSERT_TRUE(rtu_slave.AddFileRecord(kFileNumber, path));
+
+    RtuRequest write_request{{kSlaveId, FunctionCode::kWriteFileRecord}};
+    EXPECT_TRUE(write_request.SetWriteFileRecordData({{kFileNumber, 7, {0x06AF, 0x04BE, 0x100D}}}));
+    RtuResponse write_response = rtu_slave.Process(write_request);
+    EXPECT_EQ(write_response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+    EXPECT_EQ(write_response.GetData(), write_request.GetData());
+
+    RtuRequest read_request{{kSlaveId, FunctionCode::kReadFileRecord}};
+    read_request.SetReadFileRecordData({{kFileNumber, 7, 3}});
+    std::pmr::vector<uint8_t> const expected{7, 6, 0x06, 0xAF, 0x04, 0xBE, 0x10, 0x0D};
+    EXPECT_EQ(rtu_slave.Process(read_request).GetData(), expected);
+
+    // Second sub-request is out of range, so the first one must not be applied either
+    RtuRequest partial_request{{kSlaveId, FunctionCode::kWriteFileRecord}};
+    partial_request.SetWriteFileRecordData({{kFileNumber, 0, {1}}, {kFileNumber, 9, {1, 2}}});
+    EXPECT_EQ(rtu_slave.Process(partial_request).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+  }
+
+  // Writes land in the file through the shared mapping
+  std::ifstream file{path, std::ios::binary};
+  std::vector<uint8_t> const file_bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  ASSERT_EQ(file_bytes.size(), 20U);
+  EXPECT_EQ(file_bytes[0], 0);
+  EXPECT_EQ(file_bytes[1], 0);
+  EXPECT_EQ(file_bytes[14], 0x06);
+  EXPECT_EQ(file_bytes[19], 0x0D);
+
+  std::filesystem::remove(path);
+}
+
+TEST(RTUSlave, ProcessBatch) {
+  using supermb::BatchResponse;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters({0, 10});
+  rtu_slave.AddInputRegisters({0, 10});
+  RtuSlave reference_slave{kSlaveId};
+  reference_slave.AddHoldingRegisters({0, 10});
+  reference_slave.AddInputRegisters({0, 10});
+
+  std::vector<RtuRequest> requests;
+  auto const add_read = [&requests](FunctionCode function_code, uint16_t start, uint16_t count) {
+    requests.emplace_back(RtuRequest::Header{kSlaveId, function_code}).SetAddressSpan({start, count});
+  };
+  add_read(FunctionCode::kReadHR, 4, 2);
+  add_read(FunctionCode::kReadIR, 0, 3);
+  add_read(FunctionCode::kReadHR, 0, 2);
+  requests.emplace_back(RtuRequest::Header{kSlaveId, FunctionCode::kWriteSingleReg}).SetWriteSingleRegisterData(1, 77);
+  add_read(FunctionCode::kReadHR, 0, 2);
+  add_read(FunctionCode::kReadHR, 8, 4);
+  requests.emplace_back(RtuRequest::Header{kSlaveId, FunctionCode::kReadCoils});
+
+  std::vector<BatchResponse> responses(requests.size());
+  std::pmr::vector<uint8_t> arena;
+  EXPECT_EQ(rtu_slave.ProcessBatch(requests, responses, arena), requests.size());
+
+  // Same results as one request at a time, in request order
+  for (size_t i = 0; i < requests.size(); ++i) {
+    RtuResponse const expected = reference_slave.Process(requests[i]);
+    EXPECT_EQ(responses[i].function_code, expected.GetFunctionCode()) << i;
+    EXPECT_EQ(responses[i].exception_code, expected.GetExceptionCode()) << i;
+    if (expected.GetExceptionCode() == ExceptionCode::kAcknowledge) {
+      EXPECT_TRUE(std::ranges::equal(responses[i].GetData(arena), expected.GetData())) << i;
+    }
+  }
+
+  // The read after the write sees it; the one before does not
+  EXPECT_EQ(MakeInt16(responses[2].GetData(arena)[3], responses[2].GetData(arena)[2]), 0);
+  EXPECT_EQ(MakeInt16(responses[4].GetData(arena)[3], responses[4].GetData(arena)[2]), 77);
+  EXPECT_EQ(responses[5].exception_code, ExceptionCode::kIllegalDataAddress);
+  EXPECT_EQ(responses[6].exception_code, ExceptionCode::kIllegalFunction);
+
+  // Output span shorter than the batch
+  std::vector<BatchResponse> short_responses(2);
+  EXPECT_EQ(rtu_slave.ProcessBatch(requests, short_responses, arena), 2U);
+
+  // An out of range quantity is rejected without reserving room for it
+  std::vector<RtuRequest> oversized_requests;
+  oversized_requests.emplace_back(RtuRequest::Header{kSlaveId, FunctionCode::kReadHR}).SetAddressSpan({0, 0xFFFF});
+  std::pmr::vector<uint8_t> oversized_arena;
+  EXPECT_EQ(rtu_slave.ProcessBatch(oversized_requests, short_responses, oversized_arena), 1U);
+  EXPECT_EQ(short_responses[0].exception_code, ExceptionCode::kIllegalDataValue);
+  EXPECT_LE(oversized_arena.capacity(), 256U);
+}
+
+TEST(RTUSlave, AllocatesFromMemoryResource) {
+  using supermb::DecodeRtuRequestFrame;
+  using supermb::EncodeRtuFrame;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters({0, 10});
+  RtuRequest request{{kSlaveId, FunctionCode::kReadHR}};
+  request.SetAddressSpan({0, 10});
+  std::vector<uint8_t> frame;
+  EncodeRtuFrame(request, frame);
+
+  // Everything below has to come out of the arena: the default resource now refuses to allocate
+  std::array<std::byte, 1024> buffer{};
+  std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+  std::pmr::memory_resource *const previous_default = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  {
+    auto const decoded = DecodeRtuRequestFrame(frame, &arena);
+    ASSERT_TRUE(decoded.has_value());
+    RtuResponse const response = rtu_slave.Process(decoded.value(), &arena);
+    EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+    EXPECT_EQ(response.GetData().size(), 20U);
+    EXPECT_EQ(response.get_allocator().resource(), &arena);
+
+    std::pmr::vector<uint8_t> batch_arena{&arena};
+    std::array<supermb::BatchResponse, 1> batch_responses{};
+    EXPECT_EQ(rtu_slave.ProcessBatch(std::span{&decoded.value(), 1}, batch_responses, batch_arena), 1U);
+    EXPECT_EQ(batch_responses[0].data_size, 20U);
+  }
+  std::pmr::set_default_resource(previous_default);
+}
+
+TEST(RTUSlave, TryProcessErrors) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::ModbusErrorKind;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+
+  static constexpr uint8_t kSlaveId{1};
+
+  RtuSlave rtu_slave{kSlaveId};
+  rtu_slave.AddHoldingRegisters({0, 10});
+  // Error paths must not touch the allocator
+  std::pmr::memory_resource *const no_allocation = std::pmr::null_memory_resource();
+
+  RtuRequest unknown{{kSlaveId, FunctionCode::kReadCoils}};
+  unknown.SetAddressSpan({0, 1});
+  auto const function_error = rtu_slave.TryProcess(unknown, no_allocation);
+  ASSERT_FALSE(function_error.has_value());
+  EXPECT_EQ(function_error.error().kind, ModbusErrorKind::kFunction);
+  EXPECT_EQ(function_error.error().GetExceptionCode(), ExceptionCode::kIllegalFunction);
+
+  RtuRequest too_many{{kSlaveId, FunctionCode::kReadHR}};
+  std::array<uint8_t, 4> const too_many_data{0x00, 0x00, 0x00, 126};
+  too_many.SetRawData(too_many_data);
+  auto const length_error = rtu_slave.TryProcess(too_many, no_allocation);
+  ASSERT_FALSE(length_error.has_value());
+  EXPECT_EQ(length_error.error().kind, ModbusErrorKind::kLength);
+  EXPECT_EQ(length_error.error().GetExceptionCode(), ExceptionCode::kIllegalDataValue);
+
+  RtuRequest out_of_range{{kSlaveId, FunctionCode::kReadHR}};
+  out_of_range.SetAddressSpan({5, 10});
+  auto const address_error = rtu_slave.TryProcess(out_of_range, no_allocation);
+  ASSERT_FALSE(address_error.has_value());
+  EXPECT_EQ(address_error.error().kind, ModbusErrorKind::kAddress);
+  EXPECT_EQ(address_error.error().function_code, FunctionCode::kReadHR);
+  EXPECT_EQ(address_error.error().span.start_address, 5);
+  EXPECT_EQ(address_error.error().span.reg_count, 10);
+  EXPECT_EQ(rtu_slave.Process(out_of_range).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+
+  RtuRequest write{{kSlaveId, FunctionCode::kWriteSingleReg}};
+  write.SetWriteSingleRegisterData(20, 7);
+  auto const write_error = rtu_slave.TryProcess(write, no_allocation);
+  ASSERT_FALSE(write_error.has_value());
+  EXPECT_EQ(write_error.error().span.start_address, 20);
+  EXPECT_EQ(write_error.error().span.reg_count, 1);
+
+  RtuRequest read{{kSlaveId, FunctionCode::kReadHR}};
+  read.SetAddressSpan({0, 10});
+  auto const response = rtu_slave.TryProcess(read);
+  ASSERT_TRUE(response.has_value());
+  EXPECT_EQ(response->GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(response->GetData().size(), 20U);
+}
+
+TEST(RTUSlave, SnapshotRegisters) {
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+
+  RtuSlave rtu_slave{1};
+  rtu_slave.AddHoldingRegisters({0, 10});
+  rtu_slave.AddInputRegisters({0, 2});
+
+  RtuRequest write_request{{1, FunctionCode::kWriteSingleReg}};
+  write_request.SetWriteSingleRegisterData(3, 11);
+  rtu_slave.Process(write_request);
+  auto const snapshot = rtu_slave.SnapshotRegisters();
+
+  write_request.SetWriteSingleRegisterData(3, 22);
+  rtu_slave.Process(write_request);
+
+  EXPECT_EQ(snapshot.holding_registers[3], 11);
+  EXPECT_TRUE(snapshot.input_registers.Contains({0, 2}));
+  EXPECT_EQ(rtu_slave.SnapshotRegisters().holding_registers[3], 22);
+}
+
+TEST(RTUSlave, RegisterHooks) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::MakeInt16;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+
+  RtuSlave rtu_slave{1};
+  rtu_slave.AddHoldingRegisters({0, 10});
+  rtu_slave.AddInputRegisters({0, 10});
+
+  // Writing the command register triggers an action; the status input register is computed on read
+  std::vector<int16_t> commands;
+  rtu_slave.AddHoldingRegisterHooks({5, 1}, {}, [&commands](uint16_t /*address*/, int16_t value) {
+    commands.push_back(value);
+  });
+  rtu_slave.AddInputRegisterHook({2, 1}, [&commands](uint16_t /*address*/, int16_t /*value*/) {
+    return static_cast<int16_t>(commands.size());
+  });
+
+  RtuRequest write_request{{1, FunctionCode::kWriteSingleReg}};
+  write_request.SetWriteSingleRegisterData(5, 42);
+  EXPECT_EQ(rtu_slave.Process(write_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  RtuRequest write_multiple_request{{1, FunctionCode::kWriteMultRegs}};
+  write_multiple_request.SetWriteMultipleRegistersData(4, {1, 43, 2});
+  EXPECT_EQ(rtu_slave.Process(write_multiple_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  RtuRequest mask_request{{1, FunctionCode::kMaskWriteReg}};
+  mask_request.SetMaskWriteRegisterData(5, 0, 0x0F);
+  EXPECT_EQ(rtu_slave.Process(mask_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  // Not hooked
+  write_request.SetWriteSingleRegisterData(6, 1);
+  rtu_slave.Process(write_request);
+  EXPECT_EQ(commands, (std::vector<int16_t>{42, 43, 0x0F}));
+
+  RtuRequest read_request{{1, FunctionCode::kReadIR}};
+  read_request.SetAddressSpan({1, 3});
+  auto const response = rtu_slave.Process(read_request);
+  ASSERT_EQ(response.GetData().size(), 6U);
+  EXPECT_EQ(MakeInt16(response.GetData()[3], response.GetData()[2]), 3);
+  EXPECT_EQ(MakeInt16(response.GetData()[5], response.GetData()[4]), 0);
+}
+
+TEST(RTUSlave, WriteJournal) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::JournaledWrite;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+  using supermb::WriteJournal;
+
+  RtuSlave rtu_slave{1};
+  rtu_slave.AddHoldingRegisters({0, 10});
+  WriteJournal journal{8};
+  rtu_slave.SetWriteJournal(&journal);
+
+  RtuRequest write_request{{1, FunctionCode::kWriteSingleReg}};
+  write_request.SetWriteSingleRegisterData(1, 7);
+  EXPECT_EQ(rtu_slave.Process(write_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  RtuRequest mask_request{{1, FunctionCode::kMaskWriteReg}};
+  mask_request.SetMaskWriteRegisterData(1, 0x00F0, 0x0003);
+  EXPECT_EQ(rtu_slave.Process(mask_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  RtuRequest read_write_request{{1, FunctionCode::kReadWriteMultRegs}};
+  read_write_request.SetReadWriteMultipleRegistersData({0, 2}, 2, {4, 5});
+  EXPECT_EQ(rtu_slave.Process(read_write_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  // Rejected writes are not journaled
+  RtuRequest bad_write_request{{1, FunctionCode::kWriteMultRegs}};
+  bad_write_request.SetWriteMultipleRegistersData(9, {1, 2});
+  EXPECT_EQ(rtu_slave.Process(bad_write_request).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+
+  // 4 of 8 entries used: a 5 register write does not fit and leaves the registers alone
+  RtuRequest full_request{{1, FunctionCode::kWriteMultRegs}};
+  full_request.SetWriteMultipleRegistersData(5, {1, 1, 1, 1, 1});
+  EXPECT_EQ(rtu_slave.Process(full_request).GetExceptionCode(), ExceptionCode::kServerDeviceBusy);
+  EXPECT_EQ(rtu_slave.SnapshotRegisters().holding_registers[5], 0);
+
+  std::array<JournaledWrite, 8> out{};
+  ASSERT_EQ(journal.DrainCoalesced(out), 3U);
+  EXPECT_EQ(out[0].address, 1);
+  EXPECT_EQ(out[0].value, 3);
+  EXPECT_EQ(out[1].address, 2);
+  EXPECT_EQ(out[1].value, 4);
+  EXPECT_EQ(out[2].address, 3);
+  EXPECT_EQ(out[2].value, 5);
+
+  EXPECT_EQ(rtu_slave.Process(full_request).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(journal.Size(), 5U);
+}
+
+TEST(RTUSlave, ConcurrentJournaledWritesMatchRegister) {
+  using supermb::FunctionCode;
+  using supermb::JournaledWrite;
+  using supermb::RtuRequest;
+  using supermb::RtuSlave;
+  using supermb::WriteJournal;
+
+  static constexpr int kThreads{4};
+  static constexpr int kRounds{2000};
+
+  RtuSlave rtu_slave{1};
+  rtu_slave.AddHoldingRegisters({0, 1});
+  WriteJournal journal{kThreads * kRounds};
+  rtu_slave.SetWriteJournal(&journal);
+
+  // Every thread writes its own values to the same register, so the journal's last entry must be the stored value
+  std::vector<std::thread> writers{};
+  for (int thread = 0; thread < kThreads; ++thread) {
+    writers.emplace_back([&rtu_slave, thread] {
+      RtuRequest request{{1, FunctionCode::kWriteSingleReg}};
+      for (int round = 0; round < kRounds; ++round) {
+        request.SetWriteSingleRegisterData(0, static_cast<int16_t>(thread * kRounds + round));
+        rtu_slave.Process(request);
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  std::vector<JournaledWrite> out(journal.GetCapacity());
+  ASSERT_EQ(journal.DrainCoalesced(out), 1U);
+  EXPECT_EQ(out[0].value, rtu_slave.SnapshotRegisters().holding_registers[0]);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <random>
+#include <vector>
+#include "super_modbus/common/address_span.hpp"
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_response.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+#include "super_modbus/rtu/static_rtu_slave.hpp"
+
+namespace {
+
+struct TestLayout {
+  static constexpr supermb::AddressSpan kHoldingRegisters{10, 20};
+  static constexpr supermb::AddressSpan kInputRegisters{100, 4};
+};
+
+using TestSlave = supermb::StaticRtuSlave<TestLayout>;
+
+}  // namespace
+
+TEST(StaticRtuSlave, ReadsAndWrites) {
+  using supermb::ExceptionCode;
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+
+  static_assert(TestSlave::GetOffset(TestSlave::kHoldingRegisters, {12, 3}) == 2U);
+  static_assert(!TestSlave::GetOffset(TestSlave::kHoldingRegisters, {28, 3}).has_value());
+
+  TestSlave slave{1};
+  slave.GetInputRegisters()[1] = 0x1234;
+
+  RtuRequest read{{1, FunctionCode::kReadIR}};
+  read.SetAddressSpan({101, 1});
+  auto response = slave.Process(read);
+  EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(response.GetData(), (std::pmr::vector<uint8_t>{0x12, 0x34}));
+
+  RtuRequest write{{1, FunctionCode::kWriteSingleReg}};
+  write.SetWriteSingleRegisterData(29, -2);
+  EXPECT_EQ(slave.Process(write).GetExceptionCode(), ExceptionCode::kAcknowledge);
+  EXPECT_EQ(slave.GetHoldingRegisters()[19], -2);
+  write.SetWriteSingleRegisterData(30, 1);
+  EXPECT_EQ(slave.Process(write).GetExceptionCode(), ExceptionCode::kIllegalDataAddress);
+
+  EXPECT_EQ(slave.Process(RtuRequest{{1, FunctionCode::kReadFIFOQueue}}).GetExceptionCode(),
+            ExceptionCode::kIllegalFunction);
+}
+
+// Any request gets the same answer from a static slave as from an RtuSlave with the same registers
+TEST(StaticRtuSlave, MatchesRtuSlave) {
+  using supermb::FunctionCode;
+  using supermb::RtuRequest;
+
+  TestSlave static_slave{1};
+  supermb::RtuSlave dynamic_slave{1};
+  dynamic_slave.AddHoldingRegisters(TestLayout::kHoldingRegisters);
+  dynamic_slave.AddInputRegisters(TestLayout::kInputRegisters);
+
+  static constexpr std::array kFunctionCodes{FunctionCode::kReadHR,        FunctionCode::kReadIR,
+                                             FunctionCode::kWriteSingleReg, FunctionCode::kWriteMultRegs,
+                                             FunctionCode::kMaskWriteReg,   FunctionCode::kReadWriteMultRegs,
+                                             FunctionCode::kReadCoils};
+  std::mt19937 generator{4321};
+  std::uniform_int_distribution<size_t> function_distribution{0, kFunctionCodes.size() - 1};
+  // Addresses and quantities land around the ends of the holding range, or of the input range for FC 4
+  std::uniform_int_distribution<int> address_distribution{5, 32};
+  std::uniform_int_distribution<int> quantity_distribution{0, 24};
+  std::uniform_int_distribution<int> byte_distribution{0, 0xFF};
+  std::vector<uint8_t> data;
+  int acknowledged = 0;
+  for (int iteration = 0; iteration < 20000; ++iteration) {
+    FunctionCode const function_code = kFunctionCodes[function_distribution(generator)];
+    auto const append_word = [&data](int word) {
+      data.push_back(static_cast<uint8_t>(word >> 8));
+      data.push_back(static_cast<uint8_t>(word));
+    };
+    auto const append_values = [&](int quantity) {
+      data.push_back(static_cast<uint8_t>(quantity * 2));
+      for (int i = 0; i < quantity * 2; ++i) {
+        data.push_back(static_cast<uint8_t>(byte_distribution(generator)));
+      }
+    };
+
+    data.clear();
+    int const quantity = quantity_distribution(generator);
+    append_word(address_distribution(generator) + (function_code == FunctionCode::kReadIR ? 90 : 0));
+    if (function_code == FunctionCode::kWriteSingleReg || function_code == FunctionCode::kMaskWriteReg) {
+      append_word(byte_distribution(generator));
+    } else {
+      append_word(quantity);
+    }
+    if (function_code == FunctionCode::kWriteMultRegs) {
+      append_values(quantity);
+    } else if (function_code == FunctionCode::kMaskWriteReg) {
+      append_word(byte_distribution(generator));
+    } else if (function_code == FunctionCode::kReadWriteMultRegs) {
+      int const write_quantity = quantity_distribution(generator);
+      append_word(address_distribution(generator));
+      append_word(write_quantity);
+      append_values(write_quantity);
+    }
+    // Some malformed requests too
+    if (byte_distribution(generator) < 0x10) {
+      data.pop_back();
+    }
+
+    RtuRequest request{{1, function_code}};
+    request.SetRawData(data);
+    auto const expected = dynamic_slave.Process(request);
+    auto const actual = static_slave.Process(request);
+    ASSERT_EQ(actual.GetExceptionCode(), expected.GetExceptionCode()) << "iteration " << iteration;
+    ASSERT_EQ(actual.GetData(), expected.GetData()) << "iteration " << iteration;
+    acknowledged += actual.GetExceptionCode() == supermb::ExceptionCode::kAcknowledge ? 1 : 0;
+  }
+  // Plenty of requests must succeed for the comparison to mean anything
+  EXPECT_GT(acknowledged, 4000);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/simulator/device_config.hpp"
+#include "super_modbus/simulator/slave_simulator.hpp"
+
+namespace {
+
+supermb::DeviceConfig MakeConfig(size_t device_count) {
+  supermb::DeviceConfig config;
+  config.profiles.push_back({{{0, 10}, {300, 4}}, {{0, 2}}, {{1, 11}, {301, -5}}, {{1, 7}}});
+  config.profiles.push_back({{{100, 1}}, {}, {}, {}});
+  for (size_t i = 0; i < device_count; ++i) {
+    config.devices.push_back({static_cast<uint8_t>(i % 247 + 1), static_cast<uint16_t>(i % 2)});
+  }
+  return config;
+}
+
+}  // namespace
+
+TEST(DeviceConfig, EncodeDecode) {
+  using supermb::DecodeDeviceConfig;
+  using supermb::DeviceConfig;
+
+  DeviceConfig const config = MakeConfig(3);
+  std::vector<uint8_t> bytes;
+  supermb::EncodeDeviceConfig(config, bytes);
+
+  auto const decoded = DecodeDeviceConfig(bytes);
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(decoded->profiles.size(), 2U);
+  EXPECT_EQ(decoded->profiles[0].holding_registers[1].start_address, 300);
+  EXPECT_EQ(decoded->profiles[0].holding_values[1].value, -5);
+  EXPECT_EQ(decoded->profiles[0].input_values[0].address, 1);
+  EXPECT_TRUE(decoded->profiles[1].input_registers.empty());
+  ASSERT_EQ(decoded->devices.size(), 3U);
+  EXPECT_EQ(decoded->devices[2].slave_id, 3);
+  EXPECT_EQ(decoded->devices[1].profile, 1);
+
+  // Every truncation and trailing data are rejected
+  for (size_t size = 0; size < bytes.size(); ++size) {
+    EXPECT_FALSE(DecodeDeviceConfig(std::span{bytes}.first(size)).has_value());
+  }
+  bytes.push_back(0);
+  EXPECT_FALSE(DecodeDeviceConfig(bytes).has_value());
+
+  // So is a device of a profile that does not exist
+  DeviceConfig bad_profile = MakeConfig(1);
+  bad_profile.devices[0].profile = 2;
+  bytes.clear();
+  supermb::EncodeDeviceConfig(bad_profile, bytes);
+  EXPECT_FALSE(DecodeDeviceConfig(bytes).has_value());
+  EXPECT_FALSE(supermb::BuildSlaves(bad_profile).has_value());
+}
+
+TEST(DeviceConfig, BuildSlaves) {
+  using supermb::AddressSpan;
+
+  auto slaves = supermb::BuildSlaves(MakeConfig(5000), 4);
+  ASSERT_TRUE(slaves.has_value());
+  ASSERT_EQ(slaves->size(), 5000U);
+  EXPECT_EQ((*slaves)[0]->GetId(), 1);
+  EXPECT_EQ((*slaves)[4999]->GetId(), 4999 % 247 + 1);
+
+  auto const first = (*slaves)[0]->SnapshotRegisters();
+  EXPECT_TRUE(first.holding_registers.Contains(AddressSpan{0, 10}));
+  EXPECT_TRUE(first.holding_registers.Contains(AddressSpan{300, 4}));
+  EXPECT_FALSE(first.holding_registers.Contains(AddressSpan{100, 1}));
+  EXPECT_EQ(first.holding_registers[1], 11);
+  EXPECT_EQ(first.holding_registers[301], -5);
+  EXPECT_EQ(first.input_registers[1], 7);
+  EXPECT_TRUE((*slaves)[1]->SnapshotRegisters().holding_registers.Contains(AddressSpan{100, 1}));
+
+  // Devices of the same profile share pages but not values
+  supermb::RtuRequest write{{1, supermb::FunctionCode::kWriteSingleReg}};
+  write.SetWriteSingleRegisterData(1, 42);
+  EXPECT_EQ((*slaves)[0]->Process(write).GetExceptionCode(), supermb::ExceptionCode::kAcknowledge);
+  EXPECT_EQ((*slaves)[0]->SnapshotRegisters().holding_registers[1], 42);
+  EXPECT_EQ((*slaves)[2]->SnapshotRegisters().holding_registers[1], 11);
+
+  supermb::SlaveSimulator simulator{2, false};
+  supermb::RtuSlave const *const added = &simulator.AddSlave(std::move((*slaves)[0]));
+  EXPECT_EQ(added, &simulator.AddSlave(1));
+}
+
+TEST(DeviceConfig, DevicesSharingAProfileServeFromTheirOwnThreads) {
+  using supermb::AddressSpan;
+  using supermb::ExceptionCode;
+
+  static constexpr int kRoundCount{200};
+  static constexpr size_t kDeviceCount{8};
+
+  auto slaves = supermb::BuildSlaves(MakeConfig(kDeviceCount * 2), 2);
+  ASSERT_TRUE(slaves.has_value());
+
+  // Even devices share profile 0's pages; each thread reads them and unshares one on its own device
+  std::atomic<bool> ok{true};
+  std::vector<std::thread> threads;
+  for (size_t device = 0; device < kDeviceCount * 2; device += 2) {
+    threads.emplace_back([&slave = *(*slaves)[device], &ok, device] {
+      supermb::RtuRequest read{{slave.GetId(), supermb::FunctionCode::kReadHR}};
+      read.SetAddressSpan(AddressSpan{300, 4});
+      supermb::RtuRequest write{{slave.GetId(), supermb::FunctionCode::kWriteSingleReg}};
+      write.SetWriteSingleRegisterData(1, static_cast<int16_t>(device));
+      for (int round = 0; round < kRoundCount; ++round) {
+        auto const response = slave.Process(round == kRoundCount / 2 ? write : read);
+        if (response.GetExceptionCode() != ExceptionCode::kAcknowledge) {
+          ok = false;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_TRUE(ok);
+  for (size_t device = 0; device < kDeviceCount * 2; device += 2) {
+    auto const registers = (*slaves)[device]->SnapshotRegisters();
+    EXPECT_EQ(registers.holding_registers[1], static_cast<int16_t>(device));
+    EXPECT_EQ(registers.holding_registers[301], -5);
+  }
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_response.hpp"
+#include "super_modbus/simulator/slave_simulator.hpp"
+
+namespace {
+
+supermb::RtuRequest MakeReadRequest(uint8_t slave_id, uint16_t start, uint16_t length) {
+  supermb::RtuRequest request{{slave_id, supermb::FunctionCode::kReadHR}};
+  request.SetAddressSpan({start, length});
+  return request;
+}
+
+}  // namespace
+
+TEST(SlaveSimulator, RoutesSlavesToShards) {
+  using supermb::SlaveSimulator;
+
+  SlaveSimulator simulator{3, false};
+  EXPECT_EQ(simulator.GetShardCount(), 3);
+  EXPECT_EQ(simulator.GetShard(1), 1);
+  EXPECT_EQ(simulator.GetShard(5), 2);
+  EXPECT_EQ(&simulator.AddSlave(7), &simulator.AddSlave(7));
+}
+
+TEST(SlaveSimulator, ServesClientsFromAllShards) {
+  using supermb::ExceptionCode;
+  using supermb::RtuResponse;
+  using supermb::SlaveSimulator;
+
+  static constexpr int kRequestsPerClient{2000};
+  static constexpr uint8_t kSlaveCount{6};
+
+  SlaveSimulator simulator{2, false};
+  for (uint8_t slave_id = 1; slave_id <= kSlaveCount; ++slave_id) {
+    auto &slave = simulator.AddSlave(slave_id);
+    slave.AddHoldingRegisters({0, 4});
+    supermb::RtuRequest write{{slave_id, supermb::FunctionCode::kWriteSingleReg}};
+    write.SetWriteSingleRegisterData(0, slave_id);
+    slave.Process(write);
+  }
+  std::vector<SlaveSimulator::ClientId> const clients{simulator.AddClient(), simulator.AddClient()};
+  simulator.Start();
+
+  std::vector<int> mismatches(clients.size(), 0);
+  std::vector<std::thread> threads;
+  for (size_t c = 0; c < clients.size(); ++c) {
+    threads.emplace_back([&, c] {
+      int submitted = 0;
+      int completed = 0;
+      auto const on_response = [&](SlaveSimulator::Tag tag, RtuResponse const &response) {
+        auto const slave_id = static_cast<uint8_t>(tag % kSlaveCount + 1);
+        auto const data = response.GetData();
+        if (response.GetSlaveId() != slave_id || response.GetExceptionCode() != ExceptionCode::kAcknowledge ||
+            data.size() != 8 || data[1] != slave_id) {
+          ++mismatches[c];
+        }
+      };
+      while (completed < kRequestsPerClient) {
+        while (submitted < kRequestsPerClient) {
+          auto const slave_id = static_cast<uint8_t>(submitted % kSlaveCount + 1);
+          if (!simulator.Submit(clients[c], submitted, MakeReadRequest(slave_id, 0, 4))) {
+            break;
+          }
+          ++submitted;
+        }
+        size_t const polled = simulator.Poll(clients[c], on_response);
+        completed += static_cast<int>(polled);
+        if (polled == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  simulator.Stop();
+
+  EXPECT_EQ(mismatches[0], 0);
+  EXPECT_EQ(mismatches[1], 0);
+}
+
+TEST(SlaveSimulator, UnknownSlave) {
+  using supermb::ExceptionCode;
+  using supermb::RtuResponse;
+  using supermb::SlaveSimulator;
+
+  SlaveSimulator simulator{2, false};
+  simulator.AddSlave(1).AddHoldingRegisters({0, 4});
+  auto const client = simulator.AddClient();
+  simulator.Start();
+
+  ASSERT_TRUE(simulator.Submit(client, 42, MakeReadRequest(9, 0, 1)));
+  bool answered = false;
+  while (!answered) {
+    simulator.Poll(client, [&](SlaveSimulator::Tag tag, RtuResponse const &response) {
+      EXPECT_EQ(tag, 42);
+      EXPECT_EQ(response.GetSlaveId(), 9);
+      EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kGatewayTargetDeviceFailedToRespond);
+      answered = true;
+    });
+    std::this_thread::yield();
+  }
+}
+
+TEST(SlaveSimulator, DoesNotAllocateOnTheRequestPath) {
+  using supermb::ExceptionCode;
+  using supermb::RtuRequest;
+  using supermb::RtuResponse;
+  using supermb::SlaveSimulator;
+
+  SlaveSimulator simulator{2, false};
+  simulator.AddSlave(1).AddHoldingRegisters({0, 4});
+  auto const client = simulator.AddClient();
+  simulator.Start();
+  RtuRequest const request = MakeReadRequest(1, 0, 4);
+  RtuRequest oversized{{1, supermb::FunctionCode::kWriteMultRegs}};
+  oversized.SetRawData(std::vector<uint8_t>(supermb::kMaxRtuFrameSize, 0));
+
+  // Requests and responses cross threads inside the rings, so the default resource is never needed
+  std::pmr::memory_resource *const previous_default = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  EXPECT_FALSE(simulator.Submit(client, 1, oversized));
+  ASSERT_TRUE(simulator.Submit(client, 2, request));
+  bool answered = false;
+  while (!answered) {
+    simulator.Poll(client, [&](SlaveSimulator::Tag tag, RtuResponse const &response) {
+      EXPECT_EQ(tag, 2);
+      EXPECT_EQ(response.GetExceptionCode(), ExceptionCode::kAcknowledge);
+      EXPECT_EQ(response.GetData().size(), 8U);
+      answered = true;
+    });
+    std::this_thread::yield();
+  }
+  std::pmr::set_default_resource(previous_default);
+}
@@ -0,0 +1,731 @@
+// Load generator for Modbus RTU and TCP servers.
+//
+// Each connection runs on its own thread and keeps up to --depth requests in flight (RTU lines are half duplex, so
+// they always use one connection with depth 1). With --rate the requests follow a fixed schedule and every latency
+// is measured from the time its request was due, not from when it was actually sent: a stalled server then shows up
+// in the percentiles instead of silently slowing the generator down (coordinated omission). Without --rate the
+// generator runs closed loop at full speed and the latencies are plain round trip times.
+//
+// "--tcp self" and "--rtu self" serve an in-process RtuSlave over loopback TCP or a pty, which benchmarks the
+// library itself. "--rtu self" serves through RtuSerialServer and also reports its turnaround (request end to
+// response start) and the jitter of it; --rt-priority, --cpu and --mlock configure the server thread, and
+// --background-load adds busy threads (on the server's core if it is pinned) to show how well that holds up.
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "super_modbus/common/address_span.hpp"
+#include "super_modbus/common/exception_code.hpp"
+#include "super_modbus/common/function_code.hpp"
+#include "super_modbus/common/latency_histogram.hpp"
+#include "super_modbus/common/realtime.hpp"
+#include "super_modbus/rtu/rtu_frame.hpp"
+#include "super_modbus/rtu/rtu_request.hpp"
+#include "super_modbus/rtu/rtu_serial_server.hpp"
+#include "super_modbus/rtu/rtu_slave.hpp"
+#include "super_modbus/tcp/mbap.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using supermb::AddressSpan;
+using supermb::ExceptionCode;
+using supermb::FunctionCode;
+using supermb::LatencyHistogram;
+using supermb::RtuRequest;
+using supermb::RtuResponse;
+
+constexpr char kSelfTarget[]{"self"};
+constexpr size_t kReadChunkSize{4096};
+constexpr int kServerPollMs{50};
+
+enum class Transport : uint8_t {
+  kTcp,
+  kRtu
+};
+
+struct MixEntry {
+  FunctionCode function_code;
+  double weight;
+};
+
+struct Options {
+  Transport transport{Transport::kTcp};
+  std::string target{kSelfTarget};
+  uint8_t unit_id{1};
+  AddressSpan span{0, 10};
+  std::vector<MixEntry> mix{{FunctionCode::kReadHR, 1.0}};
+  size_t connections{1};
+  size_t depth{1};
+  double rate{0.0};
+  std::chrono::seconds duration{10};
+  std::chrono::milliseconds timeout{1000};
+  // In-process RTU server only
+  supermb::RealtimeConfig realtime{};
+  size_t background_load{0};
+};
+
+struct ConnectionStats {
+  LatencyHistogram latencies{};
+  uint64_t sent{0};
+  uint64_t completed{0};
+  uint64_t exceptions{0};
+  uint64_t timeouts{0};
+  uint64_t errors{0};
+};
+
+void PrintUsage() {
+  std::cerr << "usage: super-modbus-loadgen [options]\n"
+               "  --tcp HOST:PORT|self   Modbus TCP target (default: self)\n"
+               "  --rtu PATH|self        Modbus RTU target on a serial device or pty\n"
+               "  --unit ID              slave / unit id (default 1)\n"
+               "  --span START:COUNT     registers to read and write (default 0:10)\n"
+               "  --mix FC:WEIGHT,...    request mix of FC 3, 4, 6 and 16 (default 3:1)\n"
+               "  --connections N        TCP connections (default 1)\n"
+               "  --depth N              requests in flight per TCP connection (default 1)\n"
+               "  --rate N               total requests per second, 0 for closed loop (default 0)\n"
+               "  --duration S           run time in seconds (default 10)\n"
+               "  --timeout MS           response timeout (default 1000)\n"
+               "  --rt-priority N        SCHED_FIFO priority of the --rtu self server thread (default 0: off)\n"
+               "  --cpu N                core to pin the --rtu self server thread to\n"
+               "  --mlock                lock memory and prefault the --rtu self server's stack\n"
+               "  --background-load N    busy threads competing with the --rtu self server (default 0)\n";
+}
+
+template <typename Value>
+std::optional<Value> ParseNumber(std::string_view text) {
+  Value value{};
+  auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc{} || end != text.data() + text.size()) {
+    return {};
+  }
+  return value;
+}
+
+std::optional<std::vector<MixEntry>> ParseMix(std::string_view text) {
+  std::vector<MixEntry> mix;
+  while (!text.empty()) {
+    size_t const comma = text.find(',');
+    std::string_view const item = text.substr(0, comma);
+    text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+
+    size_t const colon = item.find(':');
+    auto const function_code = ParseNumber<int>(item.substr(0, colon));
+    auto const weight = colon == std::string_view::npos ? std::optional<double>{1.0}
+                                                        : ParseNumber<double>(item.substr(colon + 1));
+    if (!function_code.has_value() || !weight.has_value() || weight.value() < 0.0) {
+      return {};
+    }
+    auto const code = static_cast<FunctionCode>(function_code.value());
+    if (code != FunctionCode::kReadHR && code != FunctionCode::kReadIR && code != FunctionCode::kWriteSingleReg &&
+        code != FunctionCode::kWriteMultRegs) {
+      return {};
+    }
+    mix.push_back({code, weight.value()});
+  }
+  if (mix.empty()) {
+    return {};
+  }
+  return mix;
+}
+
+std::optional<Options> ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view const name{argv[i]};
+    if (name == "--mlock") {
+      options.realtime.lock_memory = true;
+      options.realtime.prefault_stack = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return {};
+    }
+    std::string_view const value{argv[++i]};
+
+    bool valid = true;
+    if (name == "--tcp" || name == "--rtu") {
+      options.transport = name == "--tcp" ? Transport::kTcp : Transport::kRtu;
+      options.target = value;
+    } else if (name == "--unit") {
+      auto const unit = ParseNumber<uint8_t>(value);
+      valid = unit.has_value();
+      options.unit_id = unit.value_or(1);
+    } else if (name == "--span") {
+      size_t const colon = value.find(':');
+      auto const start = ParseNumber<uint16_t>(value.substr(0, colon));
+      auto const count = colon == std::string_view::npos ? std::nullopt
+                                                         : ParseNumber<uint16_t>(value.substr(colon + 1));
+      valid = start.has_value() && count.has_value() && count.value() > 0 && count.value() <= 123;
+      options.span = {start.value_or(0), count.value_or(1)};
+    } else if (name == "--mix") {
+      auto mix = ParseMix(value);
+      valid = mix.has_value();
+      if (valid) {
+        options.mix = std::move(mix.value());
+      }
+    } else if (name == "--connections" || name == "--depth") {
+      auto const count = ParseNumber<size_t>(value);
+      valid = count.has_value() && count.value() > 0;
+      (name == "--connections" ? options.connections : options.depth) = count.value_or(1);
+    } else if (name == "--rate") {
+      auto const rate = ParseNumber<double>(value);
+      valid = rate.has_value() && rate.value() >= 0.0;
+      options.rate = rate.value_or(0.0);
+    } else if (name == "--duration") {
+      auto const seconds = ParseNumber<int>(value);
+      valid = seconds.has_value() && seconds.value() > 0;
+      options.duration = std::chrono::seconds{seconds.value_or(1)};
+    } else if (name == "--timeout") {
+      auto const milliseconds = ParseNumber<int>(value);
+      valid = milliseconds.has_value() && milliseconds.value() > 0;
+      options.timeout = std::chrono::milliseconds{milliseconds.value_or(1)};
+    } else if (name == "--rt-priority") {
+      auto const priority = ParseNumber<int>(value);
+      valid = priority.has_value() && priority.value() >= 0 && priority.value() <= 99;
+      options.realtime.fifo_priority = priority.value_or(0);
+    } else if (name == "--cpu") {
+      auto const cpu = ParseNumber<int>(value);
+      valid = cpu.has_value() && cpu.value() >= 0;
+      options.realtime.cpu = cpu.value_or(-1);
+    } else if (name == "--background-load") {
+      auto const threads = ParseNumber<size_t>(value);
+      valid = threads.has_value();
+      options.background_load = threads.value_or(0);
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      return {};
+    }
+  }
+
+  if (options.transport == Transport::kRtu) {
+    options.connections = 1;
+    options.depth = 1;
+  }
+  return options;
+}
+
+bool WriteAll(int fd, std::span<uint8_t const> bytes) {
+  while (!bytes.empty()) {
+    ssize_t const written = write(fd, bytes.data(), bytes.size());
+    if (written < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return false;
+    }
+    bytes = bytes.subspan(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+// Appends whatever is readable to buffer; false once the peer is gone
+bool ReadAvailable(int fd, std::vector<uint8_t> &buffer) {
+  size_t const old_size = buffer.size();
+  buffer.resize(old_size + kReadChunkSize);
+  ssize_t const received = read(fd, buffer.data() + old_size, kReadChunkSize);
+  buffer.resize(old_size + static_cast<size_t>(std::max<ssize_t>(received, 0)));
+  return received > 0 || (received < 0 && (errno == EINTR || errno == EAGAIN));
+}
+
+bool SetRaw(int fd) {
+  termios settings{};
+  if (tcgetattr(fd, &settings) != 0) {
+    return false;
+  }
+  cfmakeraw(&settings);
+  return tcsetattr(fd, TCSANOW, &settings) == 0;
+}
+
+int ConnectTcp(std::string const &target) {
+  size_t const colon = target.rfind(':');
+  auto const port = colon == std::string::npos ? std::nullopt
+                                               : ParseNumber<uint16_t>(std::string_view{target}.substr(colon + 1));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  if (!port.has_value() || inet_pton(AF_INET, target.substr(0, colon).c_str(), &address.sin_addr) != 1) {
+    return -1;
+  }
+  address.sin_port = htons(port.value());
+
+  int const fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  int const enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  if (connect(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int OpenSerial(std::string const &path) {
+  int const fd = open(path.c_str(), O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    return -1;
+  }
+  if (!SetRaw(fd)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// In-process target: one RtuSlave served over loopback TCP or, through RtuSerialServer, the master side of a pty
+class SelfTarget {
+ public:
+  explicit SelfTarget(Options const &options)
+      : slave_(options.unit_id),
+        transport_(options.transport),
+        realtime_(options.realtime) {
+    slave_.AddHoldingRegisters(options.span);
+    slave_.AddInputRegisters(options.span);
+  }
+  SelfTarget(SelfTarget const &) = delete;
+  SelfTarget &operator=(SelfTarget const &) = delete;
+
+  ~SelfTarget() {
+    running_ = false;
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    if (server_) {
+      server_->Stop();
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  // Returns the address clients connect to
+  std::optional<std::string> Start() {
+    if (transport_ == Transport::kRtu) {
+      std::optional<std::string> address = OpenPty();
+      if (address.has_value()) {
+        server_ = std::make_unique<supermb::RtuSerialServer>(supermb::RtuSerialServerConfig{realtime_});
+        server_->AddSlave(server_->AddPort(fd_), slave_);
+        server_->Start();
+      }
+      return address;
+    }
+
+    std::optional<std::string> address = ListenTcp();
+    if (address.has_value()) {
+      running_ = true;
+      thread_ = std::thread{[this] { ServeTcp(); }};
+    }
+    return address;
+  }
+
+  // RTU only, after the run
+  supermb::RtuSerialServer *StopSerialServer() {
+    if (server_) {
+      server_->Stop();
+    }
+    return server_.get();
+  }
+
+ private:
+  std::optional<std::string> ListenTcp() {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0 ||
+        listen(fd_, SOMAXCONN) != 0 || getsockname(fd_, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+      return {};
+    }
+    return "127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+  }
+
+  std::optional<std::string> OpenPty() {
+    fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd_ < 0 || grantpt(fd_) != 0 || unlockpt(fd_) != 0) {
+      return {};
+    }
+    char const *name = ptsname(fd_);
+    if (name == nullptr) {
+      return {};
+    }
+    return std::string{name};
+  }
+
+  void ServeTcp() {
+    std::vector<pollfd> fds{{fd_, POLLIN, 0}};
+    std::unordered_map<int, std::vector<uint8_t>> buffers;
+    std::vector<uint8_t> out;
+    while (running_) {
+      if (poll(fds.data(), fds.size(), kServerPollMs) <= 0) {
+        continue;
+      }
+      for (size_t i = fds.size(); i-- > 1;) {
+        if (fds[i].revents == 0) {
+          continue;
+        }
+        auto &buffer = buffers[fds[i].fd];
+        bool open = ReadAvailable(fds[i].fd, buffer);
+        out.clear();
+        for (auto size = supermb::GetMbapFrameSize(buffer); open && size.has_value() && buffer.size() >= size.value();
+             size = supermb::GetMbapFrameSize(buffer)) {
+          auto const request = supermb::DecodeMbapRequestFrame(std::span{buffer}.first(size.value()));
+          if (request.has_value()) {
+            supermb::EncodeMbapFrame(request->first.transaction_id, slave_.Process(request->second), out);
+          }
+          buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(size.value()));
+        }
+        if (!open || !WriteAll(fds[i].fd, out)) {
+          close(fds[i].fd);
+          buffers.erase(fds[i].fd);
+          fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+      }
+      if ((fds[0].revents & POLLIN) != 0) {
+        int const client = accept(fd_, nullptr, nullptr);
+        if (client >= 0) {
+          int const enable = 1;
+          setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+          fds.push_back({client, POLLIN, 0});
+        }
+      }
+    }
+    for (size_t i = 1; i < fds.size(); ++i) {
+      close(fds[i].fd);
+    }
+  }
+
+  supermb::RtuSlave slave_;
+  Transport transport_;
+  supermb::RealtimeConfig realtime_;
+  std::unique_ptr<supermb::RtuSerialServer> server_{};
+  int fd_{-1};
+  std::atomic<bool> running_{false};
+  std::thread thread_{};
+};
+
+class Connection {
+ public:
+  Connection(Options const &options, size_t index, int fd)
+      : options_(options),
+        fd_(fd),
+        random_(static_cast<uint32_t>(index) * 7919U + 1U) {
+    std::vector<double> weights;
+    for (auto const &entry : options.mix) {
+      weights.push_back(entry.weight);
+    }
+    pick_ = std::discrete_distribution<size_t>{weights.begin(), weights.end()};
+    if (options.rate > 0.0) {
+      interval_ = std::chrono::nanoseconds{
+          static_cast<int64_t>(1e9 * static_cast<double>(options.connections) / options.rate)};
+    }
+  }
+
+  // Runs until deadline, then waits out the requests still in flight
+  void Run(Clock::time_point start, Clock::time_point deadline) {
+    next_due_ = start;
+    while (true) {
+      auto const now = Clock::now();
+      if (now >= deadline && in_flight_.empty()) {
+        break;
+      }
+      if (now < deadline) {
+        SendDue(now);
+      }
+      ExpireTimedOut(now);
+
+      auto wait_until = in_flight_.empty() ? deadline : in_flight_.front().sent_at + options_.timeout;
+      if (interval_.count() > 0 && in_flight_.size() < options_.depth && now < deadline) {
+        wait_until = std::min(wait_until, next_due_);
+      }
+      auto const wait = std::chrono::duration_cast<std::chrono::milliseconds>(wait_until - Clock::now());
+      pollfd fds{fd_, POLLIN, 0};
+      if (poll(&fds, 1, static_cast<int>(std::clamp<int64_t>(wait.count(), 0, 100))) > 0) {
+        if (!ReadAvailable(fd_, buffer_)) {
+          ++stats_.errors;
+          break;
+        }
+        ParseResponses();
+      }
+    }
+    close(fd_);
+  }
+
+  [[nodiscard]] ConnectionStats const &GetStats() const noexcept { return stats_; }
+
+ private:
+  struct InFlight {
+    uint16_t transaction_id;
+    Clock::time_point due;
+    Clock::time_point sent_at;
+  };
+
+  RtuRequest MakeRequest() {
+    FunctionCode const function_code = options_.mix[pick_(random_)].function_code;
+    RtuRequest request{{options_.unit_id, function_code}};
+    AddressSpan const &span = options_.span;
+    switch (function_code) {
+      case FunctionCode::kWriteSingleReg:
+        request.SetWriteSingleRegisterData(span.start_address, static_cast<int16_t>(stats_.sent));
+        break;
+      case FunctionCode::kWriteMultRegs:
+        request.SetWriteMultipleRegistersData(span.start_address,
+                                              std::vector<int16_t>(span.reg_count, static_cast<int16_t>(stats_.sent)));
+        break;
+      default:
+        request.SetAddressSpan(span);
+        break;
+    }
+    return request;
+  }
+
+  void SendDue(Clock::time_point now) {
+    out_.clear();
+    while (in_flight_.size() < options_.depth && (interval_.count() == 0 || next_due_ <= now)) {
+      // Paced requests keep their scheduled time even when sent late, which is what makes stalls visible
+      Clock::time_point const due = interval_.count() == 0 ? now : next_due_;
+      next_due_ += interval_;
+      RtuRequest const request = MakeRequest();
+      if (options_.transport == Transport::kTcp) {
+        supermb::EncodeMbapFrame(next_transaction_id_, request, out_);
+      } else {
+        supermb::EncodeRtuFrame(request, out_);
+      }
+      in_flight_.push_back({next_transaction_id_++, due, now});
+      ++stats_.sent;
+    }
+    if (!out_.empty() && !WriteAll(fd_, out_)) {
+      ++stats_.errors;
+    }
+  }
+
+  void ExpireTimedOut(Clock::time_point now) {
+    while (!in_flight_.empty() && now - in_flight_.front().sent_at >= options_.timeout) {
+      // Recorded with the time it waited, at least the timeout, so timeouts count among the slowest latencies
+      // instead of dropping out of the percentiles
+      auto const latency = std::chrono::duration_cast<std::chrono::nanoseconds>(now - in_flight_.front().due);
+      stats_.latencies.Record(static_cast<uint64_t>(latency.count()));
+      in_flight_.pop_front();
+      ++stats_.timeouts;
+      // A late RTU response would be taken for the next one
+      if (options_.transport == Transport::kRtu) {
+        buffer_.clear();
+      }
+    }
+  }
+
+  void Complete(uint16_t transaction_id, ExceptionCode exception_code) {
+    auto const match = std::ranges::find(in_flight_, transaction_id, &InFlight::transaction_id);
+    if (match == in_flight_.end()) {
+      ++stats_.errors;
+      return;
+    }
+    auto const latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - match->due);
+    stats_.latencies.Record(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)));
+    ++stats_.completed;
+    if (exception_code != ExceptionCode::kAcknowledge) {
+      ++stats_.exceptions;
+    }
+    in_flight_.erase(match);
+  }
+
+  void ParseResponses() {
+    size_t consumed = 0;
+    while (consumed < buffer_.size()) {
+      auto const bytes = std::span{buffer_}.subspan(consumed);
+      if (options_.transport == Transport::kTcp) {
+        auto const size = supermb::GetMbapFrameSize(bytes);
+        if (!size.has_value() || bytes.size() < size.value()) {
+          break;
+        }
+        auto const response = supermb::DecodeMbapResponseFrame(bytes.first(size.value()));
+        if (response.has_value()) {
+          Complete(response->first.transaction_id, response->second.GetExceptionCode());
+        } else {
+          ++stats_.errors;
+        }
+        consumed += size.value();
+      } else {
+        auto const size = supermb::GetRtuResponseFrameSize(bytes);
+        // A frame that cannot be sized by a full frame's worth of bytes is garbage; drop the buffer to resync
+        if (!size.has_value() && bytes.size() >= supermb::kMaxRtuFrameSize) {
+          ++stats_.errors;
+          consumed = buffer_.size();
+          break;
+        }
+        if (!size.has_value() || bytes.size() < size.value()) {
+          break;
+        }
+        auto const response = supermb::DecodeRtuResponseFrame(bytes.first(size.value()));
+        if (response.has_value() && !in_flight_.empty()) {
+          Complete(in_flight_.front().transaction_id, response->GetExceptionCode());
+        } else {
+          ++stats_.errors;
+        }
+        consumed += size.value();
+      }
+    }
+    buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(consumed));
+  }
+
+  Options const &options_;
+  int fd_;
+  std::mt19937 random_;
+  std::discrete_distribution<size_t> pick_{};
+  std::chrono::nanoseconds interval_{0};
+  Clock::time_point next_due_{};
+  uint16_t next_transaction_id_{0};
+  std::deque<InFlight> in_flight_{};
+  std::vector<uint8_t> buffer_{};
+  std::vector<uint8_t> out_{};
+  ConnectionStats stats_{};
+};
+
+// Busy threads until stop is set, pinned to cpu unless it is negative
+std::vector<std::thread> StartBackgroundLoad(size_t thread_count, int cpu, std::atomic<bool> const &stop) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([cpu, &stop] {
+      supermb::RealtimeConfig pinned{};
+      pinned.cpu = cpu;
+      supermb::ApplyRealtimeConfig(pinned);
+      volatile uint64_t spins = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        spins = spins + 1;
+      }
+    });
+  }
+  return threads;
+}
+
+void PrintServerReport(Options const &options, supermb::RtuSerialServer const &server) {
+  auto const micros = [](uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1000.0; };
+  supermb::RealtimeStatus const status = server.GetRealtimeStatus(0);
+  LatencyHistogram const &turnaround = server.GetTurnaround(0);
+  auto const describe = [](bool requested, bool applied, std::string const &value) {
+    return !requested ? std::string{"off"} : (applied ? value : std::string{"FAILED"});
+  };
+  std::string const scheduling = describe(options.realtime.fifo_priority > 0, status.scheduling,
+                                          "SCHED_FIFO " + std::to_string(options.realtime.fifo_priority));
+  std::string const affinity = describe(options.realtime.cpu >= 0, status.affinity,
+                                        "cpu " + std::to_string(options.realtime.cpu));
+  std::string const memory_lock = describe(options.realtime.lock_memory, status.memory_locked, "locked");
+  std::printf("server         scheduling %s, pinning %s, memory %s, %zu background thread(s)\n", scheduling.c_str(),
+              affinity.c_str(), memory_lock.c_str(), options.background_load);
+  std::printf("turnaround (us) min %.1f  p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  jitter (p99.9 - p50) %.1f\n",
+              micros(turnaround.GetMin()), micros(turnaround.GetValueAtPercentile(50.0)),
+              micros(turnaround.GetValueAtPercentile(99.0)), micros(turnaround.GetValueAtPercentile(99.9)),
+              micros(turnaround.GetMax()),
+              micros(turnaround.GetValueAtPercentile(99.9) - turnaround.GetValueAtPercentile(50.0)));
+}
+
+void PrintReport(Options const &options, ConnectionStats const &total, std::chrono::duration<double> elapsed) {
+  auto const micros = [](uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1000.0; };
+  LatencyHistogram const &latencies = total.latencies;
+  std::printf("transport      %s, %zu connection(s), depth %zu, %s\n",
+              options.transport == Transport::kTcp ? "tcp" : "rtu", options.connections, options.depth,
+              options.rate > 0.0 ? "paced (latency from scheduled send time)" : "closed loop (uncorrected)");
+  std::printf("requests       %llu sent, %llu completed, %llu exceptions, %llu timeouts, %llu errors\n",
+              static_cast<unsigned long long>(total.sent), static_cast<unsigned long long>(total.completed),
+              static_cast<unsigned long long>(total.exceptions), static_cast<unsigned long long>(total.timeouts),
+              static_cast<unsigned long long>(total.errors));
+  std::printf("throughput     %.1f req/s over %.2f s\n", static_cast<double>(total.completed) / elapsed.count(),
+              elapsed.count());
+  std::printf("latency (us)   min %.1f  mean %.1f  p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+              micros(latencies.GetMin()), latencies.GetMean() / 1000.0, micros(latencies.GetValueAtPercentile(50.0)),
+              micros(latencies.GetValueAtPercentile(99.0)), micros(latencies.GetValueAtPercentile(99.9)),
+              micros(latencies.GetMax()));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  auto maybe_options = ParseOptions(argc, argv);
+  if (!maybe_options.has_value()) {
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+  Options &options = maybe_options.value();
+
+  std::optional<SelfTarget> self_target;
+  if (options.target == kSelfTarget) {
+    self_target.emplace(options);
+    auto address = self_target->Start();
+    if (!address.has_value()) {
+      std::cerr << "failed to start the in-process target\n";
+      return EXIT_FAILURE;
+    }
+    options.target = std::move(address.value());
+  }
+
+  std::vector<std::unique_ptr<Connection>> connections;
+  for (size_t i = 0; i < options.connections; ++i) {
+    int const fd = options.transport == Transport::kTcp ? ConnectTcp(options.target) : OpenSerial(options.target);
+    if (fd < 0) {
+      std::cerr << "failed to open " << options.target << '\n';
+      return EXIT_FAILURE;
+    }
+    connections.emplace_back(std::make_unique<Connection>(options, i, fd));
+  }
+
+  std::atomic<bool> stop_load{false};
+  std::vector<std::thread> load_threads = StartBackgroundLoad(options.background_load, options.realtime.cpu, stop_load);
+
+  auto const start = Clock::now();
+  auto const deadline = start + options.duration;
+  std::vector<std::thread> threads;
+  for (auto &connection : connections) {
+    threads.emplace_back([&connection, start, deadline] { connection->Run(start, deadline); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> const elapsed = Clock::now() - start;
+  stop_load = true;
+  for (auto &thread : load_threads) {
+    thread.join();
+  }
+
+  ConnectionStats total;
+  for (auto const &connection : connections) {
+    ConnectionStats const &stats = connection->GetStats();
+    total.latencies.Merge(stats.latencies);
+    total.sent += stats.sent;
+    total.completed += stats.completed;
+    total.exceptions += stats.exceptions;
+    total.timeouts += stats.timeouts;
+    total.errors += stats.errors;
+  }
+  PrintReport(options, total, elapsed);
+  if (self_target.has_value() && options.transport == Transport::kRtu) {
+    PrintServerReport(options, *self_target->StopSerialServer());
+  }
+  return total.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}